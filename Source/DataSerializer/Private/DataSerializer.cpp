@@ -2,6 +2,8 @@
 
 #include "DataSerializer.h"
 
+#include "Utils/DataSerializerAsync.h"
+
 #define LOCTEXT_NAMESPACE "FDataSerializerModule"
 
 void FDataSerializerModule::StartupModule()
@@ -13,6 +15,9 @@ void FDataSerializerModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+
+	// Don't leave half written saves behind
+	FDataSerializerAsyncIO::Flush();
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -0,0 +1,50 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Libs/DataSerializerArrays.h"
+
+namespace Serializer
+{
+	void WriteTransformArrayData(FArchive& InWriter, const TArray<FTransform>& InArray)
+	{
+		TArray<double> staging;
+		staging.SetNumUninitialized(InArray.Num() * TransformArrayStride);
+		double* data = staging.GetData();
+		for (const FTransform& transform : InArray)
+		{
+			const FQuat rotation = transform.GetRotation();
+			const FVector translation = transform.GetTranslation();
+			const FVector scale = transform.GetScale3D();
+			*data++ = rotation.X;
+			*data++ = rotation.Y;
+			*data++ = rotation.Z;
+			*data++ = rotation.W;
+			*data++ = translation.X;
+			*data++ = translation.Y;
+			*data++ = translation.Z;
+			*data++ = scale.X;
+			*data++ = scale.Y;
+			*data++ = scale.Z;
+		}
+		WriteArrayData(InWriter, staging);
+	}
+
+	bool ReadTransformArrayData(FArchive& InReader, TArray<FTransform>& OutArray, int32 InNum)
+	{
+		TArray<double> staging;
+		if (!ReadArrayData(InReader, staging, InNum * TransformArrayStride))
+			return false;
+
+		TArray<FTransform> result;
+		result.Reserve(InNum);
+		const double* data = staging.GetData();
+		for (int32 i = 0; i < InNum; ++i, data += TransformArrayStride)
+		{
+			result.Emplace(FQuat(data[0], data[1], data[2], data[3]), FVector(data[4], data[5], data[6]),
+			               FVector(data[7], data[8], data[9]));
+		}
+
+		OutArray = MoveTemp(result);
+		return true;
+	}
+}
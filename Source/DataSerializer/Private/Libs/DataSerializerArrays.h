@@ -0,0 +1,66 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace Serializer
+{
+	/** Doubles written per transform: rotation, translation, scale (same layout as FArchive << FTransform). */
+	constexpr int32 TransformArrayStride = 10;
+
+	/**
+	 * Writes the elements of an array of plain values in one bulk copy.
+	 * Falls back to one archive call per element when the archive swaps bytes.
+	 */
+	template <typename T>
+	void WriteArrayData(FArchive& InWriter, const TArray<T>& InArray)
+	{
+		static_assert(TIsPODType<T>::Value, "Bulk array serialization needs a plain type");
+		if (!InWriter.IsByteSwapping())
+		{
+			InWriter.Serialize(const_cast<T*>(InArray.GetData()), InArray.Num() * sizeof(T));
+			return;
+		}
+
+		for (T element : InArray)
+		{
+			InWriter << element;
+		}
+	}
+
+	/**
+	 * Reads InNum elements written by WriteArrayData into a presized array.
+	 * @return false if the archive ran out of data.
+	 */
+	template <typename T>
+	bool ReadArrayData(FArchive& InReader, TArray<T>& OutArray, int32 InNum)
+	{
+		static_assert(TIsPODType<T>::Value, "Bulk array serialization needs a plain type");
+		TArray<T> result;
+		result.SetNumUninitialized(InNum);
+		if (!InReader.IsByteSwapping())
+		{
+			InReader.Serialize(result.GetData(), InNum * sizeof(T));
+		}
+		else
+		{
+			for (T& element : result)
+			{
+				InReader << element;
+			}
+		}
+
+		if (InReader.IsError())
+			return false;
+
+		OutArray = MoveTemp(result);
+		return true;
+	}
+
+	/** Writes transforms through a staging buffer of doubles, FTransform itself is padded and vectorized. */
+	void WriteTransformArrayData(FArchive& InWriter, const TArray<FTransform>& InArray);
+
+	/** Reads InNum transforms written by WriteTransformArrayData. */
+	bool ReadTransformArrayData(FArchive& InReader, TArray<FTransform>& OutArray, int32 InNum);
+}
@@ -0,0 +1,41 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Libs/DataSerializerCompression.h"
+
+namespace Serializer
+{
+	/**
+	 * Gets the size of the buffer needed to compress a block.
+	 * @param InCodec Codec used to compress.
+	 * @param InUncompressedSize Size of the uncompressed block.
+	 * @return Worst case compressed size.
+	 */
+	int32 CompressBound(EDataSerializerCodec InCodec, int32 InUncompressedSize);
+
+	/**
+	 * Compresses a block of memory.
+	 * @param InSettings Codec and level.
+	 * @param OutCompressed Destination buffer, at least CompressBound() bytes.
+	 * @param InOutCompressedSize Size of the destination buffer in, compressed size out.
+	 * @param InUncompressed Source data.
+	 * @param InUncompressedSize Size of the source data.
+	 * @return true on success.
+	 */
+	bool CompressBlock(const FDataSerializerCompressionSettings& InSettings, uint8* OutCompressed,
+	                   int32& InOutCompressedSize, const uint8* InUncompressed, int32 InUncompressedSize);
+
+	/**
+	 * Decompresses a block of memory.
+	 * @param InCodec Codec the block was compressed with.
+	 * @param OutUncompressed Destination buffer.
+	 * @param InUncompressedSize Exact size of the uncompressed block.
+	 * @param InCompressed Compressed data.
+	 * @param InCompressedSize Size of the compressed data.
+	 * @return true on success.
+	 */
+	bool DecompressBlock(EDataSerializerCodec InCodec, uint8* OutUncompressed, int32 InUncompressedSize,
+	                     const uint8* InCompressed, int32 InCompressedSize);
+}
@@ -0,0 +1,162 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Libs/DataSerializerCompression.h"
+
+#include "Compression/OodleDataCompression.h"
+#include "Libs/DataSerializerCodecs.h"
+#include "Libs/DataSerializerStats.h"
+#include "Misc/Compression.h"
+
+namespace Serializer
+{
+	FName GetCodecFormatName(EDataSerializerCodec InCodec)
+	{
+		switch (InCodec)
+		{
+		case EDataSerializerCodec::Zlib:
+			return NAME_Zlib;
+		case EDataSerializerCodec::Gzip:
+			return NAME_Gzip;
+		case EDataSerializerCodec::LZ4:
+			return NAME_LZ4;
+		default:
+			return NAME_None;
+		}
+	}
+
+	ECompressionFlags GetCompressionFlags(EDataSerializerCompressionLevel InLevel)
+	{
+		switch (InLevel)
+		{
+		case EDataSerializerCompressionLevel::Fastest:
+		case EDataSerializerCompressionLevel::Fast:
+			return COMPRESS_BiasSpeed;
+		case EDataSerializerCompressionLevel::Optimal:
+		case EDataSerializerCompressionLevel::Max:
+			return COMPRESS_BiasSize;
+		default:
+			return COMPRESS_NoFlags;
+		}
+	}
+
+	void GetOodleParameters(EDataSerializerCompressionLevel InLevel,
+	                        FOodleDataCompression::ECompressor& OutCompressor,
+	                        FOodleDataCompression::ECompressionLevel& OutLevel)
+	{
+		switch (InLevel)
+		{
+		case EDataSerializerCompressionLevel::Fastest:
+			OutCompressor = FOodleDataCompression::ECompressor::Mermaid;
+			OutLevel = FOodleDataCompression::ECompressionLevel::SuperFast;
+			break;
+		case EDataSerializerCompressionLevel::Fast:
+			OutCompressor = FOodleDataCompression::ECompressor::Kraken;
+			OutLevel = FOodleDataCompression::ECompressionLevel::VeryFast;
+			break;
+		case EDataSerializerCompressionLevel::Optimal:
+			OutCompressor = FOodleDataCompression::ECompressor::Kraken;
+			OutLevel = FOodleDataCompression::ECompressionLevel::Optimal2;
+			break;
+		case EDataSerializerCompressionLevel::Max:
+			OutCompressor = FOodleDataCompression::ECompressor::Leviathan;
+			OutLevel = FOodleDataCompression::ECompressionLevel::Optimal4;
+			break;
+		default:
+			OutCompressor = FOodleDataCompression::ECompressor::Kraken;
+			OutLevel = FOodleDataCompression::ECompressionLevel::Normal;
+			break;
+		}
+	}
+
+	int32 CompressBound(EDataSerializerCodec InCodec, int32 InUncompressedSize)
+	{
+		switch (InCodec)
+		{
+		case EDataSerializerCodec::None:
+			return InUncompressedSize;
+		case EDataSerializerCodec::Oodle:
+			return static_cast<int32>(FOodleDataCompression::CompressedBufferSizeNeeded(InUncompressedSize));
+		default:
+			return FCompression::CompressMemoryBound(GetCodecFormatName(InCodec), InUncompressedSize);
+		}
+	}
+
+	bool CompressBlock(const FDataSerializerCompressionSettings& InSettings, uint8* OutCompressed,
+	                   int32& InOutCompressedSize, const uint8* InUncompressed, int32 InUncompressedSize)
+	{
+		DATASERIALIZER_SCOPE(STAT_DataSerializer_Compress);
+		switch (InSettings.Codec)
+		{
+		case EDataSerializerCodec::None:
+			if (InOutCompressedSize < InUncompressedSize)
+				return false;
+			FMemory::Memcpy(OutCompressed, InUncompressed, InUncompressedSize);
+			InOutCompressedSize = InUncompressedSize;
+			return true;
+		case EDataSerializerCodec::Oodle:
+			{
+				FOodleDataCompression::ECompressor compressor;
+				FOodleDataCompression::ECompressionLevel level;
+				GetOodleParameters(InSettings.Level, compressor, level);
+				const int64 compressedSize = FOodleDataCompression::Compress(OutCompressed, InOutCompressedSize,
+				                                                             InUncompressed, InUncompressedSize,
+				                                                             compressor, level);
+				if (compressedSize <= 0)
+					return false;
+				InOutCompressedSize = static_cast<int32>(compressedSize);
+				return true;
+			}
+		default:
+			return FCompression::CompressMemory(GetCodecFormatName(InSettings.Codec), OutCompressed, InOutCompressedSize,
+			                                    InUncompressed, InUncompressedSize,
+			                                    GetCompressionFlags(InSettings.Level));
+		}
+	}
+
+	bool DecompressBlock(EDataSerializerCodec InCodec, uint8* OutUncompressed, int32 InUncompressedSize,
+	                     const uint8* InCompressed, int32 InCompressedSize)
+	{
+		DATASERIALIZER_SCOPE(STAT_DataSerializer_Decompress);
+		switch (InCodec)
+		{
+		case EDataSerializerCodec::None:
+			if (InCompressedSize != InUncompressedSize)
+				return false;
+			FMemory::Memcpy(OutUncompressed, InCompressed, InUncompressedSize);
+			return true;
+		case EDataSerializerCodec::Oodle:
+			return FOodleDataCompression::Decompress(OutUncompressed, InUncompressedSize, InCompressed, InCompressedSize);
+		default:
+			return FCompression::UncompressMemory(GetCodecFormatName(InCodec), OutUncompressed, InUncompressedSize,
+			                                      InCompressed, InCompressedSize);
+		}
+	}
+}
+
+FDataSerializerCompressionSettings::FDataSerializerCompressionSettings(EDataSerializerCodec InCodec,
+                                                                       EDataSerializerCompressionLevel InLevel) :
+	Codec(InCodec),
+	Level(InLevel)
+{
+}
+
+bool FDataSerializerFileHeader::IsValid() const
+{
+	return Magic == XEUS_SAVEGAME_FILE_TYPE_TAG
+		&& Version == CurrentVersion
+		&& Codec <= EDataSerializerCodec::Oodle
+		&& ChunkSize > 0 && ChunkSize <= MaxChunkSize
+		&& UncompressedSize >= 0;
+}
+
+FArchive& operator<<(FArchive& Ar, FDataSerializerFileHeader& Header)
+{
+	Ar << Header.Magic;
+	Ar << Header.Version;
+	Ar << Header.Codec;
+	Ar << Header.Level;
+	Ar << Header.ChunkSize;
+	Ar << Header.UncompressedSize;
+	return Ar;
+}
@@ -0,0 +1,50 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Libs/DataSerializerFiles.h"
+
+#include "HAL/FileManager.h"
+
+namespace Serializer
+{
+	bool HasFileHeader(const FString& InPath, uint32 InTag, uint8 InVersion)
+	{
+		TUniquePtr<FArchive> file(IFileManager::Get().CreateFileReader(*InPath, FILEREAD_AllowWrite | FILEREAD_Silent));
+		if (!file.IsValid() || file->TotalSize() < static_cast<int64>(sizeof(uint32) + sizeof(uint8)))
+			return false;
+
+		uint32 tag = 0;
+		uint8 version = 0;
+		*file << tag;
+		*file << version;
+		return !file->IsError() && tag == InTag && version == InVersion;
+	}
+
+	EFileReplaceResult ReplaceFile(const FString& InPath, const FString& InTempPath)
+	{
+		IFileManager& fileManager = IFileManager::Get();
+		if (fileManager.Move(*InPath, *InTempPath, true))
+			return EFileReplaceResult::Replaced;
+
+		if (!fileManager.FileExists(*InPath))
+			return EFileReplaceResult::Interrupted;
+
+		fileManager.Delete(*InTempPath);
+		return EFileReplaceResult::Kept;
+	}
+
+	bool RecoverReplacedFile(const FString& InPath, const FString& InTempPath, uint32 InTag, uint8 InVersion)
+	{
+		IFileManager& fileManager = IFileManager::Get();
+		if (!fileManager.FileExists(*InTempPath))
+			return true;
+
+		// The copy is complete before it replaces the file, a missing or damaged file means the move was interrupted
+		if (fileManager.FileExists(*InPath) && HasFileHeader(InPath, InTag, InVersion))
+		{
+			fileManager.Delete(*InTempPath);
+			return true;
+		}
+		return HasFileHeader(InTempPath, InTag, InVersion) && fileManager.Move(*InPath, *InTempPath, true);
+	}
+}
@@ -0,0 +1,50 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace Serializer
+{
+	/** Outcome of ReplaceFile. */
+	enum class EFileReplaceResult : uint8
+	{
+		/** The copy is the file now. */
+		Replaced,
+
+		/** The move failed, the file is untouched and the copy has been deleted. */
+		Kept,
+
+		/** The file was deleted but the copy not moved, it must not be reopened before RecoverReplacedFile. */
+		Interrupted
+	};
+
+	/**
+	 * Tells if a file starts with a tag and a version byte.
+	 * @param InPath The path to the file.
+	 * @param InTag The expected tag.
+	 * @param InVersion The expected version.
+	 * @return true if the file exists and starts with both.
+	 */
+	bool HasFileHeader(const FString& InPath, uint32 InTag, uint8 InVersion);
+
+	/**
+	 * Replaces a file with a complete rewritten copy of it (compaction, repack).
+	 * Moving is not atomic: the file is deleted first, then the copy is renamed.
+	 * @param InPath The path to the file.
+	 * @param InTempPath The path to the copy.
+	 * @return What happened to both files.
+	 */
+	EFileReplaceResult ReplaceFile(const FString& InPath, const FString& InTempPath);
+
+	/**
+	 * Finishes a ReplaceFile interrupted by a crash, before the file is opened.
+	 * If the file is gone or has no valid header the copy becomes the file, otherwise the copy is dropped.
+	 * @param InPath The path to the file.
+	 * @param InTempPath The path to the copy.
+	 * @param InTag The tag both files start with.
+	 * @param InVersion The version byte following the tag.
+	 * @return false if the file is damaged and the copy cannot replace it.
+	 */
+	bool RecoverReplacedFile(const FString& InPath, const FString& InTempPath, uint32 InTag, uint8 InVersion);
+}
@@ -3,10 +3,484 @@
 
 #include "Libs/DataSerializerLib.h"
 
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "Libs/DataSerializerCodecs.h"
+#include "Libs/DataSerializerObjectData.h"
+#include "Libs/DataSerializerObjectGraph.h"
+#include "Libs/DataSerializerSchema.h"
+#include "Libs/DataSerializerStats.h"
 #include "Math/BigInt.h"
+#include "Memory/MemoryView.h"
 #include "Serialization/ArchiveLoadCompressedProxy.h"
-#include "Serialization/ArchiveSaveCompressedProxy.h"
-#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+#include "Utils/DataSerializerContainer.h"
+#include "Utils/DataSerializerMappedFile.h"
+#include "Utils/DataSerializerObjectIndex.h"
+#include "Utils/DataSerializerObjectPool.h"
+#include "Utils/DataSerializerStreamingReader.h"
+
+#include <atomic>
+
+namespace Serializer
+{
+	/** First bytes of files written through FArchiveSaveCompressedProxy by older versions (PACKAGE_FILE_TAG). */
+	constexpr uint32 LegacyCompressedFileTag = 0x9E2A83C1;
+
+	/** Destination of decompressed chunks. */
+	struct FDecompressSink
+	{
+		virtual ~FDecompressSink() = default;
+
+		/** Called with the size of the whole payload when the file header is known. */
+		virtual bool Presize(int64 InSize) { return true; }
+
+		/** Returns the destination of the next InSize decompressed bytes. */
+		virtual uint8* Reserve(int32 InSize) = 0;
+
+		/** Called once the reserved bytes have been written. */
+		virtual bool Commit(int32 InSize) = 0;
+	};
+
+	/** Decompresses straight into a byte array. */
+	struct FArrayDecompressSink : FDecompressSink
+	{
+		explicit FArrayDecompressSink(TArray<uint8>& InBytes) : Bytes(InBytes)
+		{
+		}
+
+		virtual bool Presize(int64 InSize) override
+		{
+			if (InSize > MAX_int32)
+				return false;
+			Bytes.Reserve(static_cast<int32>(InSize));
+			return true;
+		}
+
+		virtual uint8* Reserve(int32 InSize) override
+		{
+			const int32 start = Bytes.AddUninitialized(InSize);
+			return Bytes.GetData() + start;
+		}
+
+		virtual bool Commit(int32 InSize) override
+		{
+			return true;
+		}
+
+		TArray<uint8>& Bytes;
+	};
+
+	/** Decompresses chunk by chunk into an archive. */
+	struct FArchiveDecompressSink : FDecompressSink
+	{
+		explicit FArchiveDecompressSink(FArchive& InTarget) : Target(InTarget)
+		{
+		}
+
+		virtual uint8* Reserve(int32 InSize) override
+		{
+			if (InSize > Scratch.Num())
+			{
+				Scratch.SetNumUninitialized(InSize);
+			}
+			return Scratch.GetData();
+		}
+
+		virtual bool Commit(int32 InSize) override
+		{
+			Target.Serialize(Scratch.GetData(), InSize);
+			return !Target.IsError();
+		}
+
+		FArchive& Target;
+		TArray<uint8> Scratch;
+	};
+
+	/** Entry of the block offset table stored at the end of block compressed files. */
+	struct FCompressedBlockEntry
+	{
+		/** Offset of the compressed block in the file. */
+		int64 Offset = 0;
+
+		/** Size of the compressed block. */
+		int32 CompressedSize = 0;
+
+		friend FArchive& operator<<(FArchive& Ar, FCompressedBlockEntry& Entry)
+		{
+			Ar << Entry.Offset;
+			Ar << Entry.CompressedSize;
+			return Ar;
+		}
+	};
+
+	/** Footer closing block compressed files, points at the block offset table. */
+	struct FCompressedBlockFooter
+	{
+		static constexpr int64 Size = sizeof(int64) + sizeof(int32) + sizeof(int32);
+		static constexpr int64 EntrySize = sizeof(int64) + sizeof(int32);
+
+		int64 TableOffset = 0;
+		int32 NumBlocks = 0;
+		int32 Magic = XEUS_SAVEGAME_FILE_TYPE_TAG;
+
+		friend FArchive& operator<<(FArchive& Ar, FCompressedBlockFooter& Footer)
+		{
+			Ar << Footer.TableOffset;
+			Ar << Footer.NumBlocks;
+			Ar << Footer.Magic;
+			return Ar;
+		}
+	};
+
+	/** Number of blocks compressed or decompressed per ParallelFor batch, bounds the working memory. */
+	int32 GetBlocksPerBatch()
+	{
+		return FMath::Max(1, FPlatformMisc::NumberOfCoresIncludingHyperthreads()) * 2;
+	}
+
+	/** Size of the uncompressed block InIndex of a payload of InTotalSize bytes. */
+	int32 GetBlockSize(int64 InTotalSize, int32 InChunkSize, int32 InIndex)
+	{
+		return static_cast<int32>(FMath::Min<int64>(InChunkSize, InTotalSize - static_cast<int64>(InIndex) * InChunkSize));
+	}
+
+	/**
+	 * Writes the file header, the blocks compressed in parallel, the block offset table and the footer.
+	 * InReadBlock returns a pointer to the next InSize bytes of the source, which must stay valid
+	 * until the whole batch (InSlot in [0, GetBlocksPerBatch())) has been compressed, or nullptr on error.
+	 */
+	bool WriteCompressedBlocks(FArchive& OutFile, int64 InTotalSize, const FDataSerializerCompressionSettings& InSettings,
+	                           TFunctionRef<const uint8*(int32, int32)> InReadBlock)
+	{
+		FDataSerializerFileHeader header;
+		header.Codec = InSettings.Codec;
+		header.Level = InSettings.Level;
+		header.UncompressedSize = InTotalSize;
+		OutFile << header;
+
+		const int32 chunkSize = header.ChunkSize;
+		const int32 numBlocks = static_cast<int32>((InTotalSize + chunkSize - 1) / chunkSize);
+		const int32 bound = CompressBound(InSettings.Codec, chunkSize);
+		const int32 blocksPerBatch = FMath::Clamp(numBlocks, 1, GetBlocksPerBatch());
+
+		TArray<uint8> compressed;
+		compressed.SetNumUninitialized(blocksPerBatch * bound);
+		TArray<const uint8*> sources;
+		sources.SetNumZeroed(blocksPerBatch);
+		TArray<int32> compressedSizes;
+		compressedSizes.SetNumZeroed(blocksPerBatch);
+		TArray<FCompressedBlockEntry> table;
+		table.Reserve(numBlocks);
+
+		for (int32 first = 0; first < numBlocks; first += blocksPerBatch)
+		{
+			const int32 count = FMath::Min(blocksPerBatch, numBlocks - first);
+			for (int32 i = 0; i < count; ++i)
+			{
+				sources[i] = InReadBlock(i, GetBlockSize(InTotalSize, chunkSize, first + i));
+				if (sources[i] == nullptr)
+					return false;
+			}
+
+			std::atomic<bool> bFailed{false};
+			ParallelFor(count, [&](int32 InIndex)
+			{
+				int32 compressedSize = bound;
+				if (!CompressBlock(InSettings, compressed.GetData() + InIndex * bound, compressedSize, sources[InIndex],
+				                   GetBlockSize(InTotalSize, chunkSize, first + InIndex)))
+				{
+					bFailed = true;
+					return;
+				}
+				compressedSizes[InIndex] = compressedSize;
+			});
+			if (bFailed)
+				return false;
+
+			DATASERIALIZER_SCOPE(STAT_DataSerializer_FileWrite);
+			for (int32 i = 0; i < count; ++i)
+			{
+				FCompressedBlockEntry& entry = table.AddDefaulted_GetRef();
+				entry.Offset = OutFile.Tell();
+				entry.CompressedSize = compressedSizes[i];
+				OutFile.Serialize(compressed.GetData() + i * bound, compressedSizes[i]);
+			}
+			if (OutFile.IsError())
+				return false;
+		}
+
+		FCompressedBlockFooter footer;
+		footer.TableOffset = OutFile.Tell();
+		footer.NumBlocks = numBlocks;
+		for (FCompressedBlockEntry& entry : table)
+		{
+			OutFile << entry;
+		}
+		OutFile << footer;
+
+		RecordFileBytes(OutFile.Tell(), true);
+		RecordCompression(InTotalSize, OutFile.Tell());
+		return !OutFile.IsError();
+	}
+
+	/** Reads and validates the block offset table of a block compressed file, InFile must be right after the header. */
+	bool ReadBlockTable(FArchive& InFile, const FDataSerializerFileHeader& InHeader,
+	                    TArray<FCompressedBlockEntry>& OutTable)
+	{
+		const int64 dataStart = InFile.Tell();
+		const int64 totalSize = InFile.TotalSize();
+		if (totalSize < dataStart + FCompressedBlockFooter::Size)
+			return false;
+
+		FCompressedBlockFooter footer;
+		InFile.Seek(totalSize - FCompressedBlockFooter::Size);
+		InFile << footer;
+
+		const int64 expectedBlocks = (InHeader.UncompressedSize + InHeader.ChunkSize - 1) / InHeader.ChunkSize;
+		if (InFile.IsError()
+			|| footer.Magic != XEUS_SAVEGAME_FILE_TYPE_TAG
+			|| footer.NumBlocks != expectedBlocks
+			|| footer.TableOffset < dataStart
+			|| footer.TableOffset + footer.NumBlocks * FCompressedBlockFooter::EntrySize
+			!= totalSize - FCompressedBlockFooter::Size)
+			return false;
+
+		const int32 bound = CompressBound(InHeader.Codec, InHeader.ChunkSize);
+		OutTable.SetNum(footer.NumBlocks);
+		InFile.Seek(footer.TableOffset);
+		int64 previousEnd = dataStart;
+		for (FCompressedBlockEntry& entry : OutTable)
+		{
+			InFile << entry;
+			if (entry.Offset < previousEnd || entry.CompressedSize <= 0 || entry.CompressedSize > bound)
+				return false;
+			previousEnd = entry.Offset + entry.CompressedSize;
+		}
+
+		return !InFile.IsError() && previousEnd <= footer.TableOffset;
+	}
+
+	/** Decompresses the blocks [InFirstBlock, InFirstBlock + InNumBlocks) of a block compressed file in parallel. */
+	bool ReadCompressedBlocks(FArchive& InFile, const FDataSerializerFileHeader& InHeader,
+	                          const TArray<FCompressedBlockEntry>& InTable, int32 InFirstBlock, int32 InNumBlocks,
+	                          FDecompressSink& InSink)
+	{
+		const int32 chunkSize = InHeader.ChunkSize;
+		const int32 blocksPerBatch = GetBlocksPerBatch();
+		const int32 endBlock = InFirstBlock + InNumBlocks;
+		TArray<uint8> compressed;
+
+		for (int32 first = InFirstBlock; first < endBlock; first += blocksPerBatch)
+		{
+			const int32 count = FMath::Min(blocksPerBatch, endBlock - first);
+
+			// Blocks are stored back to back, read the whole batch at once
+			const int64 batchStart = InTable[first].Offset;
+			const int64 batchEnd = InTable[first + count - 1].Offset + InTable[first + count - 1].CompressedSize;
+			compressed.SetNumUninitialized(static_cast<int32>(batchEnd - batchStart));
+			{
+				DATASERIALIZER_SCOPE(STAT_DataSerializer_FileRead);
+				InFile.Seek(batchStart);
+				InFile.Serialize(compressed.GetData(), compressed.Num());
+				if (InFile.IsError())
+					return false;
+				RecordFileBytes(compressed.Num(), false);
+			}
+
+			const int64 rawStart = static_cast<int64>(first) * chunkSize;
+			const int32 rawSize = static_cast<int32>(FMath::Min<int64>(static_cast<int64>(first + count) * chunkSize,
+			                                                           InHeader.UncompressedSize) - rawStart);
+			uint8* raw = InSink.Reserve(rawSize);
+
+			std::atomic<bool> bFailed{false};
+			ParallelFor(count, [&](int32 InIndex)
+			{
+				const FCompressedBlockEntry& entry = InTable[first + InIndex];
+				if (!DecompressBlock(InHeader.Codec, raw + static_cast<int64>(InIndex) * chunkSize,
+				                     GetBlockSize(InHeader.UncompressedSize, chunkSize, first + InIndex),
+				                     compressed.GetData() + (entry.Offset - batchStart), entry.CompressedSize))
+				{
+					bFailed = true;
+				}
+			});
+			if (bFailed || !InSink.Commit(rawSize))
+				return false;
+		}
+		return true;
+	}
+
+	/** Decompresses a whole file written through FArchiveSaveCompressedProxy. */
+	bool ReadLegacyCompressed(FArchive& InFile, FDecompressSink& InSink)
+	{
+		TArray<uint8> compressedData;
+		compressedData.SetNumUninitialized(static_cast<int32>(InFile.TotalSize()));
+		{
+			DATASERIALIZER_SCOPE(STAT_DataSerializer_FileRead);
+			InFile.Seek(0);
+			InFile.Serialize(compressedData.GetData(), compressedData.Num());
+			if (InFile.IsError())
+				return false;
+			RecordFileBytes(compressedData.Num(), false);
+		}
+
+		DATASERIALIZER_SCOPE(STAT_DataSerializer_Decompress);
+		FArchiveLoadCompressedProxy decompressor(compressedData, NAME_Zlib);
+		if (decompressor.GetError())
+			return false;
+
+		TArray<uint8> bytes;
+		decompressor << bytes;
+		if (decompressor.GetError())
+			return false;
+
+		if (bytes.Num() == 0)
+			return true;
+		FMemory::Memcpy(InSink.Reserve(bytes.Num()), bytes.GetData(), bytes.Num());
+		return InSink.Commit(bytes.Num());
+	}
+
+	/** Opens a compressed file and dispatches to the reader matching its format. */
+	bool ReadCompressedFile(const FString& InPath, FDecompressSink& InSink)
+	{
+		TUniquePtr<FArchive> file(IFileManager::Get().CreateFileReader(*InPath));
+		if (!file.IsValid())
+			return false;
+
+		if (file->TotalSize() >= static_cast<int64>(sizeof(uint32)))
+		{
+			uint32 tag = 0;
+			*file << tag;
+			file->Seek(0);
+
+			if (tag == static_cast<uint32>(XEUS_SAVEGAME_FILE_TYPE_TAG))
+			{
+				FDataSerializerFileHeader header;
+				*file << header;
+				if (file->IsError() || !header.IsValid() || !InSink.Presize(header.UncompressedSize))
+					return false;
+
+				TArray<FCompressedBlockEntry> table;
+				if (!ReadBlockTable(*file, header, table))
+					return false;
+				return ReadCompressedBlocks(*file, header, table, 0, table.Num(), InSink);
+			}
+
+			if (tag == LegacyCompressedFileTag)
+			{
+				return ReadLegacyCompressed(*file, InSink);
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * Loads the object state following a header, full or delta.
+	 * @param InReader The archive positioned after the header.
+	 * @param InHeader The header read before.
+	 * @param InObject The object to load into, of the header class.
+	 * @return true on success.
+	 */
+	static bool ReadObjectBody(FArchive& InReader, const FSerializationHeader& InHeader, UObject* InObject)
+	{
+		if (!InHeader.IsDelta())
+			return ReadObjectData(InReader, InObject);
+
+		// Property indices are meaningless if the class changed since the delta was written
+		if (InHeader.LayoutHash != GetDeltaLayoutHash(InObject->GetClass()))
+			return false;
+
+		return ReadObjectDelta(InReader, InObject);
+	}
+
+	/**
+	 * Loads a batch written by SerializeObjects or SerializeObjectsIndexed.
+	 * @param InReader The archive to read from.
+	 * @param InObjectOuter The outer of the objects of a graph.
+	 * @param OutObjects Array the loaded objects are appended to.
+	 * @param InFactory Returns the object a record is loaded into, given its class and index, nullptr fails.
+	 * @param bInAllowGraph Whether object graphs are accepted, they always create their objects.
+	 * @return true on success.
+	 */
+	static bool ReadObjects(FArchive& InReader, UObject* InObjectOuter, TArray<UObject*>& OutObjects,
+	                        TFunctionRef<UObject*(UClass* InClass, int32 InIndex)> InFactory, bool bInAllowGraph)
+	{
+		int32 n = 0;
+		InReader << n;
+
+		if (n == XEUS_OBJECT_INDEX_TAG)
+		{
+			InReader.Seek(InReader.Tell() - sizeof(n));
+			FDataSerializerObjectIndex index;
+			if (!index.Read(InReader))
+				return false;
+
+			const int64 end = InReader.Tell();
+			OutObjects.Reserve(OutObjects.Num() + index.Num());
+			for (int32 i = 0; i < index.Num(); ++i)
+			{
+				UObject* object = index.GetClass(i) != nullptr ? InFactory(index.GetClass(i), i) : nullptr;
+				if (object == nullptr || !index.DeSerializeInto(InReader, i, object))
+					return false;
+				OutObjects.Add(object);
+			}
+			InReader.Seek(end);
+			return true;
+		}
+
+		if (n == XEUS_OBJECT_GRAPH_TAG)
+			return bInAllowGraph && ReadObjectGraph(InReader, InObjectOuter, OutObjects);
+
+		if (n == XEUS_OBJECT_BATCH_TAG)
+		{
+			FObjectBatchHeader header;
+			if (!header.Read(InReader))
+				return false;
+
+			uint32 count = 0;
+			InReader.SerializeIntPacked(count);
+			if (InReader.IsError() || count > static_cast<uint32>(InReader.TotalSize() - InReader.Tell()))
+				return false;
+
+			OutObjects.Reserve(OutObjects.Num() + count);
+			for (uint32 i = 0; i < count; ++i)
+			{
+				uint32 classIndex = 0;
+				InReader.SerializeIntPacked(classIndex);
+				if (!header.Classes.IsValidIndex(classIndex) || header.Classes[classIndex] == nullptr)
+					return false;
+
+				UObject* resObject = InFactory(header.Classes[classIndex], i);
+				if (resObject == nullptr || !ReadObjectData(InReader, resObject, nullptr, header.GetSchema(classIndex)))
+					return false;
+				OutObjects.Add(resObject);
+			}
+			return !InReader.IsError();
+		}
+
+		// Format written before the class table: a full header per object
+		const int32 first = OutObjects.Num();
+		for (int32 i = 0; i < n; ++i)
+		{
+			FSerializationHeader header;
+			header.Read(InReader);
+
+			UClass* gameClass = UDataSerializerLib::ResolveClassCpp(header.GameClassName);
+
+			// If we have a class, try and load it.
+			UObject* resObject = gameClass != nullptr ? InFactory(gameClass, i) : nullptr;
+			if (resObject == nullptr || !ReadObjectBody(InReader, header, resObject))
+				return false;
+			OutObjects.Add(resObject);
+		}
+
+		return OutObjects.Num() - first == n;
+	}
+
+	/** Resolved classes, shared by every deserialization call. */
+	FCriticalSection ClassCacheLock;
+	TMap<FSoftClassPath, TWeakObjectPtr<UClass>> ClassCache;
+}
 
 FSerializationHeader::FSerializationHeader()
 {
@@ -20,63 +494,296 @@ FSerializationHeader::FSerializationHeader(TSubclassOf<UObject> ObjectType) :
 void FSerializationHeader::Empty()
 {
 	GameClassName.Empty();
+	Kind = EDataSerializerBlobKind::Full;
+	LayoutHash = 0;
 }
 
-void FSerializationHeader::Read(FMemoryReader& MemoryReader)
+void FSerializationHeader::Read(FArchive& MemoryReader)
 {
 	Empty();
+	// Delta headers start with a tag where full headers have the class name length
+	const int64 start = MemoryReader.Tell();
+	int32 tag = 0;
+	MemoryReader << tag;
+	if (tag == XEUS_DELTA_HEADER_TAG)
+	{
+		Kind = EDataSerializerBlobKind::Delta;
+		MemoryReader << LayoutHash;
+	}
+	else
+	{
+		MemoryReader.Seek(start);
+	}
+
 	// Get the class name
 	MemoryReader << GameClassName;
 }
 
 void FSerializationHeader::Write(FMemoryWriter& MemoryWriter)
 {
+	if (IsDelta())
+	{
+		int32 tag = XEUS_DELTA_HEADER_TAG;
+		MemoryWriter << tag;
+		MemoryWriter << LayoutHash;
+	}
+
 	// Write the class name, so we know what class to load to
 	MemoryWriter << GameClassName;
 }
 
 bool UDataSerializerLib::WriteBytesToDisk(const TArray<uint8>& InBytes, FString InPath)
 {
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_FileWrite);
+	Serializer::RecordFileBytes(InBytes.Num(), true);
 	return FFileHelper::SaveArrayToFile(InBytes, *InPath);
 }
 
 bool UDataSerializerLib::WriteBytesToDiskCompressed(const TArray<uint8>& InBytes, FString InPath)
 {
 	ensure(InBytes.Num() > 0);
-	TArray<uint8> compressedData;
+	return WriteBytesToDiskCompressedCpp(InBytes, InPath);
+}
+
+bool UDataSerializerLib::WriteBytesToDiskCompressedWithSettings(const TArray<uint8>& InBytes, FString InPath,
+                                                                FDataSerializerCompressionSettings InSettings)
+{
+	ensure(InBytes.Num() > 0);
+	return WriteBytesToDiskCompressedCpp(InBytes, InPath, InSettings);
+}
+
+bool UDataSerializerLib::WriteBytesToDiskCompressedCpp(TArrayView<const uint8> InBytes, const FString& InPath,
+                                                       const FDataSerializerCompressionSettings& InSettings)
+{
+	TUniquePtr<FArchive> file(IFileManager::Get().CreateFileWriter(*InPath));
+	if (!file.IsValid())
+		return false;
+
+	const uint8* cursor = InBytes.GetData();
+	bool bResult = Serializer::WriteCompressedBlocks(*file, InBytes.Num(), InSettings, [&cursor](int32 InSlot, int32 InSize)
+	{
+		const uint8* block = cursor;
+		cursor += InSize;
+		return block;
+	});
+	bResult = file->Close() && bResult;
+	file.Reset();
+
+	if (!bResult)
+	{
+		IFileManager::Get().Delete(*InPath);
+	}
+	return bResult;
+}
+
+bool UDataSerializerLib::WriteArchiveToDiskCompressedCpp(FArchive& InSource, const FString& InPath,
+                                                         const FDataSerializerCompressionSettings& InSettings)
+{
+	TUniquePtr<FArchive> file(IFileManager::Get().CreateFileWriter(*InPath));
+	if (!file.IsValid())
+		return false;
+
+	const int64 totalSize = InSource.TotalSize() - InSource.Tell();
+	TArray<uint8> staging;
+	staging.SetNumUninitialized(static_cast<int32>(FMath::Min<int64>(
+		static_cast<int64>(Serializer::GetBlocksPerBatch()) * XEUS_COMPRESSION_CHUNK_SIZE, totalSize)));
+
+	auto readBlock = [&InSource, &staging](int32 InSlot, int32 InSize) -> const uint8*
+	{
+		uint8* block = staging.GetData() + static_cast<int64>(InSlot) * XEUS_COMPRESSION_CHUNK_SIZE;
+		InSource.Serialize(block, InSize);
+		return InSource.IsError() ? nullptr : block;
+	};
+	bool bResult = Serializer::WriteCompressedBlocks(*file, totalSize, InSettings, readBlock);
+	bResult = file->Close() && bResult;
+	file.Reset();
+
+	if (!bResult)
 	{
-		FArchiveSaveCompressedProxy compresser(compressedData, NAME_Zlib);
-		TArray<uint8> copy = InBytes;
-		compresser << copy;
-		compresser.Flush();
+		IFileManager::Get().Delete(*InPath);
 	}
-	return WriteBytesToDisk(compressedData, InPath);
+	return bResult;
 }
 
 bool UDataSerializerLib::ReadBytesFromDisk(TArray<uint8>& OutBytes, FString InPath)
 {
-	return FFileHelper::LoadFileToArray(OutBytes, *InPath);
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_FileRead);
+	const bool bResult = FFileHelper::LoadFileToArray(OutBytes, *InPath);
+	Serializer::RecordFileBytes(OutBytes.Num(), false);
+	return bResult;
 }
 
 bool UDataSerializerLib::ReadCompressedBytesFromDisk(TArray<uint8>& OutBytes, FString InPath)
 {
-	TArray<uint8> compressedData;
-	if (!ReadBytesFromDisk(compressedData, InPath))
+	OutBytes.Reset();
+	Serializer::FArrayDecompressSink sink(OutBytes);
+	return Serializer::ReadCompressedFile(InPath, sink);
+}
+
+bool UDataSerializerLib::ReadCompressedBytesFromDiskCpp(FArchive& OutTarget, const FString& InPath)
+{
+	Serializer::FArchiveDecompressSink sink(OutTarget);
+	return Serializer::ReadCompressedFile(InPath, sink);
+}
+
+bool UDataSerializerLib::ReadCompressedBytesRangeFromDisk(TArray<uint8>& OutBytes, FString InPath, int64 InOffset,
+                                                          int64 InLength)
+{
+	OutBytes.Reset();
+	if (InOffset < 0 || InLength < 0)
 		return false;
 
-	FArchiveLoadCompressedProxy Decompressor(compressedData, NAME_Zlib);
-	if (Decompressor.GetError())
+	TUniquePtr<FArchive> file(IFileManager::Get().CreateFileReader(*InPath));
+	if (!file.IsValid())
 		return false;
 
-	Decompressor << OutBytes;
+	FDataSerializerFileHeader header;
+	if (file->TotalSize() >= static_cast<int64>(sizeof(FDataSerializerFileHeader::Magic)))
+	{
+		*file << header;
+	}
+
+	if (file->IsError() || !header.IsValid())
+	{
+		// No block table, decompress everything and slice
+		file.Reset();
+		TArray<uint8> bytes;
+		if (!ReadCompressedBytesFromDisk(bytes, InPath) || InOffset > bytes.Num())
+			return false;
+		const int32 length = static_cast<int32>(FMath::Min<int64>(InLength, bytes.Num() - InOffset));
+		OutBytes.Append(bytes.GetData() + InOffset, length);
+		return true;
+	}
+
+	if (InOffset > header.UncompressedSize)
+		return false;
+	const int64 length = FMath::Min<int64>(InLength, header.UncompressedSize - InOffset);
+	if (length == 0)
+		return true;
 
-	if (Decompressor.GetError())
+	TArray<Serializer::FCompressedBlockEntry> table;
+	if (!Serializer::ReadBlockTable(*file, header, table))
 		return false;
+
+	// Only decompress the blocks covering the range
+	const int32 firstBlock = static_cast<int32>(InOffset / header.ChunkSize);
+	const int32 lastBlock = static_cast<int32>((InOffset + length - 1) / header.ChunkSize);
+	TArray<uint8> blocks;
+	Serializer::FArrayDecompressSink sink(blocks);
+	if (!Serializer::ReadCompressedBlocks(*file, header, table, firstBlock, lastBlock - firstBlock + 1, sink))
+		return false;
+
+	const int64 skip = InOffset - static_cast<int64>(firstBlock) * header.ChunkSize;
+	OutBytes.Append(blocks.GetData() + skip, static_cast<int32>(length));
 	return true;
 }
 
+bool UDataSerializerLib::DeSerializeObjectsFromFile(FString InPath, UObject* InObjectOuter,
+                                                    TArray<UObject*>& OutObjects)
+{
+	OutObjects.Empty();
+	TSharedPtr<FDataSerializerMappedFile, ESPMode::ThreadSafe> file;
+	{
+		DATASERIALIZER_SCOPE(STAT_DataSerializer_FileRead);
+		file = FDataSerializerMappedFile::Open(InPath);
+	}
+	if (!file.IsValid() || file->Num() == 0)
+		return false;
+
+	FMemoryReaderView reader(MakeMemoryView(file->GetView().GetData(), file->Num()), true);
+	return DeSerializeObjectsCpp(reader, InObjectOuter, OutObjects);
+}
+
+bool UDataSerializerLib::DeSerializeObjectsFromFileStreamed(FString InPath, UObject* InObjectOuter,
+                                                            TArray<UObject*>& OutObjects, int32 InChunkSize)
+{
+	OutObjects.Empty();
+	TUniquePtr<FDataSerializerStreamingReader> reader = FDataSerializerStreamingReader::Open(InPath, InChunkSize);
+	if (!reader.IsValid() || reader->TotalSize() == 0)
+		return false;
+
+	return DeSerializeObjectsCpp(*reader, InObjectOuter, OutObjects) && !reader->IsError();
+}
+
+bool UDataSerializerLib::DeSerializeIndexedObjectFromFile(FString InPath, int32 InIndex, UObject* InObjectOuter,
+                                                          UObject*& OutObject)
+{
+	OutObject = nullptr;
+	TSharedPtr<FDataSerializerMappedFile, ESPMode::ThreadSafe> file;
+	{
+		DATASERIALIZER_SCOPE(STAT_DataSerializer_FileRead);
+		file = FDataSerializerMappedFile::Open(InPath);
+	}
+	if (!file.IsValid())
+		return false;
+
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_Deserialize);
+	FMemoryReaderView reader(MakeMemoryView(file->GetView().GetData(), file->Num()), true);
+	FDataSerializerObjectIndex index;
+	const bool bResult = index.Read(reader) && index.DeSerializeObject(reader, InIndex, InObjectOuter, OutObject);
+	Serializer::RecordObjects(bResult ? 1 : 0);
+	return bResult;
+}
+
+bool UDataSerializerLib::ReadCompressedFileHeaderCpp(const FString& InPath, FDataSerializerFileHeader& OutHeader)
+{
+	TUniquePtr<FArchive> file(IFileManager::Get().CreateFileReader(*InPath));
+	if (!file.IsValid() || file->TotalSize() < static_cast<int64>(sizeof(FDataSerializerFileHeader::Magic)))
+		return false;
+
+	*file << OutHeader;
+	return !file->IsError() && OutHeader.IsValid();
+}
+
+bool UDataSerializerLib::WriteBlobsToContainer(const TArray<FDataSerializerBlob>& InBlobs, FString InPath)
+{
+	const TSharedPtr<FDataSerializerContainer, ESPMode::ThreadSafe> container = FDataSerializerContainer::Open(InPath);
+	if (!container.IsValid())
+		return false;
+
+	TArray<FString> keys;
+	TArray<TArray<uint8>> blobs;
+	keys.Reserve(InBlobs.Num());
+	blobs.Reserve(InBlobs.Num());
+	for (const FDataSerializerBlob& blob : InBlobs)
+	{
+		keys.Add(blob.Key);
+		blobs.Add(blob.Bytes);
+	}
+	return container->WriteMany(keys, blobs);
+}
+
+bool UDataSerializerLib::ReadBlobsFromContainer(TArray<FDataSerializerBlob>& OutBlobs, FString InPath,
+                                                const TArray<FString>& InKeys)
+{
+	OutBlobs.Reset();
+	const TSharedPtr<FDataSerializerContainer, ESPMode::ThreadSafe> container = FDataSerializerContainer::Open(InPath, false);
+	if (!container.IsValid())
+		return false;
+
+	const TArray<FString> keys = InKeys.Num() > 0 ? InKeys : container->GetKeys();
+	TArray<TArray<uint8>> blobs;
+	const bool bResult = container->ReadMany(keys, blobs);
+
+	OutBlobs.Reserve(keys.Num());
+	for (int32 i = 0; i < keys.Num(); ++i)
+	{
+		FDataSerializerBlob& blob = OutBlobs.AddDefaulted_GetRef();
+		blob.Key = keys[i];
+		blob.Bytes = MoveTemp(blobs[i]);
+	}
+	return bResult;
+}
+
+bool UDataSerializerLib::RemoveBlobsFromContainer(FString InPath, const TArray<FString>& InKeys)
+{
+	const TSharedPtr<FDataSerializerContainer, ESPMode::ThreadSafe> container = FDataSerializerContainer::Open(InPath, false);
+	return container.IsValid() && container->RemoveMany(InKeys);
+}
+
 bool UDataSerializerLib::SerializeObject(TArray<uint8>& OutBytes, UObject* InObject)
 {
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_Serialize);
 	ensure(IsValid(InObject));
 	OutBytes.Empty();
 	FMemoryWriter writer(OutBytes, true);
@@ -84,14 +791,11 @@ bool UDataSerializerLib::SerializeObject(TArray<uint8>& OutBytes, UObject* InObj
 	FSerializationHeader header(InObject->GetClass());
 	header.Write(writer);
 
-	// Then save the object state, replacing object refs and names with strings
-	FObjectAndNameAsStringProxyArchive archive(writer, false);
-	InObject->Serialize(archive);
-
-	if (archive.GetError())
-		return false;
-
-	return true;
+	// Then save the object state
+	const bool bResult = Serializer::WriteObjectData(writer, InObject);
+	Serializer::RecordBytesOut(OutBytes.Num());
+	Serializer::RecordObjects(1);
+	return bResult;
 }
 
 bool UDataSerializerLib::DeserializeObject(const TArray<uint8>& InBytes, UObject* ObjectOuter, UObject*& OutObject)
@@ -104,52 +808,188 @@ bool UDataSerializerLib::DeserializeObject(const TArray<uint8>& InBytes, UObject
 	return DeSerializeObjectCpp(reader, ObjectOuter, OutObject);
 }
 
-bool UDataSerializerLib::DeSerializeObjectCpp(FMemoryReader& InReader,
+bool UDataSerializerLib::DeSerializeObjectCpp(FArchive& InReader,
                                               UObject* ObjectOuter, UObject*& OutObject)
 {
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_Deserialize);
+	Serializer::FScopedReadCounter counter(InReader);
 	FSerializationHeader header;
 	header.Read(InReader);
 
-	// Try and find it, and failing that, load it
-	UClass* gameClass = FindObject<UClass>(nullptr, *header.GameClassName);
-	if (gameClass == nullptr)
-	{
-		gameClass = LoadObject<UClass>(nullptr, *header.GameClassName);
-	}
+	UClass* gameClass = ResolveClassCpp(header.GameClassName);
 
 	// If we have a class, try and load it.
+	// A delta is applied to a fresh object, which matches deltas written against the class defaults.
 	if (gameClass != nullptr)
 	{
 		OutObject = NewObject<UObject>(ObjectOuter, gameClass);
-
-		FObjectAndNameAsStringProxyArchive archive(InReader, true);
-		OutObject->Serialize(archive);
+		if (!Serializer::ReadObjectBody(InReader, header, OutObject))
+		{
+			// Don't hand out a partially loaded object
+			OutObject = nullptr;
+			return false;
+		}
+		Serializer::RecordObjects(1);
 	}
 
 	return IsValid(OutObject);
 }
 
+bool UDataSerializerLib::SerializeObjectDelta(TArray<uint8>& OutBytes, UObject* InObject, UObject* InBaseline)
+{
+	ensure(IsValid(InObject));
+	OutBytes.Empty();
+	FMemoryWriter writer(OutBytes, true);
+
+	return SerializeObjectDeltaCpp(writer, InObject, InBaseline);
+}
+
+bool UDataSerializerLib::SerializeObjectDeltaFromBytes(TArray<uint8>& OutBytes, UObject* InObject,
+                                                       const TArray<uint8>& InBaselineBytes)
+{
+	ensure(IsValid(InObject));
+	OutBytes.Empty();
+
+	UObject* baseline = nullptr;
+	if (!DeserializeObject(InBaselineBytes, GetTransientPackage(), baseline))
+		return false;
+
+	FMemoryWriter writer(OutBytes, true);
+	return SerializeObjectDeltaCpp(writer, InObject, baseline);
+}
+
+bool UDataSerializerLib::SerializeObjectDeltaCpp(FMemoryWriter& InWriter, UObject* InObject,
+                                                 const UObject* InBaseline)
+{
+	if (!IsValid(InObject))
+		return false;
+
+	UClass* objectClass = InObject->GetClass();
+	if (InBaseline == nullptr)
+	{
+		InBaseline = objectClass->GetDefaultObject();
+	}
+	else if (InBaseline->GetClass() != objectClass)
+	{
+		return false;
+	}
+
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_Serialize);
+	const int64 start = InWriter.Tell();
+	FSerializationHeader header(objectClass);
+	header.Kind = EDataSerializerBlobKind::Delta;
+	header.LayoutHash = Serializer::GetDeltaLayoutHash(objectClass);
+	header.Write(InWriter);
+
+	// Then save the changed properties
+	const bool bResult = Serializer::WriteObjectDelta(InWriter, InObject, InBaseline);
+	Serializer::RecordBytesOut(InWriter.Tell() - start);
+	Serializer::RecordObjects(1);
+	return bResult;
+}
+
+bool UDataSerializerLib::ApplyObjectDelta(const TArray<uint8>& InBytes, UObject* InTarget)
+{
+	ensure(IsValid(InTarget));
+	FMemoryReader reader(InBytes, true);
+
+	return ApplyObjectDeltaCpp(reader, InTarget);
+}
+
+bool UDataSerializerLib::ApplyObjectDeltaCpp(FArchive& InReader, UObject* InTarget)
+{
+	if (!IsValid(InTarget))
+		return false;
+
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_Deserialize);
+	Serializer::FScopedReadCounter counter(InReader);
+	FSerializationHeader header;
+	header.Read(InReader);
+
+	if (ResolveClassCpp(header.GameClassName) != InTarget->GetClass())
+		return false;
+
+	return Serializer::ReadObjectBody(InReader, header, InTarget);
+}
+
+bool UDataSerializerLib::ApplyObjectDeltaToBytes(const TArray<uint8>& InBaselineBytes,
+                                                 const TArray<uint8>& InDeltaBytes, TArray<uint8>& OutBytes)
+{
+	OutBytes.Empty();
+
+	UObject* object = nullptr;
+	if (!DeserializeObject(InBaselineBytes, GetTransientPackage(), object))
+		return false;
+
+	if (!ApplyObjectDelta(InDeltaBytes, object))
+		return false;
+
+	return SerializeObject(OutBytes, object);
+}
+
 bool UDataSerializerLib::SerializeObjects(TArray<uint8>& OutBytes, TArray<UObject*> InObjects)
 {
 	ensure(InObjects.Num() > 0);
 	OutBytes.Empty();
 	FMemoryWriter writer(OutBytes, true);
+	return SerializeObjectsCpp(writer, InObjects);
+}
+
+bool UDataSerializerLib::SerializeObjectsWithSchema(TArray<uint8>& OutBytes, TArray<UObject*> InObjects)
+{
+	ensure(InObjects.Num() > 0);
+	OutBytes.Empty();
+	FMemoryWriter writer(OutBytes, true);
+	return SerializeObjectsCpp(writer, InObjects, true);
+}
 
-	int32 n = InObjects.Num();
-	writer << n;
-	for (int32 i = 0; i < n; ++i)
+bool UDataSerializerLib::SerializeObjectsCpp(FMemoryWriter& InWriter, TArrayView<UObject* const> InObjects,
+                                             bool bInSaveGameSchema)
+{
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_Serialize);
+	const int64 start = InWriter.Tell();
+
+	// Build the class table, every class path is written once
+	Serializer::FClassTable classTable;
+	TArray<uint32> classIndices;
+	classIndices.Reserve(InObjects.Num());
+	for (UObject* object : InObjects)
 	{
-		FSerializationHeader SaveHeader(InObjects[i]->GetClass());
-		SaveHeader.Write(writer);
+		if (!IsValid(object))
+			return false;
+		classIndices.Add(classTable.Add(object->GetClass()));
+	}
 
-		// Then save the object state, replacing object refs and names with strings
-		FObjectAndNameAsStringProxyArchive Ar(writer, false);
-		InObjects[i]->Serialize(Ar);
+	int32 tag = XEUS_OBJECT_BATCH_TAG;
+	uint8 version = Serializer::ObjectBatchVersion;
+	uint8 flags = bInSaveGameSchema ? Serializer::ObjectBatchHasSchemas : 0;
+	InWriter << tag;
+	InWriter << version;
+	InWriter << flags;
+	classTable.Write(InWriter);
 
-		if (Ar.GetError())
+	// The layout of every class is described once, object records only carry its hash
+	if (bInSaveGameSchema)
+	{
+		for (UClass* objectClass : classTable.Classes)
+		{
+			Serializer::WriteSchemaDescriptor(InWriter, objectClass);
+		}
+	}
+
+	uint32 n = InObjects.Num();
+	InWriter.SerializeIntPacked(n);
+	for (int32 i = 0; i < InObjects.Num(); ++i)
+	{
+		InWriter.SerializeIntPacked(classIndices[i]);
+		const bool bResult = bInSaveGameSchema ? Serializer::WriteObjectSchemaData(InWriter, InObjects[i])
+			                     : Serializer::WriteObjectData(InWriter, InObjects[i]);
+		if (!bResult)
 			return false;
 	}
 
+	Serializer::RecordBytesOut(InWriter.Tell() - start);
+	Serializer::RecordObjects(InObjects.Num());
 	return true;
 }
 
@@ -163,45 +1003,314 @@ bool UDataSerializerLib::DeSerializeObjects(const TArray<uint8>& InBytes, UObjec
 	return DeSerializeObjectsCpp(reader, InObjectOuter, OutObjects);
 }
 
-bool UDataSerializerLib::DeSerializeObjectsCpp(FMemoryReader& InReader,
+bool UDataSerializerLib::DeSerializeObjectsCpp(FArchive& InReader,
                                                UObject* InObjectOuter, TArray<UObject*>& OutObjects)
 {
-	int32 n = 0;
-	InReader << n;
-	for (int32 i = 0; i < n; ++i)
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_Deserialize);
+	Serializer::FScopedReadCounter counter(InReader, &OutObjects);
+	return Serializer::ReadObjects(InReader, InObjectOuter, OutObjects, [InObjectOuter](UClass* InClass, int32 InIndex)
 	{
-		FSerializationHeader header;
-		header.Read(InReader);
+		return NewObject<UObject>(InObjectOuter, InClass);
+	}, true);
+}
+
+bool UDataSerializerLib::DeSerializeObjectInto(const TArray<uint8>& InBytes, UObject* InTarget)
+{
+	FMemoryReader reader(InBytes, true);
+	return DeSerializeObjectIntoCpp(reader, InTarget);
+}
+
+bool UDataSerializerLib::DeSerializeObjectIntoCpp(FArchive& InReader, UObject* InTarget)
+{
+	if (!IsValid(InTarget))
+		return false;
+
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_Deserialize);
+	Serializer::FScopedReadCounter counter(InReader);
+	FSerializationHeader header;
+	header.Read(InReader);
+
+	if (ResolveClassCpp(header.GameClassName) != InTarget->GetClass())
+		return false;
+
+	// A delta patches the current state, a full blob replaces it
+	if (!header.IsDelta())
+	{
+		Serializer::ResetObjectToDefaults(InTarget);
+	}
+	const bool bResult = Serializer::ReadObjectBody(InReader, header, InTarget);
+	Serializer::RecordObjects(bResult ? 1 : 0);
+	return bResult;
+}
+
+bool UDataSerializerLib::DeSerializeObjectsInto(const TArray<uint8>& InBytes, TArray<UObject*> InTargets)
+{
+	FMemoryReader reader(InBytes, true);
+	return DeSerializeObjectsIntoCpp(reader, InTargets);
+}
 
-		// Try and find it, and failing that, load it
-		UClass* gameClass = FindObject<UClass>(nullptr, *header.GameClassName);
-		if (gameClass == nullptr)
+bool UDataSerializerLib::DeSerializeObjectsIntoCpp(FArchive& InReader, TArrayView<UObject* const> InTargets)
+{
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_Deserialize);
+	TArray<UObject*> objects;
+	Serializer::FScopedReadCounter counter(InReader, &objects);
+	const bool bResult = Serializer::ReadObjects(InReader, nullptr, objects, [InTargets](UClass* InClass, int32 InIndex) -> UObject*
+	{
+		if (!InTargets.IsValidIndex(InIndex) || !IsValid(InTargets[InIndex]) || InTargets[InIndex]->GetClass() != InClass)
+			return nullptr;
+
+		Serializer::ResetObjectToDefaults(InTargets[InIndex]);
+		return InTargets[InIndex];
+	}, false);
+	return bResult && objects.Num() == InTargets.Num();
+}
+
+bool UDataSerializerLib::DeSerializeObjectsIntoByKey(const TArray<uint8>& InBytes, const TMap<FString, UObject*>& InTargets)
+{
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_Deserialize);
+	FMemoryReader reader(InBytes, true);
+	FDataSerializerObjectIndex index;
+	if (!index.Read(reader) || !index.HasKeys())
+		return false;
+
+	int32 numLoaded = 0;
+	for (const TPair<FString, UObject*>& pair : InTargets)
+	{
+		const int32 record = index.FindByKey(pair.Key);
+		if (record == INDEX_NONE || !IsValid(pair.Value) || pair.Value->GetClass() != index.GetClass(record))
+			break;
+
+		Serializer::ResetObjectToDefaults(pair.Value);
+		if (!index.DeSerializeInto(reader, record, pair.Value))
+			break;
+		++numLoaded;
+	}
+	Serializer::RecordObjects(numLoaded);
+	return numLoaded == InTargets.Num();
+}
+
+bool UDataSerializerLib::DeSerializeObjectsPooled(const TArray<uint8>& InBytes, UObject* InObjectOuter,
+                                                  UDataSerializerObjectPool* InPool, TArray<UObject*>& OutObjects)
+{
+	OutObjects.Empty();
+	FMemoryReader reader(InBytes, true);
+	return DeSerializeObjectsPooledCpp(reader, InObjectOuter, InPool, OutObjects);
+}
+
+bool UDataSerializerLib::DeSerializeObjectsPooledCpp(FArchive& InReader, UObject* InObjectOuter,
+                                                     UDataSerializerObjectPool* InPool, TArray<UObject*>& OutObjects)
+{
+	if (InPool == nullptr)
+		return DeSerializeObjectsCpp(InReader, InObjectOuter, OutObjects);
+
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_Deserialize);
+	Serializer::FScopedReadCounter counter(InReader, &OutObjects);
+	return Serializer::ReadObjects(InReader, InObjectOuter, OutObjects, [InPool, InObjectOuter](UClass* InClass, int32 InIndex)
+	{
+		return InPool->Acquire(InClass, InObjectOuter);
+	}, false);
+}
+
+bool UDataSerializerLib::SerializeObjectGraph(TArray<uint8>& OutBytes, TArray<UObject*> InObjects)
+{
+	ensure(InObjects.Num() > 0);
+	OutBytes.Empty();
+	FMemoryWriter writer(OutBytes, true);
+	return SerializeObjectGraphCpp(writer, InObjects);
+}
+
+bool UDataSerializerLib::SerializeObjectGraphCpp(FMemoryWriter& InWriter, TArrayView<UObject* const> InObjects)
+{
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_Serialize);
+	const int64 start = InWriter.Tell();
+	const bool bResult = Serializer::WriteObjectGraph(InWriter, InObjects);
+	Serializer::RecordBytesOut(InWriter.Tell() - start);
+	Serializer::RecordObjects(InObjects.Num());
+	return bResult;
+}
+
+bool UDataSerializerLib::SerializeObjectsIndexed(TArray<uint8>& OutBytes, TArray<UObject*> InObjects,
+                                                 bool bUseObjectNamesAsKeys)
+{
+	ensure(InObjects.Num() > 0);
+	OutBytes.Empty();
+	FMemoryWriter writer(OutBytes, true);
+
+	TArray<FString> keys;
+	if (bUseObjectNamesAsKeys)
+	{
+		keys.Reserve(InObjects.Num());
+		for (UObject* object : InObjects)
 		{
-			gameClass = LoadObject<UClass>(nullptr, *header.GameClassName);
+			keys.Add(IsValid(object) ? object->GetName() : FString());
 		}
+	}
+	return SerializeObjectsIndexedCpp(writer, InObjects, keys);
+}
 
-		// If we have a class, try and load it.
-		if (gameClass != nullptr)
-		{
-			UObject* resObject = nullptr;
-			resObject = NewObject<UObject>(InObjectOuter, gameClass);
+bool UDataSerializerLib::SerializeObjectsIndexedWithKeys(TArray<uint8>& OutBytes, TArray<UObject*> InObjects,
+                                                         const TArray<FString>& InKeys)
+{
+	ensure(InObjects.Num() > 0);
+	OutBytes.Empty();
+	if (InKeys.Num() != InObjects.Num())
+		return false;
 
-			FObjectAndNameAsStringProxyArchive archive(InReader, true);
-			resObject->Serialize(archive);
-			OutObjects.Add(resObject);
-		}
-		else
-		{
+	FMemoryWriter writer(OutBytes, true);
+	return SerializeObjectsIndexedCpp(writer, InObjects, InKeys);
+}
+
+bool UDataSerializerLib::SerializeObjectsIndexedCpp(FMemoryWriter& InWriter, TArrayView<UObject* const> InObjects,
+                                                    TArrayView<const FString> InKeys)
+{
+	if (InKeys.Num() > 0 && InKeys.Num() != InObjects.Num())
+		return false;
+
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_Serialize);
+	const int64 start = InWriter.Tell();
+	Serializer::FClassTable classTable;
+	TArray<FDataSerializerObjectIndex::FEntry> entries;
+	entries.SetNum(InObjects.Num());
+	for (int32 i = 0; i < InObjects.Num(); ++i)
+	{
+		if (!IsValid(InObjects[i]))
 			return false;
-		}
+		entries[i].ClassIndex = classTable.Add(InObjects[i]->GetClass());
+	}
+
+	int32 tag = XEUS_OBJECT_INDEX_TAG;
+	uint8 version = FDataSerializerObjectIndex::CurrentVersion;
+	uint8 flags = InKeys.Num() > 0 ? Serializer::ObjectIndexHasKeys : 0;
+	InWriter << tag;
+	InWriter << version;
+	InWriter << flags;
+	classTable.Write(InWriter);
+
+	uint32 n = InObjects.Num();
+	InWriter.SerializeIntPacked(n);
+	for (const FString& key : InKeys)
+	{
+		InWriter << const_cast<FString&>(key);
+	}
+
+	// Reserve the record table, it is filled once the records are written
+	const int64 tableStart = InWriter.Tell();
+	for (FDataSerializerObjectIndex::FEntry& entry : entries)
+	{
+		InWriter << entry;
 	}
 
-	if (OutObjects.Num() != n)
+	const int64 dataStart = InWriter.Tell();
+	for (int32 i = 0; i < InObjects.Num(); ++i)
 	{
+		const int64 recordStart = InWriter.Tell();
+		if (!Serializer::WriteObjectData(InWriter, InObjects[i]))
+			return false;
+		entries[i].Offset = recordStart - dataStart;
+		entries[i].Size = InWriter.Tell() - recordStart;
+	}
+
+	const int64 dataEnd = InWriter.Tell();
+	InWriter.Seek(tableStart);
+	for (FDataSerializerObjectIndex::FEntry& entry : entries)
+	{
+		InWriter << entry;
+	}
+	InWriter.Seek(dataEnd);
+
+	Serializer::RecordBytesOut(dataEnd - start);
+	Serializer::RecordObjects(InObjects.Num());
+	return !InWriter.IsError();
+}
+
+int32 UDataSerializerLib::GetIndexedObjectCount(const TArray<uint8>& InBytes)
+{
+	FMemoryReader reader(InBytes, true);
+	FDataSerializerObjectIndex index;
+	return index.Read(reader) ? index.Num() : INDEX_NONE;
+}
+
+bool UDataSerializerLib::DeSerializeIndexedObject(const TArray<uint8>& InBytes, int32 InIndex, UObject* InObjectOuter,
+                                                  UObject*& OutObject)
+{
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_Deserialize);
+	OutObject = nullptr;
+	FMemoryReader reader(InBytes, true);
+	FDataSerializerObjectIndex index;
+	const bool bResult = index.Read(reader) && index.DeSerializeObject(reader, InIndex, InObjectOuter, OutObject);
+	Serializer::RecordObjects(bResult ? 1 : 0);
+	return bResult;
+}
+
+bool UDataSerializerLib::DeSerializeIndexedObjectByKey(const TArray<uint8>& InBytes, const FString& InKey,
+                                                       UObject* InObjectOuter, UObject*& OutObject)
+{
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_Deserialize);
+	OutObject = nullptr;
+	FMemoryReader reader(InBytes, true);
+	FDataSerializerObjectIndex index;
+	if (!index.Read(reader))
 		return false;
+
+	const int32 recordIndex = index.FindByKey(InKey);
+	const bool bResult = recordIndex != INDEX_NONE
+		&& index.DeSerializeObject(reader, recordIndex, InObjectOuter, OutObject);
+	Serializer::RecordObjects(bResult ? 1 : 0);
+	return bResult;
+}
+
+bool UDataSerializerLib::DeSerializeIndexedObjectRange(const TArray<uint8>& InBytes, int32 InFirst, int32 InCount,
+                                                       UObject* InObjectOuter, TArray<UObject*>& OutObjects)
+{
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_Deserialize);
+	OutObjects.Empty();
+	FMemoryReader reader(InBytes, true);
+	FDataSerializerObjectIndex index;
+	const bool bResult = index.Read(reader)
+		&& index.DeSerializeObjects(reader, InFirst, InCount, InObjectOuter, OutObjects);
+	Serializer::RecordObjects(OutObjects.Num());
+	return bResult;
+}
+
+UClass* UDataSerializerLib::ResolveClassCpp(const FString& InClassPath)
+{
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_ResolveClass);
+	const FSoftClassPath classPath(InClassPath);
+	{
+		FScopeLock lock(&Serializer::ClassCacheLock);
+		if (const TWeakObjectPtr<UClass>* cached = Serializer::ClassCache.Find(classPath))
+		{
+			if (UClass* cachedClass = cached->Get())
+			{
+				Serializer::RecordClassLookup(true);
+				return cachedClass;
+			}
+		}
 	}
+	Serializer::RecordClassLookup(false);
 
-	return true;
+	// Try and find it, and failing that, load it
+	UClass* gameClass = FindObject<UClass>(nullptr, *InClassPath);
+	if (gameClass == nullptr && IsInGameThread())
+	{
+		gameClass = LoadObject<UClass>(nullptr, *InClassPath);
+	}
+
+	if (gameClass != nullptr)
+	{
+		FScopeLock lock(&Serializer::ClassCacheLock);
+		Serializer::ClassCache.Add(classPath, gameClass);
+	}
+	return gameClass;
+}
+
+void UDataSerializerLib::ClearClassCache()
+{
+	{
+		FScopeLock lock(&Serializer::ClassCacheLock);
+		Serializer::ClassCache.Empty();
+	}
+	Serializer::ClearSchemaCache();
 }
 
 void UDataSerializerLib::GetUtf8Bytes(const FString& InString, TArray<uint8>& OutBytes)
@@ -0,0 +1,589 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Libs/DataSerializerObjectData.h"
+
+#include "Libs/DataSerializerLib.h"
+#include "Libs/DataSerializerSchema.h"
+#include "Serialization/ArchiveProxy.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+#include "Serialization/StructuredArchiveAdapters.h"
+#include "UObject/UnrealType.h"
+
+namespace Serializer
+{
+	/**
+	 * Written in front of object data that uses name and object tables.
+	 * Object data written before starts with a tagged property name string, never with this value.
+	 */
+	constexpr int32 ObjectTablesTag = -0x78657554; //-XEUT
+
+	/** Same as ObjectTablesTag for the objects of a graph, object references also carry graph IDs. */
+	constexpr int32 ObjectGraphTablesTag = -0x78657552; //-XEUR
+
+	/** Same as ObjectTablesTag for the SaveGame properties written from the class layout (see WriteObjectSchemaData). */
+	constexpr int32 ObjectSchemaTablesTag = -0x7865754D; //-XEUM
+
+	/**
+	 * Proxy archive that writes every FName, object reference and soft path once in per-blob tables
+	 * and refers to them by index. Replaces FObjectAndNameAsStringProxyArchive, which writes them as
+	 * full strings at every occurrence and looks them up again on every load.
+	 */
+	class FObjectTableArchive : public FArchiveProxy
+	{
+	public:
+		FObjectTableArchive(FArchive& InInnerArchive, const FObjectGraph* InGraph)
+			: FArchiveProxy(InInnerArchive), Graph(InGraph)
+		{
+		}
+
+		virtual FString GetArchiveName() const override { return TEXT("FObjectTableArchive"); }
+
+		virtual FArchive& operator<<(FName& Value) override
+		{
+			uint32 index = 0;
+			if (IsLoading())
+			{
+				InnerArchive.SerializeIntPacked(index);
+				if (Names.IsValidIndex(index))
+				{
+					Value = Names[index];
+				}
+				else
+				{
+					SetError();
+				}
+			}
+			else
+			{
+				index = AddEntry(Names, NameIndices, Value);
+				InnerArchive.SerializeIntPacked(index);
+			}
+			return *this;
+		}
+
+		virtual FArchive& operator<<(UObject*& Value) override
+		{
+			// 0 is null, entries are shifted by one.
+			// In a graph the lowest bit tells graph IDs (1) from table entries (0).
+			uint32 index = 0;
+			if (IsLoading())
+			{
+				InnerArchive.SerializeIntPacked(index);
+				const bool bGraphId = Graph != nullptr && (index & 1) != 0;
+				const uint32 entry = Graph != nullptr ? index >> 1 : index;
+				const TArray<UObject*>& entries = bGraphId ? Graph->Objects : Objects;
+				if (index == 0)
+				{
+					Value = nullptr;
+				}
+				else if (entries.IsValidIndex(entry - 1))
+				{
+					Value = entries[entry - 1];
+				}
+				else
+				{
+					SetError();
+				}
+			}
+			else if (Value != nullptr)
+			{
+				const uint32* graphId = Graph != nullptr ? Graph->Ids.Find(Value) : nullptr;
+				if (graphId != nullptr)
+				{
+					index = *graphId << 1 | 1;
+				}
+				else
+				{
+					index = AddEntry(Objects, ObjectIndices, Value) + 1;
+					index = Graph != nullptr ? index << 1 : index;
+				}
+				InnerArchive.SerializeIntPacked(index);
+			}
+			else
+			{
+				InnerArchive.SerializeIntPacked(index);
+			}
+			return *this;
+		}
+
+		virtual FArchive& operator<<(FObjectPtr& Value) override
+		{
+			UObject* object = Value.Get();
+			*this << object;
+			if (IsLoading())
+			{
+				Value = FObjectPtr(object);
+			}
+			return *this;
+		}
+
+		virtual FArchive& operator<<(FWeakObjectPtr& Value) override
+		{
+			UObject* object = Value.Get(true);
+			*this << object;
+			if (IsLoading())
+			{
+				Value = object;
+			}
+			return *this;
+		}
+
+		virtual FArchive& operator<<(FSoftObjectPath& Value) override
+		{
+			uint32 index = 0;
+			if (IsLoading())
+			{
+				InnerArchive.SerializeIntPacked(index);
+				if (SoftPaths.IsValidIndex(index))
+				{
+					Value.SetPath(SoftPaths[index]);
+				}
+				else
+				{
+					SetError();
+				}
+			}
+			else
+			{
+				index = AddEntry(SoftPaths, SoftPathIndices, Value.ToString());
+				InnerArchive.SerializeIntPacked(index);
+			}
+			return *this;
+		}
+
+		virtual FArchive& operator<<(FSoftObjectPtr& Value) override
+		{
+			FSoftObjectPath path = Value.ToSoftObjectPath();
+			*this << path;
+			if (IsLoading())
+			{
+				Value = FSoftObjectPtr(path);
+			}
+			return *this;
+		}
+
+		/** Writes the collected tables. */
+		void WriteTables(FArchive& InWriter)
+		{
+			uint32 n = Names.Num();
+			InWriter.SerializeIntPacked(n);
+			for (const FName& name : Names)
+			{
+				FString string = name.ToString();
+				InWriter << string;
+			}
+
+			n = Objects.Num();
+			InWriter.SerializeIntPacked(n);
+			for (UObject* object : Objects)
+			{
+				FString path = object->GetPathName();
+				InWriter << path;
+			}
+
+			n = SoftPaths.Num();
+			InWriter.SerializeIntPacked(n);
+			for (FString& path : SoftPaths)
+			{
+				InWriter << path;
+			}
+		}
+
+		/** Reads the tables, every name and object is resolved once here. */
+		bool ReadTables(FArchive& InReader)
+		{
+			TArray<FString> strings;
+			if (!ReadStrings(InReader, strings))
+				return false;
+			Names.Reset(strings.Num());
+			for (const FString& string : strings)
+			{
+				Names.Add(FName(*string));
+			}
+
+			if (!ReadStrings(InReader, strings))
+				return false;
+			Objects.Reset(strings.Num());
+			for (const FString& path : strings)
+			{
+				// Same lookup as FObjectAndNameAsStringProxyArchive with bLoadIfFindFails
+				UObject* object = FindObject<UObject>(nullptr, *path);
+				if (object == nullptr)
+				{
+					object = LoadObject<UObject>(nullptr, *path);
+				}
+				Objects.Add(object);
+			}
+
+			return ReadStrings(InReader, SoftPaths);
+		}
+
+	private:
+		template <typename T, typename KeyType>
+		static uint32 AddEntry(TArray<T>& InOutEntries, TMap<T, uint32>& InOutIndices, const KeyType& InValue)
+		{
+			if (const uint32* index = InOutIndices.Find(InValue))
+				return *index;
+
+			const uint32 index = InOutEntries.Add(InValue);
+			InOutIndices.Add(InValue, index);
+			return index;
+		}
+
+		static bool ReadStrings(FArchive& InReader, TArray<FString>& OutStrings)
+		{
+			uint32 n = 0;
+			InReader.SerializeIntPacked(n);
+			if (InReader.IsError() || n > static_cast<uint32>(InReader.TotalSize() - InReader.Tell()))
+				return false;
+
+			OutStrings.SetNum(n);
+			for (FString& string : OutStrings)
+			{
+				InReader << string;
+			}
+			return !InReader.IsError();
+		}
+
+		TArray<FName> Names;
+		TMap<FName, uint32> NameIndices;
+		TArray<UObject*> Objects;
+		TMap<UObject*, uint32> ObjectIndices;
+		TArray<FString> SoftPaths;
+		TMap<FString, uint32> SoftPathIndices;
+		const FObjectGraph* Graph = nullptr;
+	};
+
+	/**
+	 * Writes data through an FObjectTableArchive: tag, offset of the tables, data, tables.
+	 * @param InWriter Seekable archive to write to.
+	 * @param InTag Tag telling how the data was written.
+	 * @param InGraph Graph the data belongs to, may be null.
+	 * @param InBody Writes the data to the given archive.
+	 * @return true on success.
+	 */
+	static bool WriteWithTables(FArchive& InWriter, int32 InTag, const FObjectGraph* InGraph,
+	                            TFunctionRef<bool(FArchive&)> InBody)
+	{
+		InWriter << InTag;
+
+		// The tables are written after the data, their offset is patched once it is known
+		const int64 offsetPos = InWriter.Tell();
+		int64 offset = 0;
+		InWriter << offset;
+
+		FObjectTableArchive archive(InWriter, InGraph);
+		const bool bResult = InBody(archive);
+
+		const int64 tablesPos = InWriter.Tell();
+		archive.WriteTables(InWriter);
+		const int64 end = InWriter.Tell();
+
+		offset = tablesPos - offsetPos;
+		InWriter.Seek(offsetPos);
+		InWriter << offset;
+		InWriter.Seek(end);
+		return bResult && !archive.GetError() && !InWriter.IsError();
+	}
+
+	/**
+	 * Reads data written by WriteWithTables, the reader is positioned after the tag.
+	 * @param InReader Seekable archive to read from, left after the tables.
+	 * @param InGraph Graph the data belongs to, may be null.
+	 * @param InBody Reads the data from the given archive.
+	 * @return true on success.
+	 */
+	static bool ReadWithTables(FArchive& InReader, const FObjectGraph* InGraph, TFunctionRef<bool(FArchive&)> InBody)
+	{
+		const int64 offsetPos = InReader.Tell();
+		int64 offset = 0;
+		InReader << offset;
+		const int64 dataStart = InReader.Tell();
+		const int64 tablesPos = offsetPos + offset;
+		if (InReader.IsError() || tablesPos < dataStart || tablesPos > InReader.TotalSize())
+			return false;
+
+		FObjectTableArchive archive(InReader, InGraph);
+		InReader.Seek(tablesPos);
+		if (!archive.ReadTables(InReader))
+			return false;
+		const int64 end = InReader.Tell();
+
+		InReader.Seek(dataStart);
+		const bool bResult = InBody(archive);
+		const bool bInBounds = InReader.Tell() <= tablesPos;
+		InReader.Seek(end);
+		return bResult && bInBounds && !archive.GetError();
+	}
+
+	bool WriteObjectData(FArchive& InWriter, UObject* InObject, const FObjectGraph* InGraph)
+	{
+		const int32 tag = InGraph != nullptr ? ObjectGraphTablesTag : ObjectTablesTag;
+		return WriteWithTables(InWriter, tag, InGraph, [InObject](FArchive& InArchive)
+		{
+			InObject->Serialize(InArchive);
+			return true;
+		});
+	}
+
+	bool WriteObjectSchemaData(FArchive& InWriter, UObject* InObject)
+	{
+		return WriteWithTables(InWriter, ObjectSchemaTablesTag, nullptr, [InObject](FArchive& InArchive)
+		{
+			return WriteSchemaData(InArchive, InObject);
+		});
+	}
+
+	bool ReadObjectData(FArchive& InReader, UObject* InObject, const FObjectGraph* InGraph,
+	                    const FSchemaDescriptor* InSchema)
+	{
+		auto body = [InObject](FArchive& InArchive)
+		{
+			InObject->Serialize(InArchive);
+			return true;
+		};
+
+		const int64 start = InReader.Tell();
+		int32 tag = 0;
+		InReader << tag;
+		if (tag == ObjectTablesTag)
+			return ReadWithTables(InReader, nullptr, body);
+
+		if (tag == ObjectGraphTablesTag)
+			return InGraph != nullptr && ReadWithTables(InReader, InGraph, body);
+
+		if (tag == ObjectSchemaTablesTag)
+		{
+			return ReadWithTables(InReader, nullptr, [InObject, InSchema](FArchive& InArchive)
+			{
+				return ReadSchemaData(InArchive, InObject, InSchema);
+			});
+		}
+
+		// Written before the tables, names and objects are strings
+		InReader.Seek(start);
+		FObjectAndNameAsStringProxyArchive archive(InReader, true);
+		body(archive);
+		return !archive.GetError();
+	}
+
+	void ResetObjectToDefaults(UObject* InObject)
+	{
+		const UObject* archetype = InObject->GetArchetype();
+		if (archetype == nullptr || archetype->GetClass() != InObject->GetClass())
+			return;
+
+		for (TFieldIterator<FProperty> it(InObject->GetClass()); it; ++it)
+		{
+			if (!it->HasAnyPropertyFlags(CPF_Transient | CPF_Deprecated | CPF_SkipSerialization
+				| CPF_InstancedReference | CPF_ContainsInstancedReference))
+			{
+				it->CopyCompleteValue_InContainer(InObject, archetype);
+			}
+		}
+	}
+
+	/** Properties a delta can refer to, their position in the list is the property index. */
+	static void GetDeltaProperties(UClass* InClass, TArray<FProperty*>& OutProperties)
+	{
+		for (TFieldIterator<FProperty> it(InClass); it; ++it)
+		{
+			if (!it->HasAnyPropertyFlags(CPF_Transient | CPF_Deprecated | CPF_SkipSerialization))
+			{
+				OutProperties.Add(*it);
+			}
+		}
+	}
+
+	/** Serializes every element of a property through the proxy archive. */
+	static void SerializeDeltaProperty(FArchive& InArchive, FProperty* InProperty, void* InContainer)
+	{
+		for (int32 i = 0; i < InProperty->ArrayDim; ++i)
+		{
+			FStructuredArchiveFromArchive structuredArchive(InArchive);
+			InProperty->SerializeItem(structuredArchive.GetSlot(), InProperty->ContainerPtrToValuePtr<void>(InContainer, i));
+		}
+	}
+
+	/** Writes the changed properties: count, then index, size and value of each. */
+	static bool WriteDeltaRecords(FArchive& InArchive, const TArray<FProperty*>& InProperties, UObject* InObject,
+	                              const UObject* InBaseline)
+	{
+		// The record count is patched once the changed properties are known
+		const int64 countPos = InArchive.Tell();
+		int32 count = 0;
+		InArchive << count;
+
+		for (int32 i = 0; i < InProperties.Num(); ++i)
+		{
+			FProperty* property = InProperties[i];
+			bool bIdentical = true;
+			for (int32 j = 0; j < property->ArrayDim && bIdentical; ++j)
+			{
+				bIdentical = property->Identical_InContainer(InObject, InBaseline, j);
+			}
+			if (bIdentical)
+				continue;
+
+			// Index and size first, so readers can skip records they do not need
+			uint32 index = i;
+			InArchive.SerializeIntPacked(index);
+			const int64 sizePos = InArchive.Tell();
+			int32 size = 0;
+			InArchive << size;
+
+			SerializeDeltaProperty(InArchive, property, InObject);
+
+			const int64 end = InArchive.Tell();
+			size = static_cast<int32>(end - sizePos - sizeof(size));
+			InArchive.Seek(sizePos);
+			InArchive << size;
+			InArchive.Seek(end);
+			++count;
+		}
+
+		const int64 end = InArchive.Tell();
+		InArchive.Seek(countPos);
+		InArchive << count;
+		InArchive.Seek(end);
+		return !InArchive.IsError();
+	}
+
+	/** Reads the records written by WriteDeltaRecords. */
+	static bool ReadDeltaRecords(FArchive& InArchive, const TArray<FProperty*>& InProperties, UObject* InObject)
+	{
+		int32 count = 0;
+		InArchive << count;
+		if (InArchive.IsError() || count < 0 || count > InProperties.Num())
+			return false;
+
+		for (int32 i = 0; i < count; ++i)
+		{
+			uint32 index = 0;
+			int32 size = 0;
+			InArchive.SerializeIntPacked(index);
+			InArchive << size;
+			if (InArchive.IsError() || !InProperties.IsValidIndex(index) || size < 0
+				|| size > InArchive.TotalSize() - InArchive.Tell())
+				return false;
+
+			const int64 start = InArchive.Tell();
+			SerializeDeltaProperty(InArchive, InProperties[index], InObject);
+			if (InArchive.IsError() || InArchive.Tell() != start + size)
+				return false;
+		}
+		return true;
+	}
+
+	uint32 GetDeltaLayoutHash(UClass* InClass)
+	{
+		TArray<FProperty*> properties;
+		GetDeltaProperties(InClass, properties);
+
+		uint32 hash = 0;
+		for (FProperty* property : properties)
+		{
+			hash = FCrc::StrCrc32(*property->GetName(), hash);
+			hash = FCrc::StrCrc32(*property->GetCPPType(), hash);
+		}
+		return hash;
+	}
+
+	bool WriteObjectDelta(FArchive& InWriter, UObject* InObject, const UObject* InBaseline)
+	{
+		TArray<FProperty*> properties;
+		GetDeltaProperties(InObject->GetClass(), properties);
+
+		uint8 version = ObjectDeltaVersion;
+		InWriter << version;
+
+		return WriteWithTables(InWriter, ObjectTablesTag, nullptr, [&](FArchive& InArchive)
+		{
+			return WriteDeltaRecords(InArchive, properties, InObject, InBaseline);
+		});
+	}
+
+	bool ReadObjectDelta(FArchive& InReader, UObject* InObject)
+	{
+		TArray<FProperty*> properties;
+		GetDeltaProperties(InObject->GetClass(), properties);
+
+		uint8 version = 0;
+		int32 tag = 0;
+		InReader << version;
+		InReader << tag;
+		if (InReader.IsError() || version != ObjectDeltaVersion || tag != ObjectTablesTag)
+			return false;
+
+		return ReadWithTables(InReader, nullptr, [&](FArchive& InArchive)
+		{
+			return ReadDeltaRecords(InArchive, properties, InObject);
+		});
+	}
+
+	uint32 FClassTable::Add(UClass* InClass)
+	{
+		if (const uint32* index = Indices.Find(InClass))
+			return *index;
+
+		const uint32 index = Classes.Add(InClass);
+		Indices.Add(InClass, index);
+		return index;
+	}
+
+	void FClassTable::Write(FArchive& InWriter) const
+	{
+		uint32 n = Classes.Num();
+		InWriter.SerializeIntPacked(n);
+		for (UClass* objectClass : Classes)
+		{
+			FString path = objectClass->GetPathName();
+			InWriter << path;
+		}
+	}
+
+	bool FClassTable::Read(FArchive& InReader, TArray<UClass*>& OutClasses)
+	{
+		uint32 n = 0;
+		InReader.SerializeIntPacked(n);
+		if (InReader.IsError() || n > static_cast<uint32>(InReader.TotalSize() - InReader.Tell()))
+			return false;
+
+		OutClasses.SetNumZeroed(n);
+		for (uint32 i = 0; i < n; ++i)
+		{
+			FString path;
+			InReader << path;
+			OutClasses[i] = UDataSerializerLib::ResolveClassCpp(path);
+		}
+		return !InReader.IsError();
+	}
+
+	bool FObjectBatchHeader::Read(FArchive& InReader)
+	{
+		uint8 version = 0;
+		uint8 flags = 0;
+		InReader << version;
+		InReader << flags;
+		if (version != ObjectBatchVersion)
+			return false;
+
+		// Every class is resolved once per batch
+		ClassTablePos = InReader.Tell();
+		if (InReader.IsError() || !FClassTable::Read(InReader, Classes))
+			return false;
+
+		Schemas.Reset();
+		if (flags & ObjectBatchHasSchemas)
+		{
+			Schemas.SetNum(Classes.Num());
+			for (FSchemaDescriptor& schema : Schemas)
+			{
+				if (!ReadSchemaDescriptor(InReader, schema))
+					return false;
+			}
+		}
+		return true;
+	}
+}
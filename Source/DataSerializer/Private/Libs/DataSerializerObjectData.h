@@ -0,0 +1,130 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Libs/DataSerializerSchema.h"
+
+namespace Serializer
+{
+	/** Version of the object batch format written by SerializeObjects, followed by the batch flags. */
+	constexpr uint8 ObjectBatchVersion = 2;
+
+	/** Flag of object batches, a schema descriptor is stored for every class (see SerializeObjectsWithSchema). */
+	constexpr uint8 ObjectBatchHasSchemas = 1 << 0;
+
+	/** Flag of indexed object archives, a key is stored for every record. */
+	constexpr uint8 ObjectIndexHasKeys = 1 << 0;
+
+	/** Objects serialized together, references between them are written as IDs (see SerializeObjectGraph). */
+	struct FObjectGraph
+	{
+		/** Objects in creation order, outers before their subobjects. */
+		TArray<UObject*> Objects;
+
+		/** ID of each object: index in Objects + 1. */
+		TMap<UObject*, uint32> Ids;
+	};
+
+	/**
+	 * Saves the object state, names and object refs are written once in tables and referred to by index.
+	 * @param InWriter The archive to write to.
+	 * @param InObject The object to save.
+	 * @param InGraph Graph the object belongs to, references to its objects are written as IDs.
+	 * @return true on success.
+	 */
+	bool WriteObjectData(FArchive& InWriter, UObject* InObject, const FObjectGraph* InGraph = nullptr);
+
+	/**
+	 * Saves only the SaveGame properties, values are written straight from the cached class layout
+	 * instead of going through tagged property serialization. Loaded by ReadObjectData.
+	 * @param InWriter The archive to write to.
+	 * @param InObject The object to save.
+	 * @return true on success.
+	 */
+	bool WriteObjectSchemaData(FArchive& InWriter, UObject* InObject);
+
+	/**
+	 * Loads the object state written by WriteObjectData or WriteObjectSchemaData.
+	 * @param InReader The archive to read from.
+	 * @param InObject The object to load into.
+	 * @param InGraph Graph the object belongs to, must match the one used when writing.
+	 * @param InSchema Descriptor of the class written with the batch, used if the layout of the class changed.
+	 * @return true on success.
+	 */
+	bool ReadObjectData(FArchive& InReader, UObject* InObject, const FObjectGraph* InGraph = nullptr,
+	                    const FSchemaDescriptor* InSchema = nullptr);
+
+	/**
+	 * Sets the saved properties of an object back to its archetype values, before a full state is loaded into it.
+	 * Values equal to the archetype are not written by tagged serialization, loading alone would leave stale values.
+	 * Instanced references are left alone, so default subobjects stay owned by the object.
+	 * @param InObject The object to reset.
+	 */
+	void ResetObjectToDefaults(UObject* InObject);
+
+	/** Version of the property delta format written after a delta FSerializationHeader. */
+	constexpr uint8 ObjectDeltaVersion = 1;
+
+	/**
+	 * Hashes the names and types of the properties a delta can refer to.
+	 * @param InClass The class of the object.
+	 * @return The hash stored in delta headers.
+	 */
+	uint32 GetDeltaLayoutHash(UClass* InClass);
+
+	/**
+	 * Saves the properties of an object that differ from a baseline, keyed by property index.
+	 * @param InWriter The archive to write to.
+	 * @param InObject The object to save.
+	 * @param InBaseline Object of the same class to compare against.
+	 * @return true on success.
+	 */
+	bool WriteObjectDelta(FArchive& InWriter, UObject* InObject, const UObject* InBaseline);
+
+	/**
+	 * Loads the properties written by WriteObjectDelta, the other properties are left untouched.
+	 * @param InReader The archive to read from.
+	 * @param InObject The object to patch.
+	 * @return true on success.
+	 */
+	bool ReadObjectDelta(FArchive& InReader, UObject* InObject);
+
+	/** Deduplicated list of the classes of a batch of objects. */
+	struct FClassTable
+	{
+		/** Adds a class if needed, returns its index. */
+		uint32 Add(UClass* InClass);
+
+		/** Writes the class paths. */
+		void Write(FArchive& InWriter) const;
+
+		/** Reads the class paths and resolves each of them once. */
+		static bool Read(FArchive& InReader, TArray<UClass*>& OutClasses);
+
+		TArray<UClass*> Classes;
+		TMap<UClass*, uint32> Indices;
+	};
+
+	/** Start of an object batch written by SerializeObjects, after XEUS_OBJECT_BATCH_TAG. */
+	struct FObjectBatchHeader
+	{
+		/** Reads the version, the class table and the schema descriptors. */
+		bool Read(FArchive& InReader);
+
+		/** Gets the descriptor of a class of the table, null if the batch has none. */
+		const FSchemaDescriptor* GetSchema(int32 InClassIndex) const
+		{
+			return Schemas.IsValidIndex(InClassIndex) ? &Schemas[InClassIndex] : nullptr;
+		}
+
+		/** Resolved classes, nullptr for those that could not be found. */
+		TArray<UClass*> Classes;
+
+		/** One descriptor per class, empty if the batch was not written with schemas. */
+		TArray<FSchemaDescriptor> Schemas;
+
+		/** Position of the class table, it can be read again with FClassTable::Read. */
+		int64 ClassTablePos = 0;
+	};
+}
@@ -0,0 +1,281 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Libs/DataSerializerObjectGraph.h"
+
+#include "Libs/DataSerializerLib.h"
+#include "Serialization/ArchiveSerializedPropertyChain.h"
+#include "Serialization/ArchiveUObject.h"
+#include "UObject/Package.h"
+
+namespace Serializer
+{
+	/** Object referenced by a graph object. */
+	struct FGraphReference
+	{
+		UObject* Object = nullptr;
+
+		/** Referenced through an instanced or SaveGame property, the referencing object owns its state. */
+		bool bOwned = false;
+	};
+
+	/** Flags of the properties whose references are followed into the graph. */
+	constexpr EPropertyFlags GraphPropertyFlags = CPF_SaveGame | CPF_InstancedReference
+		| CPF_ContainsInstancedReference;
+
+	/** Records the objects referenced by an object, the same way the garbage collector finds them. */
+	class FGraphReferenceCollector : public FArchiveUObject
+	{
+	public:
+		explicit FGraphReferenceCollector(TArray<FGraphReference>& OutReferences) : References(OutReferences)
+		{
+			SetIsSaving(true);
+			ArIsObjectReferenceCollector = true;
+			ArShouldSkipBulkData = true;
+		}
+
+		virtual FArchive& operator<<(UObject*& Value) override
+		{
+			if (Value != nullptr)
+			{
+				References.Add({Value, IsOwningReference()});
+			}
+			return *this;
+		}
+
+		virtual FString GetArchiveName() const override { return TEXT("FGraphReferenceCollector"); }
+
+	private:
+		/** @return true if the property being serialized, or a container holding it, is instanced or SaveGame. */
+		bool IsOwningReference() const
+		{
+			const FProperty* property = GetSerializedProperty();
+			if (property != nullptr && property->HasAnyPropertyFlags(GraphPropertyFlags))
+				return true;
+
+			if (const FArchiveSerializedPropertyChain* chain = GetSerializedPropertyChain())
+			{
+				for (int32 i = 0; i < chain->GetNumProperties(); ++i)
+				{
+					if (chain->GetPropertyFromStack(i)->HasAnyPropertyFlags(GraphPropertyFlags))
+						return true;
+				}
+			}
+			return false;
+		}
+
+		TArray<FGraphReference>& References;
+	};
+
+	/**
+	 * Tells if a referenced object belongs in the graph: it is owned by a root (outer chain)
+	 * or referenced through an instanced or SaveGame property.
+	 * Objects outside of it are written by path and must be found again on load.
+	 */
+	static bool IsGraphObject(const FGraphReference& InReference, const TSet<UObject*>& InRoots)
+	{
+		const UObject* object = InReference.Object;
+		if (!IsValid(object) || object->IsA<UField>() || object->IsA<UPackage>()
+			|| object->HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject))
+			return false;
+
+		if (InReference.bOwned)
+			return true;
+
+		for (UObject* outer = object->GetOuter(); outer != nullptr; outer = outer->GetOuter())
+		{
+			if (InRoots.Contains(outer))
+				return true;
+		}
+		return false;
+	}
+
+	bool CollectObjectGraph(TArrayView<UObject* const> InRoots, FObjectGraph& OutGraph)
+	{
+		TSet<UObject*> roots;
+		for (UObject* root : InRoots)
+		{
+			if (!IsValid(root))
+				return false;
+			roots.Add(root);
+		}
+		TSet<UObject*> found = roots;
+
+		// Walk the references, subobjects are referenced by their outers so those are found first
+		TArray<UObject*> pending(InRoots.GetData(), InRoots.Num());
+		TArray<FGraphReference> references;
+		while (pending.Num() > 0)
+		{
+			UObject* object = pending.Pop(false);
+			references.Reset();
+			FGraphReferenceCollector collector(references);
+			object->Serialize(collector);
+
+			for (const FGraphReference& reference : references)
+			{
+				if (!found.Contains(reference.Object) && IsGraphObject(reference, roots))
+				{
+					found.Add(reference.Object);
+					pending.Add(reference.Object);
+				}
+			}
+		}
+
+		// Creation order: every object after its outers, roots first
+		OutGraph.Objects.Reset(found.Num());
+		OutGraph.Ids.Reset();
+		TArray<UObject*> chain;
+		auto place = [&](UObject* InObject)
+		{
+			chain.Reset();
+			for (UObject* object = InObject; object != nullptr && found.Contains(object); object = object->GetOuter())
+			{
+				if (OutGraph.Ids.Contains(object))
+					break;
+				chain.Add(object);
+			}
+			for (int32 i = chain.Num() - 1; i >= 0; --i)
+			{
+				OutGraph.Ids.Add(chain[i], OutGraph.Objects.Add(chain[i]) + 1);
+			}
+		};
+		for (UObject* root : InRoots)
+		{
+			place(root);
+		}
+		for (UObject* object : found)
+		{
+			place(object);
+		}
+		return true;
+	}
+
+	bool WriteObjectGraph(FArchive& InWriter, TArrayView<UObject* const> InRoots)
+	{
+		FObjectGraph graph;
+		if (!CollectObjectGraph(InRoots, graph))
+			return false;
+
+		FClassTable classTable;
+		for (UObject* object : graph.Objects)
+		{
+			classTable.Add(object->GetClass());
+		}
+
+		int32 tag = XEUS_OBJECT_GRAPH_TAG;
+		uint8 version = ObjectGraphVersion;
+		InWriter << tag;
+		InWriter << version;
+		classTable.Write(InWriter);
+
+		// Entries: class, outer ID (0 for the outer given on load) and name, enough to create every object first
+		uint32 n = graph.Objects.Num();
+		InWriter.SerializeIntPacked(n);
+		for (UObject* object : graph.Objects)
+		{
+			uint32 classIndex = classTable.Indices[object->GetClass()];
+			const uint32* outerId = graph.Ids.Find(object->GetOuter());
+			uint32 outer = outerId != nullptr ? *outerId : 0;
+			FString name = object->GetName();
+			InWriter.SerializeIntPacked(classIndex);
+			InWriter.SerializeIntPacked(outer);
+			InWriter << name;
+		}
+
+		uint32 numRoots = InRoots.Num();
+		InWriter.SerializeIntPacked(numRoots);
+		for (UObject* root : InRoots)
+		{
+			uint32 id = graph.Ids[root];
+			InWriter.SerializeIntPacked(id);
+		}
+
+		for (UObject* object : graph.Objects)
+		{
+			if (!WriteObjectData(InWriter, object, &graph))
+				return false;
+		}
+		return !InWriter.IsError();
+	}
+
+	/**
+	 * Finds or creates a graph object.
+	 * Subobjects created by their outer's constructor (default subobjects) are reused, so they keep their identity.
+	 */
+	static UObject* CreateGraphObject(UClass* InClass, UObject* InOuter, const FString& InName, bool bInGraphOuter)
+	{
+		// Roots are created under an outer we do not own, their names could already be taken there
+		if (!bInGraphOuter)
+			return NewObject<UObject>(InOuter, InClass);
+
+		const FName name(*InName);
+		UObject* existing = StaticFindObjectFast(nullptr, InOuter, name, true);
+		if (existing != nullptr && existing->GetClass() == InClass)
+			return existing;
+		if (existing != nullptr)
+			return NewObject<UObject>(InOuter, InClass, MakeUniqueObjectName(InOuter, InClass, name));
+		return NewObject<UObject>(InOuter, InClass, name);
+	}
+
+	bool ReadObjectGraph(FArchive& InReader, UObject* InOuter, TArray<UObject*>& OutRoots)
+	{
+		uint8 version = 0;
+		InReader << version;
+		if (version != ObjectGraphVersion)
+			return false;
+
+		TArray<UClass*> classes;
+		if (!FClassTable::Read(InReader, classes))
+			return false;
+
+		uint32 n = 0;
+		InReader.SerializeIntPacked(n);
+		if (InReader.IsError() || n > static_cast<uint32>(InReader.TotalSize() - InReader.Tell()))
+			return false;
+
+		// Outers come first, so every object can be created as soon as its entry is read
+		FObjectGraph graph;
+		graph.Objects.Reserve(n);
+		for (uint32 i = 0; i < n; ++i)
+		{
+			uint32 classIndex = 0;
+			uint32 outer = 0;
+			FString name;
+			InReader.SerializeIntPacked(classIndex);
+			InReader.SerializeIntPacked(outer);
+			InReader << name;
+			if (InReader.IsError() || !classes.IsValidIndex(classIndex) || classes[classIndex] == nullptr
+				|| outer > i)
+				return false;
+
+			UObject* outerObject = outer != 0 ? graph.Objects[outer - 1] : InOuter;
+			graph.Objects.Add(CreateGraphObject(classes[classIndex], outerObject, name, outer != 0));
+		}
+
+		uint32 numRoots = 0;
+		InReader.SerializeIntPacked(numRoots);
+		if (InReader.IsError() || numRoots > n)
+			return false;
+
+		TArray<UObject*> roots;
+		roots.Reserve(numRoots);
+		for (uint32 i = 0; i < numRoots; ++i)
+		{
+			uint32 id = 0;
+			InReader.SerializeIntPacked(id);
+			if (id == 0 || id > n)
+				return false;
+			roots.Add(graph.Objects[id - 1]);
+		}
+
+		// References are resolved by ID, all the objects exist by now
+		for (UObject* object : graph.Objects)
+		{
+			if (!ReadObjectData(InReader, object, &graph))
+				return false;
+		}
+
+		OutRoots.Append(roots);
+		return !InReader.IsError();
+	}
+}
@@ -0,0 +1,40 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Libs/DataSerializerObjectData.h"
+
+namespace Serializer
+{
+	/** Version byte written after XEUS_OBJECT_GRAPH_TAG. */
+	constexpr uint8 ObjectGraphVersion = 1;
+
+	/**
+	 * Collects the roots and the objects reachable from them that they own,
+	 * i.e. objects whose outer chain leads to a root, and objects referenced through instanced or SaveGame properties.
+	 * Any other reference is written by path.
+	 * @param InRoots The objects to start from.
+	 * @param OutGraph Filled with the objects in creation order.
+	 * @return false if a root is invalid.
+	 */
+	bool CollectObjectGraph(TArrayView<UObject* const> InRoots, FObjectGraph& OutGraph);
+
+	/**
+	 * Writes XEUS_OBJECT_GRAPH_TAG, the class table, one entry per graph object and then the data of every object,
+	 * each object once whatever the number of references to it.
+	 * @param InWriter Seekable archive to write to.
+	 * @param InRoots The objects to serialize with their subobjects.
+	 * @return true on success.
+	 */
+	bool WriteObjectGraph(FArchive& InWriter, TArrayView<UObject* const> InRoots);
+
+	/**
+	 * Creates the graph objects, then loads their data with references between them restored.
+	 * @param InReader Seekable archive positioned after XEUS_OBJECT_GRAPH_TAG.
+	 * @param InOuter Outer of the roots.
+	 * @param OutRoots The roots are appended to it.
+	 * @return true on success.
+	 */
+	bool ReadObjectGraph(FArchive& InReader, UObject* InOuter, TArray<UObject*>& OutRoots);
+}
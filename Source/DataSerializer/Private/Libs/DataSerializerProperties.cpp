@@ -0,0 +1,191 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Libs/DataSerializerProperties.h"
+
+#include "Libs/DataSerializerSchema.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+#include "Serialization/StructuredArchiveAdapters.h"
+#include "UObject/UnrealType.h"
+
+namespace Serializer
+{
+	/** Serializes a value through tagged serialization, names and objects as strings. */
+	static void SerializeTaggedValue(FArchive& InArchive, const FProperty* InProperty, void* InValue)
+	{
+		FObjectAndNameAsStringProxyArchive archive(InArchive, true);
+		FStructuredArchiveFromArchive structuredArchive(archive);
+		InProperty->SerializeItem(structuredArchive.GetSlot(), InValue);
+	}
+
+	/** Reads a container count, every element takes at least one byte. */
+	static bool ReadCount(FArchive& InReader, int32& OutCount)
+	{
+		uint32 count = 0;
+		InReader.SerializeIntPacked(count);
+		if (InReader.IsError() || count > static_cast<uint64>(InReader.TotalSize() - InReader.Tell()))
+			return false;
+
+		OutCount = static_cast<int32>(count);
+		return true;
+	}
+
+	uint32 GetPropertyTypeHash(const FProperty* InProperty)
+	{
+		FString extendedType;
+		const FString type = InProperty->GetCPPType(&extendedType);
+		return FCrc::StrCrc32(*(type + extendedType), static_cast<uint32>(InProperty->ElementSize));
+	}
+
+	void WritePropertyValue(FArchive& InWriter, const FProperty* InProperty, const void* InValue)
+	{
+		if (IsSchemaPod(InProperty))
+		{
+			InWriter.Serialize(const_cast<void*>(InValue), InProperty->ElementSize);
+			return;
+		}
+
+		if (const FArrayProperty* arrayProperty = CastField<const FArrayProperty>(InProperty))
+		{
+			FScriptArrayHelper helper(arrayProperty, InValue);
+			uint32 count = helper.Num();
+			InWriter.SerializeIntPacked(count);
+			if (count > 0 && IsSchemaPod(arrayProperty->Inner))
+			{
+				// Elements are contiguous, the whole array is a single block
+				InWriter.Serialize(helper.GetRawPtr(0), static_cast<int64>(count) * arrayProperty->Inner->ElementSize);
+				return;
+			}
+			for (uint32 i = 0; i < count; ++i)
+			{
+				WritePropertyValue(InWriter, arrayProperty->Inner, helper.GetRawPtr(i));
+			}
+			return;
+		}
+
+		if (const FSetProperty* setProperty = CastField<const FSetProperty>(InProperty))
+		{
+			FScriptSetHelper helper(setProperty, InValue);
+			uint32 count = helper.Num();
+			InWriter.SerializeIntPacked(count);
+			for (int32 i = 0, left = static_cast<int32>(count); left > 0; ++i)
+			{
+				if (helper.IsValidIndex(i))
+				{
+					WritePropertyValue(InWriter, setProperty->ElementProp, helper.GetElementPtr(i));
+					--left;
+				}
+			}
+			return;
+		}
+
+		if (const FMapProperty* mapProperty = CastField<const FMapProperty>(InProperty))
+		{
+			FScriptMapHelper helper(mapProperty, InValue);
+			uint32 count = helper.Num();
+			InWriter.SerializeIntPacked(count);
+			for (int32 i = 0, left = static_cast<int32>(count); left > 0; ++i)
+			{
+				if (helper.IsValidIndex(i))
+				{
+					WritePropertyValue(InWriter, mapProperty->KeyProp, helper.GetKeyPtr(i));
+					WritePropertyValue(InWriter, mapProperty->ValueProp, helper.GetValuePtr(i));
+					--left;
+				}
+			}
+			return;
+		}
+
+		SerializeTaggedValue(InWriter, InProperty, const_cast<void*>(InValue));
+	}
+
+	static bool ReadValue(FArchive& InReader, const FProperty* InProperty, void* OutValue)
+	{
+		if (IsSchemaPod(InProperty))
+		{
+			InReader.Serialize(OutValue, InProperty->ElementSize);
+			return !InReader.IsError();
+		}
+
+		if (const FArrayProperty* arrayProperty = CastField<const FArrayProperty>(InProperty))
+		{
+			int32 count = 0;
+			if (!ReadCount(InReader, count))
+				return false;
+
+			FScriptArrayHelper helper(arrayProperty, OutValue);
+			if (IsSchemaPod(arrayProperty->Inner))
+			{
+				helper.EmptyAndAddUninitializedValues(count);
+				if (count > 0)
+				{
+					InReader.Serialize(helper.GetRawPtr(0), static_cast<int64>(count) * arrayProperty->Inner->ElementSize);
+				}
+				return !InReader.IsError();
+			}
+
+			helper.EmptyAndAddValues(count);
+			for (int32 i = 0; i < count; ++i)
+			{
+				if (!ReadValue(InReader, arrayProperty->Inner, helper.GetRawPtr(i)))
+					return false;
+			}
+			return true;
+		}
+
+		if (const FSetProperty* setProperty = CastField<const FSetProperty>(InProperty))
+		{
+			int32 count = 0;
+			if (!ReadCount(InReader, count))
+				return false;
+
+			FScriptSetHelper helper(setProperty, OutValue);
+			helper.EmptyElements(count);
+			for (int32 i = 0; i < count; ++i)
+			{
+				const int32 index = helper.AddDefaultValue_Invalid_NeedsRehash();
+				if (!ReadValue(InReader, setProperty->ElementProp, helper.GetElementPtr(index)))
+				{
+					helper.Rehash();
+					return false;
+				}
+			}
+			helper.Rehash();
+			return true;
+		}
+
+		if (const FMapProperty* mapProperty = CastField<const FMapProperty>(InProperty))
+		{
+			int32 count = 0;
+			if (!ReadCount(InReader, count))
+				return false;
+
+			FScriptMapHelper helper(mapProperty, OutValue);
+			helper.EmptyValues(count);
+			for (int32 i = 0; i < count; ++i)
+			{
+				const int32 index = helper.AddDefaultValue_Invalid_NeedsRehash();
+				if (!ReadValue(InReader, mapProperty->KeyProp, helper.GetKeyPtr(index))
+					|| !ReadValue(InReader, mapProperty->ValueProp, helper.GetValuePtr(index)))
+				{
+					helper.Rehash();
+					return false;
+				}
+			}
+			helper.Rehash();
+			return true;
+		}
+
+		SerializeTaggedValue(InReader, InProperty, OutValue);
+		return !InReader.IsError();
+	}
+
+	bool ReadPropertyValue(FArchive& InReader, const FProperty* InProperty, void* OutValue)
+	{
+		if (ReadValue(InReader, InProperty, OutValue))
+			return true;
+
+		InProperty->ClearValue(OutValue);
+		return false;
+	}
+}
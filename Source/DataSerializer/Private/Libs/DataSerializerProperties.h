@@ -0,0 +1,55 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Stack.h"
+#include "UObject/UnrealType.h"
+
+namespace Serializer
+{
+	/**
+	 * Hashes the type of a property, written before its value so it is only read back into the same type.
+	 * @param InProperty The property.
+	 * @return The hash of its C++ type and size.
+	 */
+	uint32 GetPropertyTypeHash(const FProperty* InProperty);
+
+	/**
+	 * Writes a single value of a property (one element of a static array).
+	 *
+	 * Plain old data is copied as is, arrays, sets and maps write their count then each element the same way,
+	 * arrays of plain old data in one block. Other values (structs with names, objects or strings...) go through
+	 * tagged serialization with names and objects written as strings.
+	 *
+	 * @param InWriter The archive to write to.
+	 * @param InProperty The property describing the value.
+	 * @param InValue Address of the value.
+	 */
+	void WritePropertyValue(FArchive& InWriter, const FProperty* InProperty, const void* InValue);
+
+	/**
+	 * Reads a value written by WritePropertyValue.
+	 * @param InReader The archive to read from.
+	 * @param InProperty The property describing the value, of the type it was written with.
+	 * @param OutValue Address of the value, cleared on failure.
+	 * @return true on success.
+	 */
+	bool ReadPropertyValue(FArchive& InReader, const FProperty* InProperty, void* OutValue);
+
+	/**
+	 * Steps over the wildcard parameter of a CustomThunk function.
+	 * @param Stack The frame of the call.
+	 * @param OutValue Address of the value.
+	 * @return The property of the parameter, nullptr if it is not a TProperty.
+	 */
+	template <typename TProperty>
+	TProperty* StepWildcardParam(FFrame& Stack, void*& OutValue)
+	{
+		Stack.MostRecentProperty = nullptr;
+		Stack.MostRecentPropertyAddress = nullptr;
+		Stack.StepCompiledIn<TProperty>(nullptr);
+		OutValue = Stack.MostRecentPropertyAddress;
+		return CastField<TProperty>(Stack.MostRecentProperty);
+	}
+}
@@ -0,0 +1,257 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Libs/DataSerializerQuantization.h"
+
+namespace Serializer
+{
+	/** Bits of each of the three smallest quaternion components. */
+	constexpr int32 SmallestThreeBits = 15;
+	constexpr int32 SmallestThreeMax = (1 << SmallestThreeBits) - 1;
+	constexpr double SmallestThreeScale = 1.4142135623730950488; // sqrt(2)
+
+	/** Scale modes of quantized transforms. */
+	enum class EQuantizedScale : uint8
+	{
+		One,
+		Uniform,
+		NonUniform
+	};
+
+	FQuantizedRange::FQuantizedRange(double InPrecision, double InRange)
+	{
+		Precision = InPrecision > 0.0 ? InPrecision : 1.0;
+		const double maxCode = FMath::CeilToDouble(FMath::Abs(InRange) / Precision);
+
+		// Codes are stored in at most 4 bytes, larger ranges are limited to MAX_int32 steps
+		ensureMsgf(maxCode <= MAX_int32, TEXT("Quantization range %f does not fit 31 bits at precision %f"),
+		           InRange, Precision);
+		MaxCode = static_cast<int64>(FMath::Min(maxCode, static_cast<double>(MAX_int32)));
+		NumBytes = MaxCode <= MAX_int8 ? 1 : MaxCode <= MAX_int16 ? 2 : MaxCode <= 0x7FFFFF ? 3 : 4;
+	}
+
+	int64 FQuantizedRange::Quantize(double InValue) const
+	{
+		const double code = FMath::RoundToDouble(InValue / Precision);
+		return static_cast<int64>(FMath::Clamp(code, static_cast<double>(-MaxCode), static_cast<double>(MaxCode)));
+	}
+
+	void FQuantizedRange::Write(FArchive& InWriter, int64 InCode) const
+	{
+		// Little endian two's complement, truncated to NumBytes
+		uint8 buffer[sizeof(int32)];
+		for (int32 i = 0; i < NumBytes; ++i)
+		{
+			buffer[i] = static_cast<uint8>(static_cast<uint64>(InCode) >> (8 * i));
+		}
+		InWriter.Serialize(buffer, NumBytes);
+	}
+
+	bool FQuantizedRange::Read(FArchive& InReader, int64& OutCode) const
+	{
+		uint8 buffer[sizeof(int32)];
+		InReader.Serialize(buffer, NumBytes);
+		if (InReader.IsError())
+			return false;
+
+		uint64 value = 0;
+		for (int32 i = 0; i < NumBytes; ++i)
+		{
+			value |= static_cast<uint64>(buffer[i]) << (8 * i);
+		}
+
+		// Sign extend
+		const int32 shift = 64 - 8 * NumBytes;
+		OutCode = static_cast<int64>(value << shift) >> shift;
+		return OutCode >= -MaxCode && OutCode <= MaxCode;
+	}
+
+	void WriteQuantizedVector(FArchive& InWriter, const FVector& InVector, const FQuantizedRange& InRange)
+	{
+		InRange.Write(InWriter, InRange.Quantize(InVector.X));
+		InRange.Write(InWriter, InRange.Quantize(InVector.Y));
+		InRange.Write(InWriter, InRange.Quantize(InVector.Z));
+	}
+
+	bool ReadQuantizedVector(FArchive& InReader, FVector& OutVector, const FQuantizedRange& InRange)
+	{
+		int64 x = 0;
+		int64 y = 0;
+		int64 z = 0;
+		if (!InRange.Read(InReader, x) || !InRange.Read(InReader, y) || !InRange.Read(InReader, z))
+			return false;
+
+		OutVector = FVector(InRange.Dequantize(x), InRange.Dequantize(y), InRange.Dequantize(z));
+		return true;
+	}
+
+	void WriteCompressedRotator(FArchive& InWriter, const FRotator& InRotator)
+	{
+		uint16 pitch = FRotator::CompressAxisToShort(InRotator.Pitch);
+		uint16 yaw = FRotator::CompressAxisToShort(InRotator.Yaw);
+		uint16 roll = FRotator::CompressAxisToShort(InRotator.Roll);
+		InWriter << pitch;
+		InWriter << yaw;
+		InWriter << roll;
+	}
+
+	bool ReadCompressedRotator(FArchive& InReader, FRotator& OutRotator)
+	{
+		uint16 pitch = 0;
+		uint16 yaw = 0;
+		uint16 roll = 0;
+		InReader << pitch;
+		InReader << yaw;
+		InReader << roll;
+		if (InReader.IsError())
+			return false;
+
+		OutRotator = FRotator(FRotator::DecompressAxisFromShort(pitch), FRotator::DecompressAxisFromShort(yaw),
+		                      FRotator::DecompressAxisFromShort(roll));
+		return true;
+	}
+
+	void WriteSmallestThree(FArchive& InWriter, const FQuat& InQuat)
+	{
+		FQuat quat = InQuat.GetNormalized();
+		double components[4] = {quat.X, quat.Y, quat.Z, quat.W};
+
+		int32 largest = 0;
+		for (int32 i = 1; i < 4; ++i)
+		{
+			if (FMath::Abs(components[i]) > FMath::Abs(components[largest]))
+			{
+				largest = i;
+			}
+		}
+
+		// q and -q are the same rotation, keep the dropped component positive
+		const double sign = components[largest] < 0.0 ? -1.0 : 1.0;
+
+		uint64 packed = largest;
+		int32 shift = 2;
+		for (int32 i = 0; i < 4; ++i)
+		{
+			if (i == largest)
+				continue;
+
+			// The other components are within [-1/sqrt(2), 1/sqrt(2)]
+			const double value = components[i] * sign * SmallestThreeScale;
+			const int64 code = FMath::Clamp<int64>(FMath::RoundToInt64((value + 1.0) * 0.5 * SmallestThreeMax), 0,
+			                                       SmallestThreeMax);
+			packed |= static_cast<uint64>(code) << shift;
+			shift += SmallestThreeBits;
+		}
+
+		uint8 buffer[6];
+		for (int32 i = 0; i < 6; ++i)
+		{
+			buffer[i] = static_cast<uint8>(packed >> (8 * i));
+		}
+		InWriter.Serialize(buffer, 6);
+	}
+
+	bool ReadSmallestThree(FArchive& InReader, FQuat& OutQuat)
+	{
+		uint8 buffer[6];
+		InReader.Serialize(buffer, 6);
+		if (InReader.IsError())
+			return false;
+
+		uint64 packed = 0;
+		for (int32 i = 0; i < 6; ++i)
+		{
+			packed |= static_cast<uint64>(buffer[i]) << (8 * i);
+		}
+
+		const int32 largest = packed & 3;
+		double components[4];
+		double sum = 0.0;
+		int32 shift = 2;
+		for (int32 i = 0; i < 4; ++i)
+		{
+			if (i == largest)
+				continue;
+
+			const int64 code = (packed >> shift) & SmallestThreeMax;
+			components[i] = (static_cast<double>(code) / SmallestThreeMax * 2.0 - 1.0) / SmallestThreeScale;
+			sum += components[i] * components[i];
+			shift += SmallestThreeBits;
+		}
+		components[largest] = FMath::Sqrt(FMath::Max(0.0, 1.0 - sum));
+
+		OutQuat = FQuat(components[0], components[1], components[2], components[3]);
+		return true;
+	}
+
+	void WriteQuantizedTransform(FArchive& InWriter, const FTransform& InTransform,
+	                             const FQuantizedRange& InTranslationRange, const FQuantizedRange& InScaleRange)
+	{
+		WriteSmallestThree(InWriter, InTransform.GetRotation());
+		WriteQuantizedVector(InWriter, InTransform.GetTranslation(), InTranslationRange);
+
+		// The scale mode is picked from the quantized values, so the round trip stays exact
+		const FVector scale = InTransform.GetScale3D();
+		const int64 x = InScaleRange.Quantize(scale.X);
+		const int64 y = InScaleRange.Quantize(scale.Y);
+		const int64 z = InScaleRange.Quantize(scale.Z);
+
+		EQuantizedScale mode = EQuantizedScale::NonUniform;
+		if (x == y && y == z)
+		{
+			mode = x == InScaleRange.Quantize(1.0) ? EQuantizedScale::One : EQuantizedScale::Uniform;
+		}
+
+		uint8 modeByte = static_cast<uint8>(mode);
+		InWriter << modeByte;
+		if (mode == EQuantizedScale::Uniform)
+		{
+			InScaleRange.Write(InWriter, x);
+		}
+		else if (mode == EQuantizedScale::NonUniform)
+		{
+			InScaleRange.Write(InWriter, x);
+			InScaleRange.Write(InWriter, y);
+			InScaleRange.Write(InWriter, z);
+		}
+	}
+
+	bool ReadQuantizedTransform(FArchive& InReader, FTransform& OutTransform,
+	                            const FQuantizedRange& InTranslationRange, const FQuantizedRange& InScaleRange)
+	{
+		FQuat rotation;
+		FVector translation;
+		if (!ReadSmallestThree(InReader, rotation) || !ReadQuantizedVector(InReader, translation, InTranslationRange))
+			return false;
+
+		uint8 modeByte = 0;
+		InReader << modeByte;
+		if (InReader.IsError())
+			return false;
+
+		FVector scale = FVector::OneVector;
+		switch (static_cast<EQuantizedScale>(modeByte))
+		{
+		case EQuantizedScale::One:
+			scale = FVector(InScaleRange.Dequantize(InScaleRange.Quantize(1.0)));
+			break;
+		case EQuantizedScale::Uniform:
+			{
+				int64 code = 0;
+				if (!InScaleRange.Read(InReader, code))
+					return false;
+				scale = FVector(InScaleRange.Dequantize(code));
+				break;
+			}
+		case EQuantizedScale::NonUniform:
+			if (!ReadQuantizedVector(InReader, scale, InScaleRange))
+				return false;
+			break;
+		default:
+			return false;
+		}
+
+		OutTransform = FTransform(rotation, translation, scale);
+		return true;
+	}
+}
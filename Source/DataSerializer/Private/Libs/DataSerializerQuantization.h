@@ -0,0 +1,63 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace Serializer
+{
+	/**
+	 * Fixed-point encoding of values in [-Range, Range] with a step of Precision.
+	 * The byte width depends only on the parameters, so writer and reader agree on it.
+	 * Range / Precision must fit in 31 bits, the effective range is otherwise MAX_int32 * Precision.
+	 */
+	struct FQuantizedRange
+	{
+		FQuantizedRange(double InPrecision, double InRange);
+
+		/** Quantizes a value, out of range values are clamped. */
+		int64 Quantize(double InValue) const;
+
+		/** Restores a quantized value. */
+		double Dequantize(int64 InCode) const { return InCode * Precision; }
+
+		/** Writes a quantized value in NumBytes bytes. */
+		void Write(FArchive& InWriter, int64 InCode) const;
+
+		/** Reads a quantized value written by Write. */
+		bool Read(FArchive& InReader, int64& OutCode) const;
+
+		double Precision = 1.0;
+		int64 MaxCode = 0;
+		int32 NumBytes = 1;
+	};
+
+	/** Writes a vector as three fixed-point values. */
+	void WriteQuantizedVector(FArchive& InWriter, const FVector& InVector, const FQuantizedRange& InRange);
+
+	/** Reads a vector written by WriteQuantizedVector. */
+	bool ReadQuantizedVector(FArchive& InReader, FVector& OutVector, const FQuantizedRange& InRange);
+
+	/** Writes a rotator as three 16-bit angles (FRotator::CompressAxisToShort). */
+	void WriteCompressedRotator(FArchive& InWriter, const FRotator& InRotator);
+
+	/** Reads a rotator written by WriteCompressedRotator. */
+	bool ReadCompressedRotator(FArchive& InReader, FRotator& OutRotator);
+
+	/** Writes a rotation in 6 bytes: index of the largest component and the three others in 15 bits each. */
+	void WriteSmallestThree(FArchive& InWriter, const FQuat& InQuat);
+
+	/** Reads a rotation written by WriteSmallestThree. */
+	bool ReadSmallestThree(FArchive& InReader, FQuat& OutQuat);
+
+	/**
+	 * Writes a transform as a smallest-three rotation, a quantized translation and a quantized scale.
+	 * Unit and uniform scales are stored as a single flag byte (plus one value for uniform scales).
+	 */
+	void WriteQuantizedTransform(FArchive& InWriter, const FTransform& InTransform,
+	                             const FQuantizedRange& InTranslationRange, const FQuantizedRange& InScaleRange);
+
+	/** Reads a transform written by WriteQuantizedTransform. */
+	bool ReadQuantizedTransform(FArchive& InReader, FTransform& OutTransform,
+	                            const FQuantizedRange& InTranslationRange, const FQuantizedRange& InScaleRange);
+}
@@ -0,0 +1,235 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Libs/DataSerializerSchema.h"
+
+#include "Serialization/StructuredArchiveAdapters.h"
+#include "UObject/UnrealType.h"
+
+namespace Serializer
+{
+	static FArchive& operator<<(FArchive& Ar, FSchemaDescriptor::FEntry& Entry)
+	{
+		Ar << Entry.Name;
+		Ar << Entry.TypeHash;
+		Ar.SerializeIntPacked(Entry.Size);
+		Ar << Entry.bPod;
+		return Ar;
+	}
+
+	/** Cached layouts, shared by every serialization call. */
+	FCriticalSection SchemaCacheLock;
+	TMap<TWeakObjectPtr<UClass>, TSharedRef<const FSchemaLayout, ESPMode::ThreadSafe>> SchemaCache;
+
+	bool IsSchemaPod(const FProperty* InProperty)
+	{
+		if (!InProperty->HasAnyPropertyFlags(CPF_IsPlainOldData)
+			|| InProperty->IsA<FNameProperty>() || InProperty->IsA<FObjectPropertyBase>())
+			return false;
+
+		const FBoolProperty* boolProperty = CastField<const FBoolProperty>(InProperty);
+		return boolProperty == nullptr || boolProperty->IsNativeBool();
+	}
+
+	/** Hashes what a value of the property looks like, values are only read back into matching properties. */
+	static uint32 GetSchemaTypeHash(const FProperty* InProperty, bool bInPod)
+	{
+		uint32 hash = FCrc::StrCrc32(*InProperty->GetCPPType());
+		const int32 sizes[] = {InProperty->ArrayDim, InProperty->ElementSize, bInPod ? 1 : 0};
+		return FCrc::MemCrc32(sizes, sizeof(sizes), hash);
+	}
+
+	/** Serializes every element of a property through the archive. */
+	static void SerializeSchemaProperty(FArchive& InArchive, FProperty* InProperty, void* InContainer)
+	{
+		for (int32 i = 0; i < InProperty->ArrayDim; ++i)
+		{
+			FStructuredArchiveFromArchive structuredArchive(InArchive);
+			InProperty->SerializeItem(structuredArchive.GetSlot(), InProperty->ContainerPtrToValuePtr<void>(InContainer, i));
+		}
+	}
+
+	static TSharedRef<const FSchemaLayout, ESPMode::ThreadSafe> BuildSchemaLayout(UClass* InClass)
+	{
+		TSharedRef<FSchemaLayout, ESPMode::ThreadSafe> layout = MakeShared<FSchemaLayout, ESPMode::ThreadSafe>();
+		for (TFieldIterator<FProperty> it(InClass); it; ++it)
+		{
+			if (it->HasAnyPropertyFlags(CPF_SaveGame) && !it->HasAnyPropertyFlags(CPF_Transient | CPF_Deprecated))
+			{
+				layout->Properties.Add(*it);
+			}
+		}
+
+		for (int32 i = 0; i < layout->Properties.Num(); ++i)
+		{
+			const FProperty* property = layout->Properties[i];
+			const int32 offset = property->GetOffset_ForInternal();
+			const bool bPod = IsSchemaPod(property);
+
+			// Grow the previous run when this property follows it in memory
+			FSchemaLayout::FRun* last = layout->Runs.Num() > 0 ? &layout->Runs.Last() : nullptr;
+			if (bPod && last != nullptr && last->bPod && last->Offset + last->Size == offset)
+			{
+				last->Size += property->GetSize();
+				++last->NumProperties;
+			}
+			else
+			{
+				FSchemaLayout::FRun& run = layout->Runs.AddDefaulted_GetRef();
+				run.Offset = offset;
+				run.Size = property->GetSize();
+				run.FirstProperty = i;
+				run.NumProperties = 1;
+				run.bPod = bPod;
+			}
+
+			layout->Hash = FCrc::StrCrc32(*property->GetName(), layout->Hash);
+			const uint32 values[] = {GetSchemaTypeHash(property, bPod), static_cast<uint32>(offset)};
+			layout->Hash = FCrc::MemCrc32(values, sizeof(values), layout->Hash);
+		}
+		return layout;
+	}
+
+	TSharedRef<const FSchemaLayout, ESPMode::ThreadSafe> GetSchemaLayout(UClass* InClass)
+	{
+		FScopeLock lock(&SchemaCacheLock);
+		if (const TSharedRef<const FSchemaLayout, ESPMode::ThreadSafe>* layout = SchemaCache.Find(InClass))
+			return *layout;
+
+		return SchemaCache.Add(InClass, BuildSchemaLayout(InClass));
+	}
+
+	void ClearSchemaCache()
+	{
+		FScopeLock lock(&SchemaCacheLock);
+		SchemaCache.Empty();
+	}
+
+	void WriteSchemaDescriptor(FArchive& InArchive, UClass* InClass)
+	{
+		const TSharedRef<const FSchemaLayout, ESPMode::ThreadSafe> layout = GetSchemaLayout(InClass);
+
+		TArray<FSchemaDescriptor::FEntry> entries;
+		entries.Reserve(layout->Properties.Num());
+		for (const FSchemaLayout::FRun& run : layout->Runs)
+		{
+			for (int32 i = run.FirstProperty; i < run.FirstProperty + run.NumProperties; ++i)
+			{
+				const FProperty* property = layout->Properties[i];
+				FSchemaDescriptor::FEntry& entry = entries.AddDefaulted_GetRef();
+				entry.Name = property->GetName();
+				entry.TypeHash = GetSchemaTypeHash(property, run.bPod);
+				entry.Size = run.bPod ? property->GetSize() : 0;
+				entry.bPod = run.bPod;
+			}
+		}
+		InArchive << entries;
+	}
+
+	bool ReadSchemaDescriptor(FArchive& InArchive, FSchemaDescriptor& OutDescriptor)
+	{
+		InArchive << OutDescriptor.Entries;
+		return !InArchive.IsError();
+	}
+
+	bool WriteSchemaData(FArchive& InArchive, UObject* InObject)
+	{
+		const TSharedRef<const FSchemaLayout, ESPMode::ThreadSafe> layout = GetSchemaLayout(InObject->GetClass());
+		uint8* objectData = reinterpret_cast<uint8*>(InObject);
+
+		uint32 hash = layout->Hash;
+		InArchive << hash;
+		for (const FSchemaLayout::FRun& run : layout->Runs)
+		{
+			if (run.bPod)
+			{
+				// Raw memory, every supported platform is little endian
+				InArchive.Serialize(objectData + run.Offset, run.Size);
+				continue;
+			}
+
+			// The size is patched once the value is written
+			const int64 sizePos = InArchive.Tell();
+			uint32 size = 0;
+			InArchive << size;
+			SerializeSchemaProperty(InArchive, layout->Properties[run.FirstProperty], InObject);
+
+			const int64 end = InArchive.Tell();
+			size = static_cast<uint32>(end - sizePos - sizeof(size));
+			InArchive.Seek(sizePos);
+			InArchive << size;
+			InArchive.Seek(end);
+		}
+		return !InArchive.IsError();
+	}
+
+	/** Reads the values property by property through the descriptor, values without a matching property are skipped. */
+	static bool ReadSchemaValuesByName(FArchive& InArchive, UObject* InObject, const FSchemaDescriptor& InDescriptor)
+	{
+		uint8* objectData = reinterpret_cast<uint8*>(InObject);
+		for (const FSchemaDescriptor::FEntry& entry : InDescriptor.Entries)
+		{
+			uint32 size = entry.Size;
+			if (!entry.bPod)
+			{
+				InArchive << size;
+			}
+
+			const int64 start = InArchive.Tell();
+			if (InArchive.IsError() || start + size > InArchive.TotalSize())
+				return false;
+
+			FProperty* property = FindFProperty<FProperty>(InObject->GetClass(), *entry.Name);
+			if (property == nullptr || !property->HasAnyPropertyFlags(CPF_SaveGame)
+				|| GetSchemaTypeHash(property, IsSchemaPod(property)) != entry.TypeHash)
+			{
+				InArchive.Seek(start + size);
+				continue;
+			}
+
+			if (entry.bPod)
+			{
+				InArchive.Serialize(objectData + property->GetOffset_ForInternal(), size);
+			}
+			else
+			{
+				SerializeSchemaProperty(InArchive, property, InObject);
+			}
+			if (InArchive.IsError() || InArchive.Tell() != start + size)
+				return false;
+		}
+		return true;
+	}
+
+	bool ReadSchemaData(FArchive& InArchive, UObject* InObject, const FSchemaDescriptor* InDescriptor)
+	{
+		const TSharedRef<const FSchemaLayout, ESPMode::ThreadSafe> layout = GetSchemaLayout(InObject->GetClass());
+
+		uint32 hash = 0;
+		InArchive << hash;
+		if (InArchive.IsError())
+			return false;
+
+		// Written with another layout of the class, match the values by property name
+		if (hash != layout->Hash)
+			return InDescriptor != nullptr && ReadSchemaValuesByName(InArchive, InObject, *InDescriptor);
+
+		uint8* objectData = reinterpret_cast<uint8*>(InObject);
+		for (const FSchemaLayout::FRun& run : layout->Runs)
+		{
+			if (run.bPod)
+			{
+				InArchive.Serialize(objectData + run.Offset, run.Size);
+				continue;
+			}
+
+			uint32 size = 0;
+			InArchive << size;
+			const int64 start = InArchive.Tell();
+			SerializeSchemaProperty(InArchive, layout->Properties[run.FirstProperty], InObject);
+			if (InArchive.Tell() != start + size)
+				return false;
+		}
+		return !InArchive.IsError();
+	}
+}
@@ -0,0 +1,113 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace Serializer
+{
+	/**
+	 * Flat list of the SaveGame properties of a class, built once per class (see GetSchemaLayout).
+	 * Adjacent plain old data properties are merged into runs written as one memory block.
+	 */
+	struct FSchemaLayout
+	{
+		/** Contiguous block of plain old data, or a single property written through SerializeItem. */
+		struct FRun
+		{
+			/** Offset of the run in the object. */
+			int32 Offset = 0;
+
+			/** Size of the run in bytes. */
+			int32 Size = 0;
+
+			/** First property of the run in Properties. */
+			int32 FirstProperty = 0;
+
+			/** Number of properties in the run, always 1 for other data. */
+			int32 NumProperties = 0;
+
+			/** Set if the memory of the run is copied as is. */
+			bool bPod = false;
+		};
+
+		/** CPF_SaveGame properties, in class order. */
+		TArray<FProperty*> Properties;
+
+		/** Runs covering every property, in the order they are written. */
+		TArray<FRun> Runs;
+
+		/** Hash of the names, types and offsets of the properties, written with the data. */
+		uint32 Hash = 0;
+	};
+
+	/**
+	 * Tells if the memory of a property can be copied as is.
+	 * Names and object pointers are only meaningful in this process, bitfields share their byte with other members.
+	 */
+	bool IsSchemaPod(const FProperty* InProperty);
+
+	/**
+	 * Gets the layout of a class, building it on first use.
+	 * @param InClass The class to get the layout of.
+	 * @return The cached layout, it stays valid after ClearSchemaCache.
+	 */
+	TSharedRef<const FSchemaLayout, ESPMode::ThreadSafe> GetSchemaLayout(UClass* InClass);
+
+	/** Drops every cached layout, call after classes changed (hot reload, Blueprint compile). */
+	void ClearSchemaCache();
+
+	/**
+	 * Values written by WriteSchemaData for a class, in write order. Written once per class with a batch of objects
+	 * and used by readers whose class layout changed since, to match the values by property name and type.
+	 */
+	struct FSchemaDescriptor
+	{
+		struct FEntry
+		{
+			FString Name;
+			uint32 TypeHash = 0;
+
+			/** Size of plain old data values, other values are prefixed with their size. */
+			uint32 Size = 0;
+
+			bool bPod = false;
+		};
+
+		TArray<FEntry> Entries;
+	};
+
+	/**
+	 * Writes the descriptor of the values of a class.
+	 * @param InArchive The archive to write to.
+	 * @param InClass The class of the objects written with WriteSchemaData.
+	 */
+	void WriteSchemaDescriptor(FArchive& InArchive, UClass* InClass);
+
+	/**
+	 * Reads a descriptor written by WriteSchemaDescriptor.
+	 * @param InArchive The archive to read from.
+	 * @param OutDescriptor The descriptor to fill.
+	 * @return true on success.
+	 */
+	bool ReadSchemaDescriptor(FArchive& InArchive, FSchemaDescriptor& OutDescriptor);
+
+	/**
+	 * Writes the SaveGame properties: the layout hash, then the values. Values that are not plain old data
+	 * are prefixed with their size, so readers with a different layout can skip them.
+	 * @param InArchive The archive to write to, names and objects are expected to go through tables.
+	 * @param InObject The object to save.
+	 * @return true on success.
+	 */
+	bool WriteSchemaData(FArchive& InArchive, UObject* InObject);
+
+	/**
+	 * Reads data written by WriteSchemaData. The values are copied straight to the property offsets
+	 * when the layout hash matches, otherwise properties are matched by name and type through the descriptor.
+	 * @param InArchive The archive to read from.
+	 * @param InObject The object to load into.
+	 * @param InDescriptor Descriptor written with the data, loading fails without it if the layout changed.
+	 * @return true on success.
+	 */
+	bool ReadSchemaData(FArchive& InArchive, UObject* InObject, const FSchemaDescriptor* InDescriptor);
+}
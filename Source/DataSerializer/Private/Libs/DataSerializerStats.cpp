@@ -0,0 +1,25 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Libs/DataSerializerStats.h"
+
+DEFINE_STAT(STAT_DataSerializer_Serialize);
+DEFINE_STAT(STAT_DataSerializer_Deserialize);
+DEFINE_STAT(STAT_DataSerializer_Compress);
+DEFINE_STAT(STAT_DataSerializer_Decompress);
+DEFINE_STAT(STAT_DataSerializer_FileWrite);
+DEFINE_STAT(STAT_DataSerializer_FileRead);
+DEFINE_STAT(STAT_DataSerializer_ResolveClass);
+
+DEFINE_STAT(STAT_DataSerializer_BytesOut);
+DEFINE_STAT(STAT_DataSerializer_BytesIn);
+DEFINE_STAT(STAT_DataSerializer_Objects);
+DEFINE_STAT(STAT_DataSerializer_ClassLookups);
+DEFINE_STAT(STAT_DataSerializer_ClassCacheMisses);
+DEFINE_STAT(STAT_DataSerializer_FileBytesWritten);
+DEFINE_STAT(STAT_DataSerializer_FileBytesRead);
+DEFINE_STAT(STAT_DataSerializer_CompressionRatio);
+
+CSV_DEFINE_CATEGORY(DataSerializer, true);
+
+LLM_DEFINE_TAG(DataSerializer);
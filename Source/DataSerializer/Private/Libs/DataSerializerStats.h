@@ -0,0 +1,123 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Stats/Stats.h"
+
+/** `stat DataSerializer` */
+DECLARE_STATS_GROUP(TEXT("DataSerializer"), STATGROUP_DataSerializer, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Serialize"), STAT_DataSerializer_Serialize, STATGROUP_DataSerializer, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Deserialize"), STAT_DataSerializer_Deserialize, STATGROUP_DataSerializer, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Compress"), STAT_DataSerializer_Compress, STATGROUP_DataSerializer, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Decompress"), STAT_DataSerializer_Decompress, STATGROUP_DataSerializer, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("File Write"), STAT_DataSerializer_FileWrite, STATGROUP_DataSerializer, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("File Read"), STAT_DataSerializer_FileRead, STATGROUP_DataSerializer, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Resolve Class"), STAT_DataSerializer_ResolveClass, STATGROUP_DataSerializer, );
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Bytes Out"), STAT_DataSerializer_BytesOut, STATGROUP_DataSerializer, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Bytes In"), STAT_DataSerializer_BytesIn, STATGROUP_DataSerializer, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Objects"), STAT_DataSerializer_Objects, STATGROUP_DataSerializer, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Class Lookups"), STAT_DataSerializer_ClassLookups, STATGROUP_DataSerializer, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Class Cache Misses"), STAT_DataSerializer_ClassCacheMisses, STATGROUP_DataSerializer, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("File Bytes Written"), STAT_DataSerializer_FileBytesWritten, STATGROUP_DataSerializer, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("File Bytes Read"), STAT_DataSerializer_FileBytesRead, STATGROUP_DataSerializer, );
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Compression Ratio"), STAT_DataSerializer_CompressionRatio, STATGROUP_DataSerializer, );
+
+CSV_DECLARE_CATEGORY_EXTERN(DataSerializer);
+
+LLM_DECLARE_TAG(DataSerializer);
+
+/** Insights event, cycle counter and LLM tag of a serializer phase, StatId is one of the cycle stats above. */
+#define DATASERIALIZER_SCOPE(StatId) \
+	TRACE_CPUPROFILER_EVENT_SCOPE(StatId); \
+	SCOPE_CYCLE_COUNTER(StatId); \
+	LLM_SCOPE_BYTAG(DataSerializer)
+
+namespace Serializer
+{
+	/** Counts the bytes written by a serialization call. */
+	inline void RecordBytesOut(int64 InBytes)
+	{
+		INC_DWORD_STAT_BY(STAT_DataSerializer_BytesOut, static_cast<uint32>(InBytes));
+		CSV_CUSTOM_STAT(DataSerializer, BytesOut, static_cast<int32>(InBytes), ECsvCustomStatOp::Accumulate);
+	}
+
+	/** Counts the bytes consumed by a deserialization call. */
+	inline void RecordBytesIn(int64 InBytes)
+	{
+		INC_DWORD_STAT_BY(STAT_DataSerializer_BytesIn, static_cast<uint32>(InBytes));
+		CSV_CUSTOM_STAT(DataSerializer, BytesIn, static_cast<int32>(InBytes), ECsvCustomStatOp::Accumulate);
+	}
+
+	/** Counts the objects handled by a call. */
+	inline void RecordObjects(int32 InNumObjects)
+	{
+		INC_DWORD_STAT_BY(STAT_DataSerializer_Objects, InNumObjects);
+		CSV_CUSTOM_STAT(DataSerializer, Objects, InNumObjects, ECsvCustomStatOp::Accumulate);
+	}
+
+	/** Counts a class lookup, misses are the ones that had to find or load the class. */
+	inline void RecordClassLookup(bool bInCacheHit)
+	{
+		INC_DWORD_STAT(STAT_DataSerializer_ClassLookups);
+		CSV_CUSTOM_STAT(DataSerializer, ClassLookups, 1, ECsvCustomStatOp::Accumulate);
+		if (!bInCacheHit)
+		{
+			INC_DWORD_STAT(STAT_DataSerializer_ClassCacheMisses);
+			CSV_CUSTOM_STAT(DataSerializer, ClassCacheMisses, 1, ECsvCustomStatOp::Accumulate);
+		}
+	}
+
+	/** Counts the bytes of a file written or read in one go. */
+	inline void RecordFileBytes(int64 InBytes, bool bInWrite)
+	{
+		if (bInWrite)
+		{
+			INC_DWORD_STAT_BY(STAT_DataSerializer_FileBytesWritten, static_cast<uint32>(InBytes));
+			CSV_CUSTOM_STAT(DataSerializer, FileBytesWritten, static_cast<int32>(InBytes), ECsvCustomStatOp::Accumulate);
+		}
+		else
+		{
+			INC_DWORD_STAT_BY(STAT_DataSerializer_FileBytesRead, static_cast<uint32>(InBytes));
+			CSV_CUSTOM_STAT(DataSerializer, FileBytesRead, static_cast<int32>(InBytes), ECsvCustomStatOp::Accumulate);
+		}
+	}
+
+	/** Records the bytes read from an archive, and the objects added to a list, when going out of scope. */
+	class FScopedReadCounter
+	{
+	public:
+		explicit FScopedReadCounter(FArchive& InReader, const TArray<UObject*>* InObjects = nullptr)
+			: Reader(InReader), Start(InReader.Tell()), Objects(InObjects), NumObjects(InObjects != nullptr ? InObjects->Num() : 0)
+		{
+		}
+
+		~FScopedReadCounter()
+		{
+			RecordBytesIn(Reader.Tell() - Start);
+			if (Objects != nullptr)
+			{
+				RecordObjects(Objects->Num() - NumObjects);
+			}
+		}
+
+	private:
+		FArchive& Reader;
+		int64 Start = 0;
+		const TArray<UObject*>* Objects = nullptr;
+		int32 NumObjects = 0;
+	};
+
+	/** Records the ratio of the last compressed file. */
+	inline void RecordCompression(int64 InUncompressedSize, int64 InCompressedSize)
+	{
+		const float ratio = InCompressedSize > 0 ? static_cast<float>(InUncompressedSize) / InCompressedSize : 0.f;
+		SET_FLOAT_STAT(STAT_DataSerializer_CompressionRatio, ratio);
+		CSV_CUSTOM_STAT(DataSerializer, CompressionRatio, ratio, ECsvCustomStatOp::Set);
+	}
+}
@@ -0,0 +1,68 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Libs/DataSerializerStream.h"
+
+namespace Serializer
+{
+	/** Longest LEB128 encoding of a 64 bit value. */
+	constexpr int32 MaxVarIntBytes = 10;
+
+	void FStreamPreamble::Write(FArchive& InWriter) const
+	{
+		uint32 tag = XEUS_STREAM_TAG;
+		uint8 version = StreamVersion;
+		uint8 flags = Flags;
+		InWriter << tag;
+		InWriter << version;
+		InWriter << flags;
+	}
+
+	bool FStreamPreamble::Read(FArchive& InReader)
+	{
+		Flags = 0;
+		if (InReader.TotalSize() - InReader.Tell() < static_cast<int64>(sizeof(uint32) + 2))
+			return false;
+
+		uint32 tag = 0;
+		uint8 version = 0;
+		InReader << tag;
+		InReader << version;
+		InReader << Flags;
+		return !InReader.IsError() && tag == XEUS_STREAM_TAG && version == StreamVersion;
+	}
+
+	void WriteVarUInt(FArchive& InWriter, uint64 InValue)
+	{
+		uint8 buffer[MaxVarIntBytes];
+		int32 n = 0;
+		while (InValue >= 0x80)
+		{
+			buffer[n++] = static_cast<uint8>(InValue) | 0x80;
+			InValue >>= 7;
+		}
+		buffer[n++] = static_cast<uint8>(InValue);
+		InWriter.Serialize(buffer, n);
+	}
+
+	bool ReadVarUInt(FArchive& InReader, uint64& OutValue)
+	{
+		OutValue = 0;
+		for (int32 i = 0; i < MaxVarIntBytes; ++i)
+		{
+			uint8 byte = 0;
+			InReader << byte;
+			if (InReader.IsError())
+				return false;
+
+			// The 10th byte only holds the top bit of a 64 bit value
+			if (i == MaxVarIntBytes - 1 && byte > 1)
+				return false;
+
+			OutValue |= static_cast<uint64>(byte & 0x7F) << (7 * i);
+			if ((byte & 0x80) == 0)
+				return true;
+		}
+		return false;
+	}
+}
@@ -0,0 +1,66 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Libs/DataSerializerEncoding.h"
+
+namespace Serializer
+{
+	/** Version of the stream preamble. */
+	constexpr uint8 StreamVersion = 1;
+
+	/** Stream flag, integers and byte counts are varints. */
+	constexpr uint8 StreamVarInt = 1 << 0;
+
+	/** Stream flag, booleans are packed into single bits. */
+	constexpr uint8 StreamPackedBools = 1 << 1;
+
+	/**
+	 * Stream preamble written by USerializerObject::Prepare when a non-default mode is selected.
+	 * Readers are told the mode and only then expect a preamble, Fixed streams are never sniffed
+	 * since their first bytes can be any value.
+	 */
+	struct FStreamPreamble
+	{
+		uint8 Flags = 0;
+
+		/** @return true if the stream needs a preamble. */
+		bool IsNeeded() const { return Flags != 0; }
+
+		/** Writes the tag, version and flags. */
+		void Write(FArchive& InWriter) const;
+
+		/**
+		 * Reads the preamble the stream starts with.
+		 * @return false if the stream does not start with a preamble of the current version.
+		 */
+		bool Read(FArchive& InReader);
+	};
+
+	/** Writes an unsigned LEB128 varint. */
+	void WriteVarUInt(FArchive& InWriter, uint64 InValue);
+
+	/**
+	 * Reads an unsigned LEB128 varint.
+	 * @return false on a truncated or overlong value.
+	 */
+	bool ReadVarUInt(FArchive& InReader, uint64& OutValue);
+
+	/** Writes a signed value as a zigzag varint. */
+	inline void WriteVarInt(FArchive& InWriter, int64 InValue)
+	{
+		WriteVarUInt(InWriter, (static_cast<uint64>(InValue) << 1) ^ static_cast<uint64>(InValue >> 63));
+	}
+
+	/** Reads a signed zigzag varint. */
+	inline bool ReadVarInt(FArchive& InReader, int64& OutValue)
+	{
+		uint64 value = 0;
+		if (!ReadVarUInt(InReader, value))
+			return false;
+
+		OutValue = static_cast<int64>(value >> 1) ^ -static_cast<int64>(value & 1);
+		return true;
+	}
+}
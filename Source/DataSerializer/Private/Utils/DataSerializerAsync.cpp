@@ -0,0 +1,345 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utils/DataSerializerAsync.h"
+
+#include "Async/Async.h"
+#include "HAL/Event.h"
+#include "Libs/DataSerializerLib.h"
+#include "Misc/Paths.h"
+
+#include <atomic>
+
+namespace Serializer
+{
+	struct FAsyncWaiter
+	{
+		TPromise<FDataSerializerAsyncResultRef> Promise;
+		FDataSerializerAsyncIO::FCallback Callback;
+		std::atomic<bool> bCancelled{false};
+		std::atomic<bool> bDone{false};
+
+		/** Fulfills the promise once, returns false if it was already fulfilled. */
+		bool Finish(const FDataSerializerAsyncResultRef& InResult)
+		{
+			if (bDone.exchange(true))
+				return false;
+			Promise.SetValue(InResult);
+			return true;
+		}
+	};
+
+	using FAsyncWaiterRef = TSharedRef<FAsyncWaiter, ESPMode::ThreadSafe>;
+
+	struct FAsyncRequest
+	{
+		EDataSerializerAsyncOp Op = EDataSerializerAsyncOp::Read;
+		FString Path;
+		TArray<uint8> Bytes;
+		FDataSerializerCompressionSettings Settings;
+		TArray<FAsyncWaiterRef> Waiters;
+		bool bStarted = false;
+
+		bool IsWrite() const
+		{
+			return Op == EDataSerializerAsyncOp::Write || Op == EDataSerializerAsyncOp::WriteCompressed;
+		}
+
+		bool HasActiveWaiters() const
+		{
+			for (const FAsyncWaiterRef& waiter : Waiters)
+			{
+				if (!waiter->bCancelled)
+					return true;
+			}
+			return false;
+		}
+	};
+
+	using FAsyncRequestRef = TSharedRef<FAsyncRequest, ESPMode::ThreadSafe>;
+
+	/** Per-path FIFO of disk requests, only the head of each queue is executed. */
+	class FAsyncScheduler
+	{
+	public:
+		static FAsyncScheduler& Get()
+		{
+			static FAsyncScheduler instance;
+			return instance;
+		}
+
+		FDataSerializerAsyncHandle Enqueue(EDataSerializerAsyncOp InOp, const FString& InPath, TArray<uint8>&& InBytes,
+		                                   const FDataSerializerCompressionSettings& InSettings,
+		                                   FDataSerializerAsyncIO::FCallback&& InCallback)
+		{
+			FAsyncWaiterRef waiter = MakeShared<FAsyncWaiter, ESPMode::ThreadSafe>();
+			waiter->Callback = MoveTemp(InCallback);
+			FDataSerializerAsyncHandle handle(waiter, waiter->Promise.GetFuture().Share());
+
+			const FString key = NormalizePath(InPath);
+			TOptional<FAsyncRequestRef> toStart;
+			{
+				FScopeLock lock(&Lock);
+				TArray<FAsyncRequestRef>& queue = Queues.FindOrAdd(key);
+				if (queue.Num() > 0 && queue.Last()->Op == InOp)
+				{
+					FAsyncRequestRef tail = queue.Last();
+					if (tail->IsWrite() && !tail->bStarted)
+					{
+						// Newer data supersedes the queued write
+						tail->Bytes = MoveTemp(InBytes);
+						tail->Settings = InSettings;
+						tail->Waiters.Add(waiter);
+						return handle;
+					}
+					if (!tail->IsWrite())
+					{
+						// Join the pending read
+						tail->Waiters.Add(waiter);
+						return handle;
+					}
+				}
+
+				FAsyncRequestRef request = MakeShared<FAsyncRequest, ESPMode::ThreadSafe>();
+				request->Op = InOp;
+				request->Path = InPath;
+				request->Bytes = MoveTemp(InBytes);
+				request->Settings = InSettings;
+				request->Waiters.Add(waiter);
+				queue.Add(request);
+				if (queue.Num() == 1)
+				{
+					request->bStarted = true;
+					toStart = request;
+				}
+			}
+
+			if (toStart.IsSet())
+			{
+				Launch(key, toStart.GetValue());
+			}
+			return handle;
+		}
+
+		void Cancel(const FAsyncWaiterRef& InWaiter)
+		{
+			InWaiter->bCancelled = true;
+
+			TSharedRef<FDataSerializerAsyncResult, ESPMode::ThreadSafe> result = MakeShared<FDataSerializerAsyncResult, ESPMode::ThreadSafe>();
+			result->bCancelled = true;
+			InWaiter->Finish(result);
+
+			FScopeLock lock(&Lock);
+			for (TPair<FString, TArray<FAsyncRequestRef>>& pair : Queues)
+			{
+				pair.Value.RemoveAll([](const FAsyncRequestRef& Request)
+				{
+					return !Request->bStarted && !Request->HasActiveWaiters();
+				});
+			}
+		}
+
+		void CancelAll(const FString& InPath)
+		{
+			TArray<FAsyncWaiterRef> waiters;
+			{
+				FScopeLock lock(&Lock);
+				if (TArray<FAsyncRequestRef>* queue = Queues.Find(NormalizePath(InPath)))
+				{
+					for (const FAsyncRequestRef& request : *queue)
+					{
+						waiters.Append(request->Waiters);
+					}
+				}
+			}
+
+			for (const FAsyncWaiterRef& waiter : waiters)
+			{
+				Cancel(waiter);
+			}
+		}
+
+		void Flush()
+		{
+			for (;;)
+			{
+				{
+					FScopeLock lock(&FlushLock);
+					if (NumInFlight == 0)
+						return;
+				}
+				IdleEvent->Wait();
+			}
+		}
+
+	private:
+		static FString NormalizePath(const FString& InPath)
+		{
+			FString path = FPaths::ConvertRelativePathToFull(InPath);
+			FPaths::NormalizeFilename(path);
+			return path;
+		}
+
+		void Launch(const FString& InKey, const FAsyncRequestRef& InRequest)
+		{
+			{
+				FScopeLock lock(&FlushLock);
+				if (NumInFlight++ == 0)
+				{
+					IdleEvent->Reset();
+				}
+			}
+			Async(EAsyncExecution::ThreadPool, [this, InKey, InRequest]()
+			{
+				Execute(InKey, InRequest);
+			});
+		}
+
+		void Execute(const FString& InKey, const FAsyncRequestRef& InRequest)
+		{
+			TSharedRef<FDataSerializerAsyncResult, ESPMode::ThreadSafe> result = MakeShared<FDataSerializerAsyncResult, ESPMode::ThreadSafe>();
+
+			bool bRun;
+			{
+				FScopeLock lock(&Lock);
+				bRun = InRequest->HasActiveWaiters();
+			}
+
+			if (bRun)
+			{
+				switch (InRequest->Op)
+				{
+				case EDataSerializerAsyncOp::Write:
+					result->bSuccess = UDataSerializerLib::WriteBytesToDisk(InRequest->Bytes, InRequest->Path);
+					break;
+				case EDataSerializerAsyncOp::WriteCompressed:
+					result->bSuccess = UDataSerializerLib::WriteBytesToDiskCompressedCpp(InRequest->Bytes, InRequest->Path,
+					                                                                       InRequest->Settings);
+					break;
+				case EDataSerializerAsyncOp::Read:
+					result->bSuccess = UDataSerializerLib::ReadBytesFromDisk(result->Bytes, InRequest->Path);
+					break;
+				case EDataSerializerAsyncOp::ReadCompressed:
+					result->bSuccess = UDataSerializerLib::ReadCompressedBytesFromDisk(result->Bytes, InRequest->Path);
+					break;
+				}
+			}
+
+			// Detach the request and start the next one for this path
+			TArray<FAsyncWaiterRef> waiters;
+			TOptional<FAsyncRequestRef> next;
+			{
+				FScopeLock lock(&Lock);
+				waiters = MoveTemp(InRequest->Waiters);
+
+				TArray<FAsyncRequestRef>& queue = Queues.FindChecked(InKey);
+				queue.Remove(InRequest);
+				if (queue.Num() > 0)
+				{
+					queue[0]->bStarted = true;
+					next = queue[0];
+				}
+				else
+				{
+					Queues.Remove(InKey);
+				}
+			}
+
+			if (next.IsSet())
+			{
+				Launch(InKey, next.GetValue());
+			}
+
+			// Every waiter shares the same result
+			const FDataSerializerAsyncResultRef sharedResult = result;
+			for (const FAsyncWaiterRef& waiter : waiters)
+			{
+				if (waiter->bCancelled)
+					continue;
+
+				if (waiter->Callback)
+				{
+					AsyncTask(ENamedThreads::GameThread, [waiter, sharedResult]()
+					{
+						if (!waiter->bCancelled)
+						{
+							waiter->Callback(*sharedResult);
+						}
+					});
+				}
+				waiter->Finish(sharedResult);
+			}
+
+			FScopeLock lock(&FlushLock);
+			if (--NumInFlight == 0)
+			{
+				IdleEvent->Trigger();
+			}
+		}
+
+	private:
+		FCriticalSection Lock;
+		TMap<FString, TArray<FAsyncRequestRef>> Queues;
+		/** Guards NumInFlight, IdleEvent is triggered whenever it drops to 0. */
+		FCriticalSection FlushLock;
+		int32 NumInFlight = 0;
+		FEventRef IdleEvent{EEventMode::ManualReset};
+	};
+}
+
+FDataSerializerAsyncHandle::FDataSerializerAsyncHandle(TSharedRef<Serializer::FAsyncWaiter, ESPMode::ThreadSafe> InWaiter,
+                                                       TSharedFuture<FDataSerializerAsyncResultRef> InFuture) :
+	Waiter(InWaiter),
+	Future(MoveTemp(InFuture))
+{
+}
+
+bool FDataSerializerAsyncHandle::IsValid() const
+{
+	return Waiter.IsValid();
+}
+
+bool FDataSerializerAsyncHandle::IsDone() const
+{
+	return Waiter.IsValid() && Waiter->bDone;
+}
+
+void FDataSerializerAsyncHandle::Cancel()
+{
+	if (Waiter.IsValid())
+	{
+		Serializer::FAsyncScheduler::Get().Cancel(Waiter.ToSharedRef());
+	}
+}
+
+FDataSerializerAsyncHandle FDataSerializerAsyncIO::WriteBytesToDisk(TArray<uint8> InBytes, const FString& InPath,
+                                                                   bool bCompressed, FCallback OnComplete)
+{
+	const EDataSerializerAsyncOp op = bCompressed ? EDataSerializerAsyncOp::WriteCompressed : EDataSerializerAsyncOp::Write;
+	return Serializer::FAsyncScheduler::Get().Enqueue(op, InPath, MoveTemp(InBytes), {}, MoveTemp(OnComplete));
+}
+
+FDataSerializerAsyncHandle FDataSerializerAsyncIO::WriteBytesToDiskCompressed(TArray<uint8> InBytes,
+	const FString& InPath, const FDataSerializerCompressionSettings& InSettings, FCallback OnComplete)
+{
+	return Serializer::FAsyncScheduler::Get().Enqueue(EDataSerializerAsyncOp::WriteCompressed, InPath,
+	                                                  MoveTemp(InBytes), InSettings, MoveTemp(OnComplete));
+}
+
+FDataSerializerAsyncHandle FDataSerializerAsyncIO::ReadBytesFromDisk(const FString& InPath, bool bCompressed,
+                                                                    FCallback OnComplete)
+{
+	const EDataSerializerAsyncOp op = bCompressed ? EDataSerializerAsyncOp::ReadCompressed : EDataSerializerAsyncOp::Read;
+	TArray<uint8> empty;
+	return Serializer::FAsyncScheduler::Get().Enqueue(op, InPath, MoveTemp(empty), {}, MoveTemp(OnComplete));
+}
+
+void FDataSerializerAsyncIO::CancelAll(const FString& InPath)
+{
+	Serializer::FAsyncScheduler::Get().CancelAll(InPath);
+}
+
+void FDataSerializerAsyncIO::Flush()
+{
+	Serializer::FAsyncScheduler::Get().Flush();
+}
@@ -0,0 +1,88 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utils/DataSerializerAsyncAction.h"
+
+UDataSerializerAsyncDiskAction* UDataSerializerAsyncDiskAction::WriteBytesToDiskAsync(UObject* WorldContextObject,
+	const TArray<uint8>& InBytes, FString InPath)
+{
+	return Create(WorldContextObject, EDataSerializerAsyncOp::Write, InBytes, InPath);
+}
+
+UDataSerializerAsyncDiskAction* UDataSerializerAsyncDiskAction::WriteBytesToDiskCompressedAsync(
+	UObject* WorldContextObject, const TArray<uint8>& InBytes, FString InPath,
+	FDataSerializerCompressionSettings InSettings)
+{
+	UDataSerializerAsyncDiskAction* action = Create(WorldContextObject, EDataSerializerAsyncOp::WriteCompressed,
+	                                                InBytes, InPath);
+	action->Settings = InSettings;
+	return action;
+}
+
+UDataSerializerAsyncDiskAction* UDataSerializerAsyncDiskAction::ReadBytesFromDiskAsync(UObject* WorldContextObject,
+	FString InPath)
+{
+	return Create(WorldContextObject, EDataSerializerAsyncOp::Read, {}, InPath);
+}
+
+UDataSerializerAsyncDiskAction* UDataSerializerAsyncDiskAction::ReadCompressedBytesFromDiskAsync(
+	UObject* WorldContextObject, FString InPath)
+{
+	return Create(WorldContextObject, EDataSerializerAsyncOp::ReadCompressed, {}, InPath);
+}
+
+UDataSerializerAsyncDiskAction* UDataSerializerAsyncDiskAction::Create(UObject* WorldContextObject,
+	EDataSerializerAsyncOp InOp, const TArray<uint8>& InBytes, const FString& InPath)
+{
+	UDataSerializerAsyncDiskAction* action = NewObject<UDataSerializerAsyncDiskAction>();
+	action->Op = InOp;
+	action->Path = InPath;
+	action->Bytes = InBytes;
+	action->RegisterWithGameInstance(WorldContextObject);
+	return action;
+}
+
+void UDataSerializerAsyncDiskAction::Activate()
+{
+	TWeakObjectPtr<UDataSerializerAsyncDiskAction> weakThis(this);
+	auto callback = [weakThis](const FDataSerializerAsyncResult& InResult)
+	{
+		if (weakThis.IsValid())
+		{
+			weakThis->HandleCompleted(InResult);
+		}
+	};
+
+	switch (Op)
+	{
+	case EDataSerializerAsyncOp::Write:
+		Handle = FDataSerializerAsyncIO::WriteBytesToDisk(MoveTemp(Bytes), Path, false, callback);
+		break;
+	case EDataSerializerAsyncOp::WriteCompressed:
+		Handle = FDataSerializerAsyncIO::WriteBytesToDiskCompressed(MoveTemp(Bytes), Path, Settings, callback);
+		break;
+	case EDataSerializerAsyncOp::Read:
+	case EDataSerializerAsyncOp::ReadCompressed:
+		Handle = FDataSerializerAsyncIO::ReadBytesFromDisk(Path, Op == EDataSerializerAsyncOp::ReadCompressed, callback);
+		break;
+	}
+}
+
+void UDataSerializerAsyncDiskAction::Cancel()
+{
+	Handle.Cancel();
+	SetReadyToDestroy();
+}
+
+void UDataSerializerAsyncDiskAction::HandleCompleted(const FDataSerializerAsyncResult& InResult)
+{
+	if (InResult.bSuccess)
+	{
+		OnCompleted.Broadcast(true, InResult.Bytes);
+	}
+	else
+	{
+		OnFailed.Broadcast(false, InResult.Bytes);
+	}
+	SetReadyToDestroy();
+}
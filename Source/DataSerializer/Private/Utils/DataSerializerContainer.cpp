@@ -0,0 +1,605 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utils/DataSerializerContainer.h"
+
+#include "Algo/BinarySearch.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Libs/DataSerializerFiles.h"
+#include "Libs/DataSerializerStats.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace Serializer
+{
+	/** Bytes reserved for the header, the index follows. */
+	constexpr int32 ContainerHeaderSize = 32;
+
+	/** Index capacity of new containers, doubled whenever the index outgrows it. */
+	constexpr int32 ContainerInitialIndexCapacity = 64 * 1024;
+
+	/** Slots closer than this are read together by ReadMany, the gap is read and dropped. */
+	constexpr int64 ContainerMaxReadGap = 64 * 1024;
+
+	/** Upper bound of a single read of ReadMany. */
+	constexpr int64 ContainerMaxReadSize = 16 * 1024 * 1024;
+
+	/** Rounds a blob size up to a slot capacity. */
+	static int32 GetSlotCapacity(int32 InSize)
+	{
+		return Align(FMath::Max(InSize, 1), FDataSerializerContainer::SlotAlignment);
+	}
+}
+
+FDataSerializerContainer::~FDataSerializerContainer()
+{
+	FScopeLock lock(&Lock);
+	File.Reset();
+}
+
+TSharedPtr<FDataSerializerContainer, ESPMode::ThreadSafe> FDataSerializerContainer::Open(const FString& InPath, bool bInCreate)
+{
+	TSharedPtr<FDataSerializerContainer, ESPMode::ThreadSafe> container = MakeShareable(new FDataSerializerContainer());
+	container->Path = InPath;
+
+	// A crash may have interrupted a repack while the repacked file replaced the container
+	IFileManager& fileManager = IFileManager::Get();
+	if (!Serializer::RecoverReplacedFile(InPath, InPath + TEXT(".repack"), XEUS_CONTAINER_FILE_TAG, CurrentVersion))
+		return nullptr;
+
+	const bool bExists = fileManager.FileExists(*InPath);
+	if (!bExists && !bInCreate)
+		return nullptr;
+	container->File.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*InPath, true, true));
+	if (!container->File.IsValid())
+		return nullptr;
+
+	FScopeLock lock(&container->Lock);
+	if (!bExists || container->File->Size() == 0)
+	{
+		if (!bInCreate)
+			return nullptr;
+
+		container->IndexCapacity = Serializer::ContainerInitialIndexCapacity;
+		container->DataEnd = Serializer::ContainerHeaderSize + container->IndexCapacity;
+		return container->WriteIndex() ? container : nullptr;
+	}
+	return container->ReadIndex() ? container : nullptr;
+}
+
+bool FDataSerializerContainer::ReadIndex()
+{
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_FileRead);
+	TArray<uint8> header;
+	header.SetNumUninitialized(Serializer::ContainerHeaderSize);
+	if (!File->Seek(0) || !File->Read(header.GetData(), header.Num()))
+		return false;
+
+	FMemoryReader headerReader(header);
+	uint32 tag = 0;
+	uint8 version = 0;
+	int32 indexSize = 0;
+	uint32 indexCrc = 0;
+	headerReader << tag;
+	headerReader << version;
+	headerReader << IndexCapacity;
+	headerReader << indexSize;
+	headerReader << indexCrc;
+	headerReader << DataEnd;
+	if (headerReader.IsError() || tag != XEUS_CONTAINER_FILE_TAG || version != CurrentVersion
+		|| indexSize < 0 || indexSize > IndexCapacity || DataEnd < Serializer::ContainerHeaderSize + IndexCapacity)
+		return false;
+
+	TArray<uint8> indexBytes;
+	indexBytes.SetNumUninitialized(indexSize);
+	if (!File->Read(indexBytes.GetData(), indexSize) || FCrc::MemCrc32(indexBytes.GetData(), indexSize) != indexCrc)
+		return false;
+	Serializer::RecordFileBytes(header.Num() + indexSize, false);
+
+	FMemoryReader reader(indexBytes);
+	int32 numSlots = 0;
+	reader << numSlots;
+	if (numSlots < 0 || numSlots > indexSize)
+		return false;
+
+	Index.Reset();
+	Index.Reserve(numSlots);
+	for (int32 i = 0; i < numSlots && !reader.IsError(); ++i)
+	{
+		FString key;
+		FSlot slot;
+		reader << key;
+		reader << slot.Offset;
+		reader << slot.Size;
+		reader << slot.Capacity;
+		reader << slot.Crc;
+		Index.Add(MoveTemp(key), slot);
+	}
+
+	int32 numFree = 0;
+	reader << numFree;
+	if (reader.IsError() || numFree < 0 || numFree > indexSize)
+		return false;
+
+	FreeRanges.SetNum(numFree);
+	for (FFreeRange& range : FreeRanges)
+	{
+		reader << range.Offset;
+		reader << range.Capacity;
+	}
+	return !reader.IsError();
+}
+
+bool FDataSerializerContainer::WriteIndex()
+{
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_FileWrite);
+	TArray<uint8> indexBytes;
+	FMemoryWriter writer(indexBytes);
+	int32 numSlots = Index.Num();
+	writer << numSlots;
+	for (TPair<FString, FSlot>& pair : Index)
+	{
+		writer << pair.Key;
+		writer << pair.Value.Offset;
+		writer << pair.Value.Size;
+		writer << pair.Value.Capacity;
+		writer << pair.Value.Crc;
+	}
+	int32 numFree = FreeRanges.Num();
+	writer << numFree;
+	for (FFreeRange& range : FreeRanges)
+	{
+		writer << range.Offset;
+		writer << range.Capacity;
+	}
+
+	// The data area starts right after the index, make room by rewriting the file
+	if (indexBytes.Num() > IndexCapacity)
+		return RepackInternal(FMath::Max(IndexCapacity * 2, static_cast<int32>(FMath::RoundUpToPowerOfTwo(indexBytes.Num()))));
+
+	// Header and index go out in a single write
+	TArray<uint8> head;
+	FMemoryWriter headWriter(head);
+	uint32 tag = XEUS_CONTAINER_FILE_TAG;
+	uint8 version = CurrentVersion;
+	int32 indexSize = indexBytes.Num();
+	uint32 indexCrc = FCrc::MemCrc32(indexBytes.GetData(), indexSize);
+	headWriter << tag;
+	headWriter << version;
+	headWriter << IndexCapacity;
+	headWriter << indexSize;
+	headWriter << indexCrc;
+	headWriter << DataEnd;
+	head.SetNumZeroed(Serializer::ContainerHeaderSize);
+	head.Append(indexBytes);
+
+	// New containers get their whole index area, so the first blob lands right after it
+	if (File->Size() < Serializer::ContainerHeaderSize + IndexCapacity)
+	{
+		head.SetNumZeroed(Serializer::ContainerHeaderSize + IndexCapacity);
+	}
+
+	if (!File->Seek(0) || !File->Write(head.GetData(), head.Num()) || !File->Flush())
+		return false;
+	Serializer::RecordFileBytes(head.Num(), true);
+	return true;
+}
+
+FDataSerializerContainer::FFreeRange FDataSerializerContainer::Allocate(int32 InSize)
+{
+	const int32 capacity = Serializer::GetSlotCapacity(InSize);
+
+	// Best fit among the free ranges
+	int32 bestIndex = INDEX_NONE;
+	for (int32 i = 0; i < FreeRanges.Num(); ++i)
+	{
+		if (FreeRanges[i].Capacity >= capacity
+			&& (bestIndex == INDEX_NONE || FreeRanges[i].Capacity < FreeRanges[bestIndex].Capacity))
+		{
+			bestIndex = i;
+		}
+	}
+
+	FFreeRange result;
+	result.Capacity = capacity;
+	if (bestIndex == INDEX_NONE)
+	{
+		result.Offset = DataEnd;
+		DataEnd += capacity;
+		return result;
+	}
+
+	FFreeRange& range = FreeRanges[bestIndex];
+	result.Offset = range.Offset;
+	if (range.Capacity == capacity)
+	{
+		FreeRanges.RemoveAt(bestIndex);
+	}
+	else
+	{
+		range.Offset += capacity;
+		range.Capacity -= capacity;
+	}
+	return result;
+}
+
+void FDataSerializerContainer::Release(int64 InOffset, int32 InCapacity)
+{
+	int32 index = Algo::LowerBoundBy(FreeRanges, InOffset, [](const FFreeRange& Range) { return Range.Offset; });
+	FreeRanges.Insert({InOffset, InCapacity}, index);
+
+	if (index + 1 < FreeRanges.Num()
+		&& FreeRanges[index].Offset + FreeRanges[index].Capacity == FreeRanges[index + 1].Offset
+		&& static_cast<int64>(FreeRanges[index].Capacity) + FreeRanges[index + 1].Capacity <= MAX_int32)
+	{
+		FreeRanges[index].Capacity += FreeRanges[index + 1].Capacity;
+		FreeRanges.RemoveAt(index + 1);
+	}
+	if (index > 0
+		&& FreeRanges[index - 1].Offset + FreeRanges[index - 1].Capacity == FreeRanges[index].Offset
+		&& static_cast<int64>(FreeRanges[index - 1].Capacity) + FreeRanges[index].Capacity <= MAX_int32)
+	{
+		FreeRanges[index - 1].Capacity += FreeRanges[index].Capacity;
+		FreeRanges.RemoveAt(index);
+		--index;
+	}
+
+	// Free space at the end of the data area is given back to appends
+	if (FreeRanges.Last().Offset + FreeRanges.Last().Capacity == DataEnd)
+	{
+		DataEnd = FreeRanges.Last().Offset;
+		FreeRanges.Pop();
+	}
+}
+
+bool FDataSerializerContainer::Write(const FString& InKey, TArrayView<const uint8> InBytes)
+{
+	TArray<TArray<uint8>> blobs;
+	blobs.Emplace(InBytes);
+	return WriteMany(MakeArrayView(&InKey, 1), blobs);
+}
+
+bool FDataSerializerContainer::WriteMany(TArrayView<const FString> InKeys, TArrayView<const TArray<uint8>> InBlobs)
+{
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_FileWrite);
+	if (InKeys.Num() != InBlobs.Num())
+		return false;
+
+	FScopeLock lock(&Lock);
+	if (!File.IsValid())
+		return false;
+
+	// A key given twice in the batch is written once, with its last blob
+	TMap<FString, int32> lastBlob;
+	lastBlob.Reserve(InKeys.Num());
+	for (int32 i = 0; i < InKeys.Num(); ++i)
+	{
+		lastBlob.Add(InKeys[i], i);
+	}
+
+	// The allocation state is restored if a write fails, so the index never points at data that was not written
+	const TArray<FFreeRange> previousFreeRanges = FreeRanges;
+	const int64 previousDataEnd = DataEnd;
+
+	// Every blob goes to a new slot, a free range or the end of the file, never over its current slot.
+	// Slots still referenced by the index on disk are only released once the new index is written,
+	// so a failed or torn batch leaves every committed blob intact
+	struct FPendingWrite
+	{
+		int64 Offset;
+		int32 Capacity;
+		int32 Blob;
+	};
+	TArray<FPendingWrite> writes;
+	TMap<FString, FSlot> slots;
+	writes.Reserve(lastBlob.Num());
+	slots.Reserve(lastBlob.Num());
+	for (const TPair<FString, int32>& pair : lastBlob)
+	{
+		const int32 size = InBlobs[pair.Value].Num();
+		const FFreeRange range = Allocate(size);
+		FSlot slot;
+		slot.Offset = range.Offset;
+		slot.Capacity = range.Capacity;
+		slot.Size = size;
+		slot.Crc = FCrc::MemCrc32(InBlobs[pair.Value].GetData(), size);
+		writes.Add({slot.Offset, slot.Capacity, pair.Value});
+		slots.Add(pair.Key, slot);
+	}
+
+	auto rollback = [&]()
+	{
+		FreeRanges = previousFreeRanges;
+		DataEnd = previousDataEnd;
+		return false;
+	};
+	writes.Sort([](const FPendingWrite& A, const FPendingWrite& B) { return A.Offset < B.Offset; });
+
+	// Adjacent slots form a single sequential write, the end of a slot is padded when the next one follows it
+	TArray<uint8> run;
+	int64 runOffset = 0;
+	int64 bytesWritten = 0;
+	auto flushRun = [&]()
+	{
+		if (run.Num() == 0)
+			return true;
+		const bool bWritten = File->Seek(runOffset) && File->Write(run.GetData(), run.Num());
+		bytesWritten += run.Num();
+		run.Reset();
+		return bWritten;
+	};
+
+	for (int32 i = 0; i < writes.Num(); ++i)
+	{
+		const FPendingWrite& write = writes[i];
+		const TArray<uint8>& blob = InBlobs[write.Blob];
+		if (run.Num() == 0)
+		{
+			runOffset = write.Offset;
+		}
+		run.Append(blob);
+
+		if (i + 1 < writes.Num() && writes[i + 1].Offset == write.Offset + write.Capacity)
+		{
+			run.AddZeroed(write.Capacity - blob.Num());
+		}
+		else if (!flushRun())
+		{
+			return rollback();
+		}
+	}
+	Serializer::RecordFileBytes(bytesWritten, true);
+
+	// Every blob is on disk, the new slots can go to the index. The replaced slots are written as free
+	// with it: the new index no longer refers to them, and this batch has allocated all it needs already
+	TMap<FString, FSlot> previousSlots;
+	previousSlots.Reserve(slots.Num());
+	for (TPair<FString, FSlot>& pair : slots)
+	{
+		if (const FSlot* previous = Index.Find(pair.Key))
+		{
+			previousSlots.Add(pair.Key, *previous);
+		}
+		Index.Add(pair.Key, pair.Value);
+	}
+	for (const TPair<FString, FSlot>& pair : previousSlots)
+	{
+		Release(pair.Value.Offset, pair.Value.Capacity);
+	}
+	if (WriteIndex())
+		return true;
+
+	for (const TPair<FString, FSlot>& pair : slots)
+	{
+		if (const FSlot* previous = previousSlots.Find(pair.Key))
+		{
+			Index.Add(pair.Key, *previous);
+		}
+		else
+		{
+			Index.Remove(pair.Key);
+		}
+	}
+	return rollback();
+}
+
+bool FDataSerializerContainer::Read(const FString& InKey, TArray<uint8>& OutBytes) const
+{
+	TArray<TArray<uint8>> blobs;
+	const bool bResult = ReadMany(MakeArrayView(&InKey, 1), blobs);
+	OutBytes = MoveTemp(blobs[0]);
+	return bResult;
+}
+
+bool FDataSerializerContainer::ReadMany(TArrayView<const FString> InKeys, TArray<TArray<uint8>>& OutBlobs) const
+{
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_FileRead);
+	OutBlobs.Reset();
+	OutBlobs.SetNum(InKeys.Num());
+
+	FScopeLock lock(&Lock);
+	if (!File.IsValid())
+		return false;
+
+	bool bResult = true;
+	TArray<TPair<FSlot, int32>> reads;
+	reads.Reserve(InKeys.Num());
+	for (int32 i = 0; i < InKeys.Num(); ++i)
+	{
+		if (const FSlot* slot = Index.Find(InKeys[i]))
+		{
+			reads.Emplace(*slot, i);
+		}
+		else
+		{
+			bResult = false;
+		}
+	}
+	reads.Sort([](const TPair<FSlot, int32>& A, const TPair<FSlot, int32>& B) { return A.Key.Offset < B.Key.Offset; });
+
+	// Neighbouring slots are read with one call, small gaps between them are read and dropped
+	TArray<uint8> buffer;
+	int64 bytesRead = 0;
+	for (int32 first = 0; first < reads.Num();)
+	{
+		const int64 start = reads[first].Key.Offset;
+		int64 end = start + reads[first].Key.Size;
+		int32 last = first;
+		while (last + 1 < reads.Num())
+		{
+			const FSlot& next = reads[last + 1].Key;
+			const int64 nextEnd = FMath::Max(end, next.Offset + next.Size);
+			if (next.Offset - end > Serializer::ContainerMaxReadGap || nextEnd - start > Serializer::ContainerMaxReadSize)
+				break;
+			end = nextEnd;
+			++last;
+		}
+
+		buffer.SetNumUninitialized(static_cast<int32>(end - start));
+		if (!File->Seek(start) || !File->Read(buffer.GetData(), buffer.Num()))
+			return false;
+		bytesRead += buffer.Num();
+
+		for (int32 i = first; i <= last; ++i)
+		{
+			const FSlot& slot = reads[i].Key;
+			const uint8* data = buffer.GetData() + (slot.Offset - start);
+			if (FCrc::MemCrc32(data, slot.Size) != slot.Crc)
+			{
+				bResult = false;
+				continue;
+			}
+			OutBlobs[reads[i].Value] = TArray<uint8>(data, slot.Size);
+		}
+		first = last + 1;
+	}
+	Serializer::RecordFileBytes(bytesRead, false);
+	return bResult;
+}
+
+bool FDataSerializerContainer::Remove(const FString& InKey)
+{
+	return RemoveMany(MakeArrayView(&InKey, 1));
+}
+
+bool FDataSerializerContainer::RemoveMany(TArrayView<const FString> InKeys)
+{
+	FScopeLock lock(&Lock);
+	if (!File.IsValid())
+		return false;
+
+	// Restored if the index cannot be written, the slots are still referenced by the index on disk
+	const TMap<FString, FSlot> previousIndex = Index;
+	const TArray<FFreeRange> previousFreeRanges = FreeRanges;
+	const int64 previousDataEnd = DataEnd;
+
+	bool bResult = true;
+	bool bRemoved = false;
+	for (const FString& key : InKeys)
+	{
+		FSlot slot;
+		if (!Index.RemoveAndCopyValue(key, slot))
+		{
+			bResult = false;
+			continue;
+		}
+		Release(slot.Offset, slot.Capacity);
+		bRemoved = true;
+	}
+	if (bRemoved && !WriteIndex())
+	{
+		Index = previousIndex;
+		FreeRanges = previousFreeRanges;
+		DataEnd = previousDataEnd;
+		return false;
+	}
+	return bResult;
+}
+
+TArray<FString> FDataSerializerContainer::GetKeys() const
+{
+	FScopeLock lock(&Lock);
+	TArray<FString> keys;
+	Index.GetKeys(keys);
+	return keys;
+}
+
+bool FDataSerializerContainer::Contains(const FString& InKey) const
+{
+	FScopeLock lock(&Lock);
+	return Index.Contains(InKey);
+}
+
+int32 FDataSerializerContainer::Num() const
+{
+	FScopeLock lock(&Lock);
+	return Index.Num();
+}
+
+int64 FDataSerializerContainer::GetFreeBytes() const
+{
+	FScopeLock lock(&Lock);
+	int64 freeBytes = 0;
+	for (const FFreeRange& range : FreeRanges)
+	{
+		freeBytes += range.Capacity;
+	}
+	for (const TPair<FString, FSlot>& pair : Index)
+	{
+		freeBytes += pair.Value.Capacity - pair.Value.Size;
+	}
+	return freeBytes;
+}
+
+bool FDataSerializerContainer::Repack()
+{
+	FScopeLock lock(&Lock);
+	return File.IsValid() && RepackInternal(IndexCapacity);
+}
+
+bool FDataSerializerContainer::RepackInternal(int32 InIndexCapacity)
+{
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_FileWrite);
+	IPlatformFile& platformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString tempPath = Path + TEXT(".repack");
+	FDataSerializerContainer packed;
+	packed.Path = tempPath;
+	packed.IndexCapacity = InIndexCapacity;
+	packed.DataEnd = Serializer::ContainerHeaderSize + InIndexCapacity;
+	packed.File.Reset(platformFile.OpenWrite(*tempPath, false, true));
+	if (!packed.File.IsValid())
+		return false;
+
+	auto fail = [&]()
+	{
+		packed.File.Reset();
+		platformFile.DeleteFile(*tempPath);
+		return false;
+	};
+
+	// Copy the blobs in file order, so both files are walked sequentially
+	TArray<TPair<FString, FSlot>> slots = Index.Array();
+	slots.Sort([](const TPair<FString, FSlot>& A, const TPair<FString, FSlot>& B) { return A.Value.Offset < B.Value.Offset; });
+
+	TArray<uint8> buffer;
+	if (!packed.File->Seek(packed.DataEnd))
+		return fail();
+	for (const TPair<FString, FSlot>& pair : slots)
+	{
+		FSlot slot = pair.Value;
+		buffer.SetNumUninitialized(slot.Size);
+		if (!File->Seek(slot.Offset) || !File->Read(buffer.GetData(), buffer.Num()))
+			return fail();
+
+		slot.Offset = packed.DataEnd;
+		slot.Capacity = Serializer::GetSlotCapacity(slot.Size);
+		buffer.AddZeroed(slot.Capacity - slot.Size);
+		if (!packed.File->Write(buffer.GetData(), buffer.Num()))
+			return fail();
+		packed.DataEnd += slot.Capacity;
+		packed.Index.Add(pair.Key, slot);
+	}
+
+	if (!packed.WriteIndex())
+		return fail();
+	packed.File.Reset();
+	File.Reset();
+
+	switch (Serializer::ReplaceFile(Path, tempPath))
+	{
+	case Serializer::EFileReplaceResult::Replaced:
+		Index = MoveTemp(packed.Index);
+		FreeRanges.Reset();
+		IndexCapacity = InIndexCapacity;
+		DataEnd = packed.DataEnd;
+		File.Reset(platformFile.OpenWrite(*Path, true, true));
+		return File.IsValid();
+	case Serializer::EFileReplaceResult::Kept:
+		File.Reset(platformFile.OpenWrite(*Path, true, true));
+		return false;
+	default:
+		// The container is gone and the repacked file not moved, every call fails until Open recovers it
+		return false;
+	}
+}
@@ -0,0 +1,348 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utils/DataSerializerIncrementalLoader.h"
+
+#include "Async/Async.h"
+#include "Libs/DataSerializerLib.h"
+#include "Libs/DataSerializerObjectData.h"
+#include "Libs/DataSerializerObjectGraph.h"
+#include "Libs/DataSerializerStats.h"
+#include "Memory/MemoryView.h"
+#include "UObject/GarbageCollection.h"
+#include "Utils/DataSerializerObjectIndex.h"
+
+namespace Serializer
+{
+	/** Record layout of the bytes given to an incremental loader. */
+	struct FIncrementalLoadPlan
+	{
+		enum class EFormat : uint8
+		{
+			/** Written by SerializeObjectsIndexed, every record is known ahead of time. */
+			Indexed,
+			/** Written by SerializeObjects, a class table followed by records read one after the other. */
+			Batch,
+			/** Written before the class table, a full header per record. */
+			Legacy,
+			/** Written by SerializeObjectGraph, loaded in one go. */
+			Graph
+		};
+
+		EFormat Format = EFormat::Legacy;
+		FDataSerializerObjectIndex Index;
+
+		/** Resolved classes of an indexed archive, the index only holds weak pointers to them. */
+		TArray<UClass*> IndexClasses;
+
+		/** Classes and schemas of a batch, nullptr for classes that must be loaded on the game thread. */
+		FObjectBatchHeader Batch;
+
+		/** Position of the next record of a batch or legacy archive. */
+		int64 Cursor = 0;
+
+		/** Number of records, a graph counts as one. */
+		int32 Total = 0;
+
+		/** Some classes were not loaded yet, they are resolved again on the game thread. */
+		bool bMissingClasses = false;
+
+		/** Parses the header of the archive, runs on the thread pool. */
+		bool Prepare(TArrayView64<const uint8> InBytes)
+		{
+			FMemoryReaderView reader(MakeMemoryView(InBytes.GetData(), InBytes.Num()), true);
+			int32 n = 0;
+			reader << n;
+			if (reader.IsError())
+				return false;
+
+			if (n == XEUS_OBJECT_INDEX_TAG)
+			{
+				Format = EFormat::Indexed;
+				reader.Seek(0);
+				if (!Index.Read(reader))
+					return false;
+
+				Total = Index.Num();
+				CollectIndexClasses();
+				return true;
+			}
+
+			if (n == XEUS_OBJECT_GRAPH_TAG)
+			{
+				Format = EFormat::Graph;
+				Total = 1;
+				return true;
+			}
+
+			if (n == XEUS_OBJECT_BATCH_TAG)
+			{
+				Format = EFormat::Batch;
+				if (!Batch.Read(reader))
+					return false;
+				bMissingClasses = Batch.Classes.Contains(nullptr);
+
+				uint32 count = 0;
+				reader.SerializeIntPacked(count);
+				if (reader.IsError() || count > static_cast<uint32>(FMath::Min<int64>(reader.TotalSize() - reader.Tell(), MAX_int32)))
+					return false;
+
+				Total = static_cast<int32>(count);
+				Cursor = reader.Tell();
+				return true;
+			}
+
+			Format = EFormat::Legacy;
+			Total = n;
+			Cursor = reader.Tell();
+			return n >= 0;
+		}
+
+		/** Gathers the resolved classes of the index records, so they can be kept referenced. */
+		void CollectIndexClasses()
+		{
+			IndexClasses.Reset();
+			bMissingClasses = false;
+			for (int32 i = 0; i < Total; ++i)
+			{
+				if (UClass* objectClass = Index.GetClass(i))
+				{
+					IndexClasses.AddUnique(objectClass);
+				}
+				else
+				{
+					bMissingClasses = true;
+				}
+			}
+		}
+	};
+}
+
+UDataSerializerIncrementalLoader* UDataSerializerIncrementalLoader::DeSerializeObjectsIncremental(
+	const TArray<uint8>& InBytes, UObject* InObjectOuter, float InBudgetMs)
+{
+	return DeSerializeObjectsIncrementalCpp(CopyTemp(InBytes), InObjectOuter, InBudgetMs);
+}
+
+UDataSerializerIncrementalLoader* UDataSerializerIncrementalLoader::DeSerializeObjectsIncrementalCpp(
+	TArray<uint8>&& InBytes, UObject* InObjectOuter, float InBudgetMs)
+{
+	UDataSerializerIncrementalLoader* loader = NewObject<UDataSerializerIncrementalLoader>();
+	loader->Begin(MoveTemp(InBytes), InObjectOuter, InBudgetMs);
+	return loader;
+}
+
+void UDataSerializerIncrementalLoader::Begin(TArray<uint8>&& InBytes, UObject* InObjectOuter, float InBudgetMs)
+{
+	Bytes = MoveTemp(InBytes);
+	ObjectOuter = InObjectOuter;
+	BudgetSeconds = FMath::Max(InBudgetMs, 0.0f) / 1000.0f;
+	NumLoaded = 0;
+	Objects.Reset();
+	State = EState::Preparing;
+	AddToRoot();
+
+	// Bytes is left untouched until the task is done, the view stays valid
+	TSharedRef<Serializer::FIncrementalLoadPlan, ESPMode::ThreadSafe> plan = MakeShared<Serializer::FIncrementalLoadPlan, ESPMode::ThreadSafe>();
+	Plan = plan;
+	const TArrayView64<const uint8> view(Bytes.GetData(), Bytes.Num());
+	PlanTask = Async(EAsyncExecution::ThreadPool, [plan, view]()
+	{
+		DATASERIALIZER_SCOPE(STAT_DataSerializer_Deserialize);
+
+		// Classes are looked up while parsing, which must not overlap a garbage collection
+		FGCScopeGuard gcGuard;
+		return plan->Prepare(view);
+	});
+}
+
+bool UDataSerializerIncrementalLoader::BeginLoading()
+{
+	Serializer::FIncrementalLoadPlan& plan = *Plan;
+	Reader.Emplace(MakeMemoryView(Bytes.GetData(), Bytes.Num()), true);
+	Objects.Reserve(plan.Total);
+
+	// Classes that are not in memory yet can only be loaded here, read the class table again
+	if (plan.bMissingClasses)
+	{
+		if (plan.Format == Serializer::FIncrementalLoadPlan::EFormat::Indexed)
+		{
+			Reader->Seek(0);
+			if (!plan.Index.Read(*Reader))
+				return false;
+			plan.CollectIndexClasses();
+		}
+		else
+		{
+			Reader->Seek(plan.Batch.ClassTablePos);
+			if (!Serializer::FClassTable::Read(*Reader, plan.Batch.Classes))
+				return false;
+		}
+	}
+	return true;
+}
+
+bool UDataSerializerIncrementalLoader::LoadNext()
+{
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_Deserialize);
+	Serializer::FIncrementalLoadPlan& plan = *Plan;
+	FArchive& reader = *Reader;
+	UObject* object = nullptr;
+
+	switch (plan.Format)
+	{
+	case Serializer::FIncrementalLoadPlan::EFormat::Indexed:
+		if (!plan.Index.DeSerializeObject(reader, NumLoaded, ObjectOuter, object))
+			return false;
+		break;
+
+	case Serializer::FIncrementalLoadPlan::EFormat::Batch:
+	{
+		reader.Seek(plan.Cursor);
+		uint32 classIndex = 0;
+		reader.SerializeIntPacked(classIndex);
+		if (!plan.Batch.Classes.IsValidIndex(classIndex) || plan.Batch.Classes[classIndex] == nullptr)
+			return false;
+
+		object = NewObject<UObject>(ObjectOuter, plan.Batch.Classes[classIndex]);
+		if (!Serializer::ReadObjectData(reader, object, nullptr, plan.Batch.GetSchema(classIndex)))
+			return false;
+		plan.Cursor = reader.Tell();
+		break;
+	}
+
+	case Serializer::FIncrementalLoadPlan::EFormat::Legacy:
+		reader.Seek(plan.Cursor);
+		if (!UDataSerializerLib::DeSerializeObjectCpp(reader, ObjectOuter, object))
+			return false;
+		plan.Cursor = reader.Tell();
+		break;
+
+	case Serializer::FIncrementalLoadPlan::EFormat::Graph:
+	{
+		TArray<UObject*> roots;
+		if (!Serializer::ReadObjectGraph(reader, ObjectOuter, roots))
+			return false;
+		Objects.Append(roots);
+		++NumLoaded;
+		return true;
+	}
+	}
+
+	// DeSerializeObjectCpp counts its own objects
+	if (plan.Format != Serializer::FIncrementalLoadPlan::EFormat::Legacy)
+	{
+		Serializer::RecordObjects(1);
+	}
+	Objects.Add(object);
+	++NumLoaded;
+	return !reader.IsError();
+}
+
+void UDataSerializerIncrementalLoader::Tick(float DeltaTime)
+{
+	if (State == EState::Preparing)
+	{
+		if (!PlanTask.IsReady())
+			return;
+
+		const bool bPrepared = PlanTask.Get();
+		PlanTask.Reset();
+		if (!bPrepared || !BeginLoading())
+		{
+			Finish(false, true);
+			return;
+		}
+		State = EState::Loading;
+	}
+
+	// At least one record per frame, so a tiny budget still makes progress
+	const double deadline = FPlatformTime::Seconds() + BudgetSeconds;
+	do
+	{
+		if (NumLoaded == Plan->Total)
+		{
+			Finish(true, true);
+			return;
+		}
+		if (!LoadNext())
+		{
+			Finish(false, true);
+			return;
+		}
+	}
+	while (FPlatformTime::Seconds() < deadline);
+
+	if (NumLoaded == Plan->Total)
+	{
+		Finish(true, true);
+		return;
+	}
+	OnProgress.Broadcast(NumLoaded, Plan->Total);
+}
+
+void UDataSerializerIncrementalLoader::Finish(bool bInSuccess, bool bInBroadcast)
+{
+	if (State == EState::Done)
+		return;
+
+	// The task reads Bytes, it must be done before they go away
+	if (PlanTask.IsValid())
+	{
+		PlanTask.Wait();
+		PlanTask.Reset();
+	}
+
+	State = EState::Done;
+	Reader.Reset();
+	Bytes.Empty();
+	Plan.Reset();
+	RemoveFromRoot();
+
+	if (bInBroadcast)
+	{
+		OnCompleted.Broadcast(bInSuccess, Objects);
+	}
+}
+
+void UDataSerializerIncrementalLoader::Cancel()
+{
+	Finish(false, false);
+}
+
+float UDataSerializerIncrementalLoader::GetProgress() const
+{
+	if (State == EState::Done)
+		return 1.0f;
+	if (State == EState::Preparing || !Plan.IsValid() || Plan->Total == 0)
+		return 0.0f;
+	return static_cast<float>(NumLoaded) / Plan->Total;
+}
+
+void UDataSerializerIncrementalLoader::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	// The task fills the plan while holding off garbage collection, it is either untouched or complete here
+	UDataSerializerIncrementalLoader* loader = CastChecked<UDataSerializerIncrementalLoader>(InThis);
+	if (loader->Plan.IsValid())
+	{
+		Collector.AddReferencedObjects(loader->Plan->Batch.Classes, loader);
+		Collector.AddReferencedObjects(loader->Plan->IndexClasses, loader);
+	}
+	Super::AddReferencedObjects(InThis, Collector);
+}
+
+void UDataSerializerIncrementalLoader::BeginDestroy()
+{
+	Finish(false, false);
+	Super::BeginDestroy();
+}
+
+ETickableTickType UDataSerializerIncrementalLoader::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UDataSerializerIncrementalLoader::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDataSerializerIncrementalLoader, STATGROUP_DataSerializer);
+}
@@ -0,0 +1,512 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utils/DataSerializerJournal.h"
+
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Libs/DataSerializerFiles.h"
+#include "Libs/DataSerializerStats.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace Serializer
+{
+	/** Size of the file tag and version. */
+	constexpr int64 JournalHeaderSize = sizeof(uint32) + sizeof(uint8);
+
+	/** Size of the length prefix and checksum in front of each record body. */
+	constexpr int32 JournalRecordHeaderSize = sizeof(int32) + sizeof(uint32);
+
+	/** Flag of a record body, the key has been removed. */
+	constexpr uint8 JournalTombstone = 1 << 0;
+
+	/** Records larger than this are treated as corrupt. */
+	constexpr int32 JournalMaxBodySize = MAX_int32 - JournalRecordHeaderSize;
+
+	/**
+	 * Encodes a record: body size, CRC of the body, then the body (flags, key, data).
+	 * @return Offset of the data in the record.
+	 */
+	static int32 EncodeJournalRecord(TArray<uint8>& OutBuffer, const FString& InKey, TArrayView<const uint8> InData,
+	                                 uint8 InFlags)
+	{
+		const int32 start = OutBuffer.Num();
+		FMemoryWriter writer(OutBuffer);
+		writer.Seek(start);
+
+		int32 bodySize = 0;
+		uint32 crc = 0;
+		writer << bodySize;
+		writer << crc;
+		writer << InFlags;
+		writer << const_cast<FString&>(InKey);
+		const int32 dataOffset = OutBuffer.Num() - start;
+		writer.Serialize(const_cast<uint8*>(InData.GetData()), InData.Num());
+
+		uint8* record = OutBuffer.GetData() + start;
+		bodySize = OutBuffer.Num() - start - JournalRecordHeaderSize;
+		crc = FCrc::MemCrc32(record + JournalRecordHeaderSize, bodySize);
+		FMemory::Memcpy(record, &bodySize, sizeof(bodySize));
+		FMemory::Memcpy(record + sizeof(bodySize), &crc, sizeof(crc));
+		return dataOffset;
+	}
+
+	/** Parses the body of a record read from disk, returns false if it is corrupt. */
+	static bool DecodeJournalBody(TArray<uint8>& InBody, uint8& OutFlags, FString& OutKey, int32& OutDataOffset)
+	{
+		FMemoryReader reader(InBody);
+		reader << OutFlags;
+		reader << OutKey;
+		OutDataOffset = JournalRecordHeaderSize + static_cast<int32>(reader.Tell());
+		return !reader.IsError();
+	}
+}
+
+FDataSerializerJournal::~FDataSerializerJournal()
+{
+	// Background compactions keep the journal alive, nothing can be running here
+	FScopeLock lock(&Lock);
+	Writer.Reset();
+}
+
+TSharedPtr<FDataSerializerJournal, ESPMode::ThreadSafe> FDataSerializerJournal::Open(const FString& InPath)
+{
+	TSharedPtr<FDataSerializerJournal, ESPMode::ThreadSafe> journal = MakeShareable(new FDataSerializerJournal());
+	journal->Path = InPath;
+
+	// A crash may have interrupted a compaction while the packed file replaced the journal
+	IFileManager& fileManager = IFileManager::Get();
+	if (!Serializer::RecoverReplacedFile(InPath, InPath + TEXT(".compact"), XEUS_JOURNAL_FILE_TAG, CurrentVersion))
+		return nullptr;
+
+	if (!fileManager.FileExists(*InPath))
+	{
+		TArray<uint8> header;
+		FMemoryWriter writer(header);
+		uint32 tag = XEUS_JOURNAL_FILE_TAG;
+		uint8 version = CurrentVersion;
+		writer << tag;
+		writer << version;
+		if (!FFileHelper::SaveArrayToFile(header, *InPath))
+			return nullptr;
+	}
+
+	int64 validEnd = 0;
+	if (!journal->Replay(validEnd))
+		return nullptr;
+
+	// A save was interrupted, rewrite the file without the torn record before appending to it
+	if (validEnd != fileManager.FileSize(*InPath))
+		return journal->Compact() ? journal : nullptr;
+
+	FScopeLock lock(&journal->Lock);
+	return journal->OpenWriter() ? journal : nullptr;
+}
+
+bool FDataSerializerJournal::Replay(int64& OutValidEnd)
+{
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_FileRead);
+	TUniquePtr<FArchive> file(IFileManager::Get().CreateFileReader(*Path, FILEREAD_AllowWrite));
+	if (!file.IsValid() || file->TotalSize() < Serializer::JournalHeaderSize)
+		return false;
+
+	uint32 tag = 0;
+	uint8 version = 0;
+	*file << tag;
+	*file << version;
+	if (file->IsError() || tag != XEUS_JOURNAL_FILE_TAG || version != CurrentVersion)
+		return false;
+
+	Index.Reset();
+	LiveSize = 0;
+	const int64 totalSize = file->TotalSize();
+	TArray<uint8> body;
+	int64 offset = file->Tell();
+	while (offset + Serializer::JournalRecordHeaderSize <= totalSize)
+	{
+		int32 bodySize = 0;
+		uint32 crc = 0;
+		*file << bodySize;
+		*file << crc;
+		if (file->IsError() || bodySize <= 0 || bodySize > Serializer::JournalMaxBodySize
+			|| offset + Serializer::JournalRecordHeaderSize + bodySize > totalSize)
+			break;
+
+		body.SetNumUninitialized(bodySize);
+		file->Serialize(body.GetData(), bodySize);
+		if (file->IsError() || FCrc::MemCrc32(body.GetData(), bodySize) != crc)
+			break;
+
+		uint8 flags = 0;
+		FString key;
+		int32 dataOffset = 0;
+		if (!Serializer::DecodeJournalBody(body, flags, key, dataOffset))
+			break;
+
+		// Later records replace earlier ones
+		if (const FEntry* previous = Index.Find(key))
+		{
+			LiveSize -= previous->RecordSize;
+			Index.Remove(key);
+		}
+
+		const int32 recordSize = Serializer::JournalRecordHeaderSize + bodySize;
+		if (!(flags & Serializer::JournalTombstone))
+		{
+			FEntry& entry = Index.Add(key);
+			entry.Offset = offset;
+			entry.RecordSize = recordSize;
+			entry.DataOffset = dataOffset;
+			entry.DataSize = recordSize - dataOffset;
+			LiveSize += recordSize;
+		}
+		offset += recordSize;
+	}
+
+	Serializer::RecordFileBytes(offset, false);
+	FileSize = offset;
+	OutValidEnd = offset;
+	return true;
+}
+
+bool FDataSerializerJournal::OpenWriter()
+{
+	Writer.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*Path, true, true));
+	return Writer.IsValid();
+}
+
+bool FDataSerializerJournal::Append(const FString& InKey, TArrayView<const uint8> InBytes)
+{
+	TArray<uint8> record;
+	TArray<FEntry> entries;
+	FEntry& entry = entries.AddDefaulted_GetRef();
+	entry.DataOffset = Serializer::EncodeJournalRecord(record, InKey, InBytes, 0);
+	entry.RecordSize = record.Num();
+	entry.DataSize = InBytes.Num();
+
+	bool bResult;
+	{
+		FScopeLock lock(&Lock);
+		bResult = WriteRecords(record, MakeArrayView(&InKey, 1), entries, {false});
+	}
+	CompactIfNeeded();
+	return bResult;
+}
+
+bool FDataSerializerJournal::AppendBatch(TArrayView<const FString> InKeys, TArrayView<const TArray<uint8>> InRecords)
+{
+	if (InKeys.Num() != InRecords.Num())
+		return false;
+
+	TArray<uint8> records;
+	TArray<FEntry> entries;
+	TArray<bool> tombstones;
+	entries.Reserve(InKeys.Num());
+	tombstones.Init(false, InKeys.Num());
+	for (int32 i = 0; i < InKeys.Num(); ++i)
+	{
+		const int32 start = records.Num();
+		FEntry& entry = entries.AddDefaulted_GetRef();
+		entry.Offset = start;
+		entry.DataOffset = Serializer::EncodeJournalRecord(records, InKeys[i], InRecords[i], 0);
+		entry.RecordSize = records.Num() - start;
+		entry.DataSize = InRecords[i].Num();
+	}
+
+	bool bResult;
+	{
+		FScopeLock lock(&Lock);
+		bResult = WriteRecords(records, InKeys, entries, tombstones);
+	}
+	CompactIfNeeded();
+	return bResult;
+}
+
+bool FDataSerializerJournal::Remove(const FString& InKey)
+{
+	TArray<uint8> record;
+	TArray<FEntry> entries;
+	FEntry& entry = entries.AddDefaulted_GetRef();
+	entry.DataOffset = Serializer::EncodeJournalRecord(record, InKey, {}, Serializer::JournalTombstone);
+	entry.RecordSize = record.Num();
+
+	bool bResult;
+	{
+		FScopeLock lock(&Lock);
+		if (!Index.Contains(InKey))
+			return false;
+		bResult = WriteRecords(record, MakeArrayView(&InKey, 1), entries, {true});
+	}
+	CompactIfNeeded();
+	return bResult;
+}
+
+bool FDataSerializerJournal::WriteRecords(const TArray<uint8>& InRecords, TArrayView<const FString> InKeys,
+                                          const TArray<FEntry>& InEntries, const TArray<bool>& InTombstones)
+{
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_FileWrite);
+	if (!Writer.IsValid())
+		return false;
+
+	// Entry offsets are relative to the start of the buffer until the write succeeds
+	const int64 start = FileSize;
+	if (!Writer->Write(InRecords.GetData(), InRecords.Num()) || !Writer->Flush())
+	{
+		// Part of the records may be written, the next append overwrites them so offsets stay right
+		if (!Writer->Seek(FileSize))
+		{
+			Writer.Reset();
+		}
+		return false;
+	}
+	FileSize += InRecords.Num();
+	Serializer::RecordFileBytes(InRecords.Num(), true);
+
+	for (int32 i = 0; i < InKeys.Num(); ++i)
+	{
+		if (const FEntry* previous = Index.Find(InKeys[i]))
+		{
+			LiveSize -= previous->RecordSize;
+			Index.Remove(InKeys[i]);
+		}
+
+		if (!InTombstones[i])
+		{
+			FEntry& entry = Index.Add(InKeys[i], InEntries[i]);
+			entry.Offset += start;
+			LiveSize += entry.RecordSize;
+		}
+	}
+	return true;
+}
+
+bool FDataSerializerJournal::Load(const FString& InKey, TArray<uint8>& OutBytes) const
+{
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_FileRead);
+	OutBytes.Reset();
+
+	// Hold the lock while reading, compaction may move the records
+	FScopeLock lock(&Lock);
+	const FEntry* entry = Index.Find(InKey);
+	if (entry == nullptr)
+		return false;
+
+	TUniquePtr<IFileHandle> file(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Path, true));
+	if (!file.IsValid() || !file->Seek(entry->Offset + entry->DataOffset))
+		return false;
+
+	OutBytes.SetNumUninitialized(entry->DataSize);
+	if (!file->Read(OutBytes.GetData(), entry->DataSize))
+	{
+		OutBytes.Reset();
+		return false;
+	}
+	Serializer::RecordFileBytes(entry->DataSize, false);
+	return true;
+}
+
+bool FDataSerializerJournal::LoadAll(TMap<FString, TArray<uint8>>& OutRecords) const
+{
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_FileRead);
+	OutRecords.Reset();
+
+	TArray<uint8> file;
+	TMap<FString, FEntry> index;
+	{
+		FScopeLock lock(&Lock);
+		if (!FFileHelper::LoadFileToArray(file, *Path, FILEREAD_AllowWrite))
+			return false;
+		index = Index;
+	}
+	Serializer::RecordFileBytes(file.Num(), false);
+
+	OutRecords.Reserve(index.Num());
+	for (const TPair<FString, FEntry>& pair : index)
+	{
+		const FEntry& entry = pair.Value;
+		if (entry.Offset + entry.RecordSize > file.Num())
+			return false;
+		OutRecords.Add(pair.Key, TArray<uint8>(file.GetData() + entry.Offset + entry.DataOffset, entry.DataSize));
+	}
+	return true;
+}
+
+TArray<FString> FDataSerializerJournal::GetKeys() const
+{
+	FScopeLock lock(&Lock);
+	TArray<FString> keys;
+	Index.GetKeys(keys);
+	return keys;
+}
+
+bool FDataSerializerJournal::Contains(const FString& InKey) const
+{
+	FScopeLock lock(&Lock);
+	return Index.Contains(InKey);
+}
+
+int64 FDataSerializerJournal::GetFileSize() const
+{
+	FScopeLock lock(&Lock);
+	return FileSize;
+}
+
+double FDataSerializerJournal::GetGarbageRatio() const
+{
+	FScopeLock lock(&Lock);
+	const int64 recordsSize = FileSize - Serializer::JournalHeaderSize;
+	return recordsSize > 0 ? static_cast<double>(recordsSize - LiveSize) / recordsSize : 0.0;
+}
+
+void FDataSerializerJournal::SetCompactionThreshold(double InThreshold, int64 InMinFileSize)
+{
+	CompactionThreshold = InThreshold;
+	MinCompactionFileSize = InMinFileSize;
+}
+
+void FDataSerializerJournal::CompactIfNeeded()
+{
+	if (CompactionThreshold < 1.0 && GetFileSize() >= MinCompactionFileSize && GetGarbageRatio() > CompactionThreshold)
+	{
+		CompactAsync();
+	}
+}
+
+bool FDataSerializerJournal::Compact()
+{
+	FScopeLock compactionLock(&CompactionLock);
+	return CompactInternal();
+}
+
+void FDataSerializerJournal::CompactAsync()
+{
+	if (bCompacting.exchange(true))
+		return;
+
+	// The task keeps the journal alive until it is done
+	TSharedRef<FDataSerializerJournal, ESPMode::ThreadSafe> self = AsShared();
+	Async(EAsyncExecution::ThreadPool, [self]()
+	{
+		self->Compact();
+		self->bCompacting = false;
+	});
+}
+
+void FDataSerializerJournal::WaitForCompaction() const
+{
+	while (bCompacting)
+	{
+		FPlatformProcess::Sleep(0.001f);
+	}
+}
+
+bool FDataSerializerJournal::CompactInternal()
+{
+	// Copy the live records of a snapshot of the index without blocking saves
+	TArray<TPair<FString, FEntry>> live;
+	int64 snapshotEnd;
+	{
+		FScopeLock lock(&Lock);
+		live = Index.Array();
+		snapshotEnd = FileSize;
+	}
+	live.Sort([](const TPair<FString, FEntry>& A, const TPair<FString, FEntry>& B)
+	{
+		return A.Value.Offset < B.Value.Offset;
+	});
+
+	IPlatformFile& platformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString tempPath = Path + TEXT(".compact");
+	TUniquePtr<IFileHandle> output(platformFile.OpenWrite(*tempPath));
+	TUniquePtr<IFileHandle> input(platformFile.OpenRead(*Path, true));
+	if (!output.IsValid() || !input.IsValid())
+		return false;
+
+	auto fail = [&]()
+	{
+		output.Reset();
+		platformFile.DeleteFile(*tempPath);
+		return false;
+	};
+
+	TArray<uint8> header;
+	FMemoryWriter headerWriter(header);
+	uint32 tag = XEUS_JOURNAL_FILE_TAG;
+	uint8 version = CurrentVersion;
+	headerWriter << tag;
+	headerWriter << version;
+	if (!output->Write(header.GetData(), header.Num()))
+		return fail();
+
+	TMap<int64, int64> movedOffsets;
+	movedOffsets.Reserve(live.Num());
+	TArray<uint8> buffer;
+	{
+		DATASERIALIZER_SCOPE(STAT_DataSerializer_FileWrite);
+		for (const TPair<FString, FEntry>& pair : live)
+		{
+			buffer.SetNumUninitialized(pair.Value.RecordSize);
+			if (!input->Seek(pair.Value.Offset) || !input->Read(buffer.GetData(), buffer.Num()))
+				return fail();
+			movedOffsets.Add(pair.Value.Offset, output->Tell());
+			if (!output->Write(buffer.GetData(), buffer.Num()))
+				return fail();
+		}
+	}
+
+	// Saves made meanwhile are copied as they are, then the packed file replaces the journal
+	FScopeLock lock(&Lock);
+	const int64 tailStart = output->Tell();
+	const int64 tailSize = FileSize - snapshotEnd;
+	if (tailSize > 0)
+	{
+		buffer.SetNumUninitialized(tailSize);
+		if (!input->Seek(snapshotEnd) || !input->Read(buffer.GetData(), tailSize)
+			|| !output->Write(buffer.GetData(), tailSize))
+			return fail();
+	}
+
+	TMap<FString, FEntry> index;
+	index.Reserve(Index.Num());
+	for (const TPair<FString, FEntry>& pair : Index)
+	{
+		FEntry entry = pair.Value;
+		if (entry.Offset >= snapshotEnd)
+		{
+			entry.Offset += tailStart - snapshotEnd;
+		}
+		else if (const int64* moved = movedOffsets.Find(entry.Offset))
+		{
+			entry.Offset = *moved;
+		}
+		else
+		{
+			return fail();
+		}
+		index.Add(pair.Key, entry);
+	}
+
+	const int64 size = output->Tell();
+	if (!output->Flush())
+		return fail();
+	output.Reset();
+	input.Reset();
+	Writer.Reset();
+
+	switch (Serializer::ReplaceFile(Path, tempPath))
+	{
+	case Serializer::EFileReplaceResult::Replaced:
+		Index = MoveTemp(index);
+		FileSize = size;
+		return OpenWriter();
+	case Serializer::EFileReplaceResult::Kept:
+		OpenWriter();
+		return false;
+	default:
+		// The journal is gone and the packed file not moved, appends fail until Open recovers the packed file
+		return false;
+	}
+}
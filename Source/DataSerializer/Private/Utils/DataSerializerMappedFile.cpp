@@ -0,0 +1,40 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utils/DataSerializerMappedFile.h"
+
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+
+FDataSerializerMappedFile::~FDataSerializerMappedFile()
+{
+	Region.Reset();
+	Handle.Reset();
+}
+
+TSharedPtr<FDataSerializerMappedFile, ESPMode::ThreadSafe> FDataSerializerMappedFile::Open(const FString& InPath)
+{
+	TSharedPtr<FDataSerializerMappedFile, ESPMode::ThreadSafe> file = MakeShareable(new FDataSerializerMappedFile());
+	file->Path = InPath;
+
+	IPlatformFile& platformFile = FPlatformFileManager::Get().GetPlatformFile();
+	file->Handle.Reset(platformFile.OpenMapped(*InPath));
+	if (file->Handle.IsValid() && file->Handle->GetFileSize() > 0)
+	{
+		file->Region.Reset(file->Handle->MapRegion(0, file->Handle->GetFileSize()));
+		if (file->Region.IsValid())
+		{
+			file->View = TArrayView64<const uint8>(file->Region->GetMappedPtr(), file->Region->GetMappedSize());
+			return file;
+		}
+	}
+
+	// No memory mapping on this platform or for this file, load it instead
+	file->Handle.Reset();
+	if (!FFileHelper::LoadFileToArray(file->LoadedBytes, *InPath))
+		return nullptr;
+
+	file->View = TArrayView64<const uint8>(file->LoadedBytes.GetData(), file->LoadedBytes.Num());
+	return file;
+}
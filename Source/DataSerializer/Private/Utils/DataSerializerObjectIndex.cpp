@@ -0,0 +1,132 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utils/DataSerializerObjectIndex.h"
+
+#include "Libs/DataSerializerLib.h"
+#include "Libs/DataSerializerObjectData.h"
+
+namespace Serializer
+{
+	/** Size of a serialized FDataSerializerObjectIndex::FEntry. */
+	constexpr int64 ObjectIndexEntrySize = sizeof(uint32) + sizeof(int64) + sizeof(int64);
+}
+
+bool FDataSerializerObjectIndex::Read(FArchive& InReader)
+{
+	Classes.Reset();
+	Keys.Reset();
+	KeyToIndex.Reset();
+	Entries.Reset();
+
+	int32 tag = 0;
+	uint8 version = 0;
+	uint8 flags = 0;
+	InReader << tag;
+	InReader << version;
+	InReader << flags;
+	if (InReader.IsError() || tag != XEUS_OBJECT_INDEX_TAG || version != CurrentVersion)
+		return false;
+
+	TArray<UClass*> classes;
+	if (!Serializer::FClassTable::Read(InReader, classes))
+		return false;
+	Classes.Append(classes);
+
+	uint32 n = 0;
+	InReader.SerializeIntPacked(n);
+	if (InReader.IsError() || n * Serializer::ObjectIndexEntrySize > InReader.TotalSize() - InReader.Tell())
+		return false;
+
+	if (flags & Serializer::ObjectIndexHasKeys)
+	{
+		Keys.SetNum(n);
+		KeyToIndex.Reserve(n);
+		for (uint32 i = 0; i < n; ++i)
+		{
+			InReader << Keys[i];
+			KeyToIndex.Add(Keys[i], i);
+		}
+	}
+
+	Entries.SetNum(n);
+	for (FEntry& entry : Entries)
+	{
+		InReader << entry;
+	}
+	DataStart = InReader.Tell();
+	if (InReader.IsError())
+		return false;
+
+	DataEnd = DataStart;
+	const int64 dataSize = InReader.TotalSize() - DataStart;
+	for (const FEntry& entry : Entries)
+	{
+		if (!Classes.IsValidIndex(entry.ClassIndex) || entry.Offset < 0 || entry.Size < 0
+			|| entry.Offset + entry.Size > dataSize)
+			return false;
+		DataEnd = FMath::Max(DataEnd, DataStart + entry.Offset + entry.Size);
+	}
+
+	InReader.Seek(DataEnd);
+	return true;
+}
+
+int32 FDataSerializerObjectIndex::FindByKey(const FString& InKey) const
+{
+	const int32* index = KeyToIndex.Find(InKey);
+	return index != nullptr ? *index : INDEX_NONE;
+}
+
+FString FDataSerializerObjectIndex::GetKey(int32 InIndex) const
+{
+	return Keys.IsValidIndex(InIndex) ? Keys[InIndex] : FString();
+}
+
+UClass* FDataSerializerObjectIndex::GetClass(int32 InIndex) const
+{
+	if (!Entries.IsValidIndex(InIndex))
+		return nullptr;
+	return Classes[Entries[InIndex].ClassIndex].Get();
+}
+
+bool FDataSerializerObjectIndex::DeSerializeObject(FArchive& InReader, int32 InIndex, UObject* InObjectOuter,
+                                                   UObject*& OutObject) const
+{
+	OutObject = nullptr;
+	UClass* objectClass = GetClass(InIndex);
+	if (objectClass == nullptr)
+		return false;
+
+	OutObject = NewObject<UObject>(InObjectOuter, objectClass);
+	return DeSerializeInto(InReader, InIndex, OutObject);
+}
+
+bool FDataSerializerObjectIndex::DeSerializeInto(FArchive& InReader, int32 InIndex, UObject* InTarget) const
+{
+	UClass* objectClass = GetClass(InIndex);
+	if (objectClass == nullptr || !IsValid(InTarget) || InTarget->GetClass() != objectClass)
+		return false;
+
+	const FEntry& entry = Entries[InIndex];
+	InReader.Seek(DataStart + entry.Offset);
+	const bool bResult = Serializer::ReadObjectData(InReader, InTarget);
+	return bResult && InReader.Tell() == DataStart + entry.Offset + entry.Size;
+}
+
+bool FDataSerializerObjectIndex::DeSerializeObjects(FArchive& InReader, int32 InFirst, int32 InCount,
+                                                    UObject* InObjectOuter, TArray<UObject*>& OutObjects) const
+{
+	if (InFirst < 0 || InCount < 0 || InFirst + InCount > Entries.Num())
+		return false;
+
+	OutObjects.Reserve(OutObjects.Num() + InCount);
+	for (int32 i = InFirst; i < InFirst + InCount; ++i)
+	{
+		UObject* object = nullptr;
+		if (!DeSerializeObject(InReader, i, InObjectOuter, object))
+			return false;
+		OutObjects.Add(object);
+	}
+	return true;
+}
@@ -0,0 +1,72 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utils/DataSerializerObjectPool.h"
+
+#include "Libs/DataSerializerObjectData.h"
+
+UDataSerializerObjectPool* UDataSerializerObjectPool::CreateObjectPool(int32 InMaxObjectsPerClass)
+{
+	UDataSerializerObjectPool* pool = NewObject<UDataSerializerObjectPool>();
+	pool->MaxObjectsPerClass = InMaxObjectsPerClass;
+	return pool;
+}
+
+UObject* UDataSerializerObjectPool::Acquire(TSubclassOf<UObject> InClass, UObject* InOuter)
+{
+	if (InClass == nullptr)
+		return nullptr;
+
+	UObject* outer = InOuter != nullptr ? InOuter : GetTransientPackage();
+	if (FDataSerializerPoolBucket* bucket = Buckets.Find(InClass))
+	{
+		while (bucket->Objects.Num() > 0)
+		{
+			UObject* object = bucket->Objects.Pop(false);
+			if (!IsValid(object))
+				continue;
+
+			if (object->GetOuter() != outer)
+			{
+				object->Rename(nullptr, outer, REN_DontCreateRedirectors | REN_DoNotDirty | REN_NonTransactional);
+			}
+			Serializer::ResetObjectToDefaults(object);
+			++NumReused;
+			return object;
+		}
+	}
+
+	++NumCreated;
+	return NewObject<UObject>(outer, InClass);
+}
+
+void UDataSerializerObjectPool::Release(UObject* InObject)
+{
+	if (!IsValid(InObject))
+		return;
+
+	FDataSerializerPoolBucket& bucket = Buckets.FindOrAdd(InObject->GetClass());
+	if (bucket.Objects.Num() < MaxObjectsPerClass)
+	{
+		bucket.Objects.Add(InObject);
+	}
+}
+
+void UDataSerializerObjectPool::ReleaseObjects(const TArray<UObject*>& InObjects)
+{
+	for (UObject* object : InObjects)
+	{
+		Release(object);
+	}
+}
+
+int32 UDataSerializerObjectPool::GetNumPooled(TSubclassOf<UObject> InClass) const
+{
+	const FDataSerializerPoolBucket* bucket = Buckets.Find(InClass);
+	return bucket != nullptr ? bucket->Objects.Num() : 0;
+}
+
+void UDataSerializerObjectPool::Empty()
+{
+	Buckets.Empty();
+}
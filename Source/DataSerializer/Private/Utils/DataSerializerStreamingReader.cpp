@@ -0,0 +1,159 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utils/DataSerializerStreamingReader.h"
+
+#include "Async/Async.h"
+#include "HAL/PlatformFileManager.h"
+#include "Libs/DataSerializerStats.h"
+
+FDataSerializerStreamingReader::~FDataSerializerStreamingReader()
+{
+	Close();
+}
+
+TUniquePtr<FDataSerializerStreamingReader> FDataSerializerStreamingReader::Open(const FString& InPath,
+                                                                                int32 InChunkSize)
+{
+	TUniquePtr<FDataSerializerStreamingReader> reader(new FDataSerializerStreamingReader());
+	reader->Handle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*InPath));
+	if (!reader->Handle.IsValid())
+		return nullptr;
+
+	reader->Path = InPath;
+	reader->Size = reader->Handle->Size();
+	reader->ChunkSize = FMath::Max(InChunkSize, 4 * 1024);
+	reader->SetIsLoading(true);
+	reader->SetIsPersistent(true);
+	return reader;
+}
+
+void FDataSerializerStreamingReader::Serialize(void* Data, int64 Num)
+{
+	if (Num <= 0 || IsError())
+		return;
+
+	if (Num > Size - Pos)
+	{
+		FMemory::Memzero(Data, Num);
+		SetError();
+		return;
+	}
+
+	uint8* out = static_cast<uint8*>(Data);
+
+	// Large reads skip the chunks, buffering them would only add a copy
+	if (Num >= ChunkSize && (Pos < CurrentOffset || Pos >= CurrentOffset + Current.Num()))
+	{
+		if (!WaitForPrefetch() || !ReadAt(Pos, out, Num))
+		{
+			FMemory::Memzero(Data, Num);
+			SetError();
+			return;
+		}
+		Pos += Num;
+		return;
+	}
+
+	while (Num > 0)
+	{
+		if ((Pos < CurrentOffset || Pos >= CurrentOffset + Current.Num()) && !LoadChunk())
+		{
+			FMemory::Memzero(out, Num);
+			SetError();
+			return;
+		}
+
+		const int64 copy = FMath::Min(Num, CurrentOffset + Current.Num() - Pos);
+		FMemory::Memcpy(out, Current.GetData() + (Pos - CurrentOffset), copy);
+		out += copy;
+		Pos += copy;
+		Num -= copy;
+	}
+}
+
+void FDataSerializerStreamingReader::Seek(int64 InPos)
+{
+	if (InPos < 0 || InPos > Size)
+	{
+		SetError();
+		return;
+	}
+	Pos = InPos;
+}
+
+bool FDataSerializerStreamingReader::Close()
+{
+	WaitForPrefetch();
+	Handle.Reset();
+	Current.Empty();
+	Next.Empty();
+	return !IsError();
+}
+
+bool FDataSerializerStreamingReader::LoadChunk()
+{
+	if (!WaitForPrefetch())
+		return false;
+
+	// Sequential reads find their chunk prefetched
+	if (NextOffset != INDEX_NONE && Pos >= NextOffset && Pos < NextOffset + Next.Num())
+	{
+		Swap(Current, Next);
+		CurrentOffset = NextOffset;
+	}
+	else
+	{
+		CurrentOffset = Pos - Pos % ChunkSize;
+		Current.SetNumUninitialized(static_cast<int32>(FMath::Min<int64>(ChunkSize, Size - CurrentOffset)), false);
+		if (!ReadAt(CurrentOffset, Current.GetData(), Current.Num()))
+		{
+			Current.Reset();
+			return false;
+		}
+	}
+	NextOffset = INDEX_NONE;
+
+	StartPrefetch();
+	return true;
+}
+
+void FDataSerializerStreamingReader::StartPrefetch()
+{
+	const int64 offset = CurrentOffset + Current.Num();
+	if (offset >= Size || !Handle.IsValid())
+		return;
+
+	NextOffset = offset;
+	Next.SetNumUninitialized(static_cast<int32>(FMath::Min<int64>(ChunkSize, Size - offset)), false);
+	Prefetch = Async(EAsyncExecution::ThreadPool, [this, offset]()
+	{
+		return ReadAt(offset, Next.GetData(), Next.Num());
+	});
+}
+
+bool FDataSerializerStreamingReader::WaitForPrefetch()
+{
+	if (!Prefetch.IsValid())
+		return Handle.IsValid();
+
+	const bool bResult = Prefetch.Get();
+	Prefetch.Reset();
+
+	// A failed prefetch is not an error yet, the chunk may never be needed
+	if (!bResult)
+	{
+		NextOffset = INDEX_NONE;
+	}
+	return Handle.IsValid();
+}
+
+bool FDataSerializerStreamingReader::ReadAt(int64 InOffset, uint8* OutData, int64 InNum)
+{
+	DATASERIALIZER_SCOPE(STAT_DataSerializer_FileRead);
+	if (!Handle->Seek(InOffset) || !Handle->Read(OutData, InNum))
+		return false;
+
+	Serializer::RecordFileBytes(InNum, false);
+	return true;
+}
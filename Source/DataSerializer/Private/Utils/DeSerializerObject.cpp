@@ -3,7 +3,13 @@
 
 #include "Utils/DeSerializerObject.h"
 
+#include "Libs/DataSerializerArrays.h"
 #include "Libs/DataSerializerLib.h"
+#include "Libs/DataSerializerProperties.h"
+#include "Libs/DataSerializerQuantization.h"
+#include "Libs/DataSerializerStats.h"
+#include "Libs/DataSerializerStream.h"
+#include "Memory/MemoryView.h"
 
 namespace Serializer
 {
@@ -15,61 +21,465 @@ UDeSerializerObject::UDeSerializerObject()
 {
 }
 
-FMemoryReader& UDeSerializerObject::GetMemoryReaderRef() const
+FArchive& UDeSerializerObject::GetMemoryReaderRef()
 {
-	if (MemoryReader.IsValid())
+	if (MemoryReader.IsSet())
 	{
+		NumBitsLeft = 0;
 		return *MemoryReader;
 	}
+	if (StreamReader.IsValid())
+	{
+		NumBitsLeft = 0;
+		return *StreamReader;
+	}
 
 	return Serializer::tempReader; // DONT DO THIS
 }
 
+bool UDeSerializerObject::TryReadInt32Encoded(int32& OutValue)
+{
+	if (IntEncoding == EDataSerializerIntEncoding::Fixed)
+		return TryReadT(OutValue);
+
+	int64 value = 0;
+	if (!TryReadInt64Encoded(value) || value < MIN_int32 || value > MAX_int32)
+		return false;
+
+	OutValue = static_cast<int32>(value);
+	return true;
+}
+
+bool UDeSerializerObject::TryReadInt64Encoded(int64& OutValue)
+{
+	if (IntEncoding == EDataSerializerIntEncoding::Fixed)
+		return TryReadT(OutValue);
+
+	if (!HasReader())
+		return false;
+
+	return Serializer::ReadVarInt(GetMemoryReaderRef(), OutValue);
+}
+
+bool UDeSerializerObject::TryReadCount(int64& OutCount, int64 InElementSize)
+{
+	if (!HasReader())
+		return false;
+
+	FArchive& reader = GetMemoryReaderRef();
+	if (IntEncoding == EDataSerializerIntEncoding::Fixed)
+	{
+		int32 count = 0;
+		if (!TryReadT(count))
+			return false;
+		OutCount = count;
+	}
+	else
+	{
+		uint64 count = 0;
+		if (!Serializer::ReadVarUInt(reader, count) || count > static_cast<uint64>(MAX_int64))
+			return false;
+		OutCount = static_cast<int64>(count);
+	}
+	return OutCount >= 0 && OutCount <= (reader.TotalSize() - reader.Tell()) / InElementSize;
+}
+
 void UDeSerializerObject::Clear()
 {
 	MemoryReader.Reset();
+	StreamReader.Reset();
+	OwnedBytes.Empty();
+	SharedBytes.Reset();
+	MappedFile.Reset();
+	BitBuffer = 0;
+	NumBitsLeft = 0;
 }
 
 void UDeSerializerObject::Start(const TArray<uint8>& InBytes)
+{
+	// Blueprint arrays are often temporaries, keep a copy
+	StartOwned(CopyTemp(InBytes));
+}
+
+void UDeSerializerObject::StartOwned(TArray<uint8>&& InBytes)
+{
+	Clear();
+	OwnedBytes = MoveTemp(InBytes);
+	BeginStream(OwnedBytes);
+}
+
+void UDeSerializerObject::StartView(TArrayView64<const uint8> InBytes, int64 InOffset, int64 InLength)
+{
+	Clear();
+	InOffset = FMath::Clamp<int64>(InOffset, 0, InBytes.Num());
+	const int64 available = InBytes.Num() - InOffset;
+	InLength = InLength < 0 ? available : FMath::Min(InLength, available);
+	BeginStream(InBytes.Slice(InOffset, InLength));
+}
+
+void UDeSerializerObject::StartShared(const TSharedRef<const TArray<uint8>, ESPMode::ThreadSafe>& InBytes,
+                                      int64 InOffset, int64 InLength)
+{
+	StartView(TArrayView64<const uint8>(InBytes->GetData(), InBytes->Num()), InOffset, InLength);
+	SharedBytes = InBytes;
+}
+
+void UDeSerializerObject::StartMapped(const TSharedRef<FDataSerializerMappedFile, ESPMode::ThreadSafe>& InFile,
+                                      int64 InOffset, int64 InLength)
+{
+	StartView(InFile->GetView(), InOffset, InLength);
+	MappedFile = InFile;
+}
+
+bool UDeSerializerObject::StartFromFile(FString InPath)
+{
+	TSharedPtr<FDataSerializerMappedFile, ESPMode::ThreadSafe> file;
+	{
+		DATASERIALIZER_SCOPE(STAT_DataSerializer_FileRead);
+		file = FDataSerializerMappedFile::Open(InPath);
+	}
+	if (!file.IsValid())
+	{
+		Clear();
+		return false;
+	}
+
+	StartMapped(file.ToSharedRef());
+	return !GetMemoryReaderRef().IsError();
+}
+
+bool UDeSerializerObject::StartFromFileStreamed(FString InPath, int32 InChunkSize)
+{
+	TUniquePtr<FDataSerializerStreamingReader> reader = FDataSerializerStreamingReader::Open(InPath, InChunkSize);
+	if (!reader.IsValid())
+	{
+		Clear();
+		return false;
+	}
+
+	StartStream(MoveTemp(reader));
+	return !GetMemoryReaderRef().IsError();
+}
+
+void UDeSerializerObject::StartStream(TUniquePtr<FDataSerializerStreamingReader>&& InReader)
 {
 	Clear();
-	MemoryReader = MakeShareable<FMemoryReader>(new FMemoryReader(InBytes));
+	StreamReader = MoveTemp(InReader);
+	if (StreamReader.IsValid())
+	{
+		ReadPreamble();
+	}
 }
 
-bool UDeSerializerObject::TryReadInt(int32& OutInt) { return TryReadT(OutInt); }
+void UDeSerializerObject::BeginStream(TArrayView64<const uint8> InBytes)
+{
+	MemoryReader.Emplace(MakeMemoryView(InBytes.GetData(), InBytes.Num()));
+	ReadPreamble();
+}
 
-bool UDeSerializerObject::TryReadInt64(int64& OutInt64) { return TryReadT(OutInt64); }
+void UDeSerializerObject::ReadPreamble()
+{
+	// Only streams written with a non-default mode start with a preamble
+	Serializer::FStreamPreamble expected;
+	expected.Flags = IntEncoding == EDataSerializerIntEncoding::VarInt ? Serializer::StreamVarInt : 0;
+	expected.Flags |= bPackBools ? Serializer::StreamPackedBools : 0;
+	if (!expected.IsNeeded())
+		return;
+
+	FArchive& reader = GetMemoryReaderRef();
+	Serializer::FStreamPreamble preamble;
+	if (!preamble.Read(reader) || preamble.Flags != expected.Flags)
+	{
+		reader.SetError();
+	}
+}
+
+void UDeSerializerObject::SetIntEncoding(EDataSerializerIntEncoding InEncoding)
+{
+	IntEncoding = InEncoding;
+}
+
+void UDeSerializerObject::SetPackBools(bool bInPackBools)
+{
+	bPackBools = bInPackBools;
+}
+
+bool UDeSerializerObject::TryReadInt(int32& OutInt) { return TryReadInt32Encoded(OutInt); }
+
+bool UDeSerializerObject::TryReadInt64(int64& OutInt64) { return TryReadInt64Encoded(OutInt64); }
 
 bool UDeSerializerObject::TryReadFloat(float& OutFloat) { return TryReadT(OutFloat); }
 
 bool UDeSerializerObject::TryReadDouble(double& OutDouble) { return TryReadT(OutDouble); }
 
-bool UDeSerializerObject::TryReadBool(bool& OutBool) { return TryReadT(OutBool); }
+bool UDeSerializerObject::TryReadBool(bool& OutBool)
+{
+	if (!bPackBools)
+		return TryReadT(OutBool);
+
+	int32 value = 0;
+	if (!TryReadBits(value, 1))
+		return false;
+
+	OutBool = value != 0;
+	return true;
+}
+
+bool UDeSerializerObject::TryReadBits(int32& OutValue, int32 InNumBits)
+{
+	if (!HasReader())
+		return false;
+
+	FArchive& reader = MemoryReader.IsSet() ? static_cast<FArchive&>(*MemoryReader) : *StreamReader;
+	uint32 value = 0;
+	int32 numRead = 0;
+	const int32 numBits = FMath::Clamp(InNumBits, 0, 32);
+	while (numRead < numBits)
+	{
+		if (NumBitsLeft == 0)
+		{
+			reader << BitBuffer;
+			if (reader.IsError())
+				return false;
+			NumBitsLeft = 8;
+		}
+
+		const int32 take = FMath::Min(NumBitsLeft, numBits - numRead);
+		value |= (static_cast<uint32>(BitBuffer) & ((1u << take) - 1)) << numRead;
+		BitBuffer >>= take;
+		NumBitsLeft -= take;
+		numRead += take;
+	}
+
+	OutValue = static_cast<int32>(value);
+	return true;
+}
 
 bool UDeSerializerObject::TryReadUInt8(uint8& OutUInt8) { return TryReadT(OutUInt8); }
 
 bool UDeSerializerObject::TryReadVector(FVector& OutVector) { return TryReadT(OutVector); }
 
-bool UDeSerializerObject::TryReadIntVector(FIntVector& OutIntVector) { return TryReadT(OutIntVector); }
+bool UDeSerializerObject::TryReadIntVector(FIntVector& OutIntVector)
+{
+	FIntVector value;
+	if (!TryReadInt32Encoded(value.X) || !TryReadInt32Encoded(value.Y) || !TryReadInt32Encoded(value.Z))
+		return false;
+
+	OutIntVector = value;
+	return true;
+}
 
 bool UDeSerializerObject::TryReadVector2D(FVector2D& OutVector2D) { return TryReadT(OutVector2D); }
 
-bool UDeSerializerObject::TryReadIntPoint(FIntPoint& OutIntPoint) { return TryReadT(OutIntPoint); }
+bool UDeSerializerObject::TryReadIntPoint(FIntPoint& OutIntPoint)
+{
+	FIntPoint value;
+	if (!TryReadInt32Encoded(value.X) || !TryReadInt32Encoded(value.Y))
+		return false;
+
+	OutIntPoint = value;
+	return true;
+}
 
 bool UDeSerializerObject::TryReadRotator(FRotator& OutRotator) { return TryReadT(OutRotator); }
 
 bool UDeSerializerObject::TryReadTransform(FTransform& OutTransform) { return TryReadT(OutTransform); }
 
+bool UDeSerializerObject::TryReadVectorQuantized(FVector& OutVector, double InPrecision, double InRange)
+{
+	if (!HasReader())
+		return false;
+
+	return Serializer::ReadQuantizedVector(GetMemoryReaderRef(), OutVector,
+	                                       Serializer::FQuantizedRange(InPrecision, InRange));
+}
+
+bool UDeSerializerObject::TryReadRotatorCompressed(FRotator& OutRotator)
+{
+	if (!HasReader())
+		return false;
+
+	return Serializer::ReadCompressedRotator(GetMemoryReaderRef(), OutRotator);
+}
+
+bool UDeSerializerObject::TryReadTransformQuantized(FTransform& OutTransform, double InTranslationPrecision,
+                                                    double InTranslationRange, double InScalePrecision,
+                                                    double InScaleRange)
+{
+	if (!HasReader())
+		return false;
+
+	return Serializer::ReadQuantizedTransform(GetMemoryReaderRef(), OutTransform,
+	                                          Serializer::FQuantizedRange(InTranslationPrecision, InTranslationRange),
+	                                          Serializer::FQuantizedRange(InScalePrecision, InScaleRange));
+}
+
+bool UDeSerializerObject::TryReadIntArray(TArray<int32>& OutInts)
+{
+	int64 num = 0;
+	if (!TryReadCount(num, sizeof(int32)) || num > MAX_int32)
+		return false;
+
+	return Serializer::ReadArrayData(GetMemoryReaderRef(), OutInts, static_cast<int32>(num));
+}
+
+bool UDeSerializerObject::TryReadInt64Array(TArray<int64>& OutInt64s)
+{
+	int64 num = 0;
+	if (!TryReadCount(num, sizeof(int64)) || num > MAX_int32)
+		return false;
+
+	return Serializer::ReadArrayData(GetMemoryReaderRef(), OutInt64s, static_cast<int32>(num));
+}
+
+bool UDeSerializerObject::TryReadFloatArray(TArray<float>& OutFloats)
+{
+	int64 num = 0;
+	if (!TryReadCount(num, sizeof(float)) || num > MAX_int32)
+		return false;
+
+	return Serializer::ReadArrayData(GetMemoryReaderRef(), OutFloats, static_cast<int32>(num));
+}
+
+bool UDeSerializerObject::TryReadDoubleArray(TArray<double>& OutDoubles)
+{
+	int64 num = 0;
+	if (!TryReadCount(num, sizeof(double)) || num > MAX_int32)
+		return false;
+
+	return Serializer::ReadArrayData(GetMemoryReaderRef(), OutDoubles, static_cast<int32>(num));
+}
+
+bool UDeSerializerObject::TryReadUInt8Array(TArray<uint8>& OutBytes)
+{
+	int64 num = 0;
+	if (!TryReadCount(num, sizeof(uint8)) || num > MAX_int32)
+		return false;
+
+	return Serializer::ReadArrayData(GetMemoryReaderRef(), OutBytes, static_cast<int32>(num));
+}
+
+bool UDeSerializerObject::TryReadVectorArray(TArray<FVector>& OutVectors)
+{
+	int64 num = 0;
+	if (!TryReadCount(num, sizeof(FVector)) || num > MAX_int32)
+		return false;
+
+	return Serializer::ReadArrayData(GetMemoryReaderRef(), OutVectors, static_cast<int32>(num));
+}
+
+bool UDeSerializerObject::TryReadVector2DArray(TArray<FVector2D>& OutVectors)
+{
+	int64 num = 0;
+	if (!TryReadCount(num, sizeof(FVector2D)) || num > MAX_int32)
+		return false;
+
+	return Serializer::ReadArrayData(GetMemoryReaderRef(), OutVectors, static_cast<int32>(num));
+}
+
+bool UDeSerializerObject::TryReadRotatorArray(TArray<FRotator>& OutRotators)
+{
+	int64 num = 0;
+	if (!TryReadCount(num, sizeof(FRotator)) || num > MAX_int32)
+		return false;
+
+	return Serializer::ReadArrayData(GetMemoryReaderRef(), OutRotators, static_cast<int32>(num));
+}
+
+bool UDeSerializerObject::TryReadTransformArray(TArray<FTransform>& OutTransforms)
+{
+	int64 num = 0;
+	if (!TryReadCount(num, Serializer::TransformArrayStride * sizeof(double)) || num > MAX_int32)
+		return false;
+
+	return Serializer::ReadTransformArrayData(GetMemoryReaderRef(), OutTransforms, static_cast<int32>(num));
+}
+
 bool UDeSerializerObject::TryReadString(FString& OutString) { return TryReadT(OutString); }
 
 bool UDeSerializerObject::TryReadObject(UObject* InObjectOuter, UObject*& OutObject)
 {
-	FMemoryReader& memoryReader = GetMemoryReaderRef();
-	return UDataSerializerLib::DeSerializeObjectCpp(memoryReader, InObjectOuter, OutObject);
+	// Objects are written as a byte count followed by the object blob
+	OutObject = nullptr;
+	int64 count = 0;
+	if (!TryReadCount(count) || count == 0)
+		return false;
+
+	FArchive& memoryReader = GetMemoryReaderRef();
+	const int64 end = memoryReader.Tell() + count;
+	const bool bResult = UDataSerializerLib::DeSerializeObjectCpp(memoryReader, InObjectOuter, OutObject);
+	memoryReader.Seek(end);
+	return bResult;
 }
 
 bool UDeSerializerObject::TryReadObjects(UObject* InObjectOuter, TArray<UObject*>& OutObjects)
 {
-	FMemoryReader& memoryReader = GetMemoryReaderRef();
-	return UDataSerializerLib::DeSerializeObjectsCpp(memoryReader, InObjectOuter, OutObjects);
+	int64 count = 0;
+	if (!TryReadCount(count) || count == 0)
+		return false;
+
+	FArchive& memoryReader = GetMemoryReaderRef();
+	const int64 end = memoryReader.Tell() + count;
+	const bool bResult = UDataSerializerLib::DeSerializeObjectsCpp(memoryReader, InObjectOuter, OutObjects);
+	memoryReader.Seek(end);
+	return bResult;
+}
+
+bool UDeSerializerObject::TryReadProperty(const FProperty* InProperty, void* OutValue)
+{
+	uint32 typeHash = 0;
+	if (InProperty == nullptr || OutValue == nullptr || !TryReadT(typeHash)
+		|| typeHash != Serializer::GetPropertyTypeHash(InProperty))
+		return false;
+
+	return Serializer::ReadPropertyValue(GetMemoryReaderRef(), InProperty, OutValue);
+}
+
+// Stubs, Blueprint calls go through the exec functions below and C++ code calls TryReadProperty
+bool UDeSerializerObject::TryReadStruct(int32& OutValue) { check(0); return false; }
+
+bool UDeSerializerObject::TryReadArray(TArray<int32>& OutValue) { check(0); return false; }
+
+bool UDeSerializerObject::TryReadMap(TMap<int32, int32>& OutValue) { check(0); return false; }
+
+bool UDeSerializerObject::TryReadSet(TSet<int32>& OutValue) { check(0); return false; }
+
+DEFINE_FUNCTION(UDeSerializerObject::execTryReadStruct)
+{
+	void* value = nullptr;
+	const FStructProperty* property = Serializer::StepWildcardParam<FStructProperty>(Stack, value);
+	P_FINISH;
+	P_NATIVE_BEGIN;
+	*static_cast<bool*>(RESULT_PARAM) = P_THIS->TryReadProperty(property, value);
+	P_NATIVE_END;
+}
+
+DEFINE_FUNCTION(UDeSerializerObject::execTryReadArray)
+{
+	void* value = nullptr;
+	const FArrayProperty* property = Serializer::StepWildcardParam<FArrayProperty>(Stack, value);
+	P_FINISH;
+	P_NATIVE_BEGIN;
+	*static_cast<bool*>(RESULT_PARAM) = P_THIS->TryReadProperty(property, value);
+	P_NATIVE_END;
+}
+
+DEFINE_FUNCTION(UDeSerializerObject::execTryReadMap)
+{
+	void* value = nullptr;
+	const FMapProperty* property = Serializer::StepWildcardParam<FMapProperty>(Stack, value);
+	P_FINISH;
+	P_NATIVE_BEGIN;
+	*static_cast<bool*>(RESULT_PARAM) = P_THIS->TryReadProperty(property, value);
+	P_NATIVE_END;
+}
+
+DEFINE_FUNCTION(UDeSerializerObject::execTryReadSet)
+{
+	void* value = nullptr;
+	const FSetProperty* property = Serializer::StepWildcardParam<FSetProperty>(Stack, value);
+	P_FINISH;
+	P_NATIVE_BEGIN;
+	*static_cast<bool*>(RESULT_PARAM) = P_THIS->TryReadProperty(property, value);
+	P_NATIVE_END;
 }
@@ -3,7 +3,11 @@
 
 #include "Utils/SerializerObject.h"
 
+#include "Libs/DataSerializerArrays.h"
 #include "Libs/DataSerializerLib.h"
+#include "Libs/DataSerializerProperties.h"
+#include "Libs/DataSerializerQuantization.h"
+#include "Libs/DataSerializerStream.h"
 
 USerializerObject::USerializerObject()
 {
@@ -11,70 +15,361 @@ USerializerObject::USerializerObject()
 
 FMemoryWriter& USerializerObject::GetMemoryWriterRef()
 {
-	if (!MemoryWriter.IsValid())
+	if (!MemoryWriter.IsSet())
 	{
 		Prepare();
 	}
+	FlushBits();
 	return *MemoryWriter;
 }
 
-void USerializerObject::GetBytes(TArray<uint8>& OutBytes) { OutBytes = Bytes; }
+void USerializerObject::FlushBits()
+{
+	if (NumPendingBits > 0)
+	{
+		*MemoryWriter << PendingBits;
+		PendingBits = 0;
+		NumPendingBits = 0;
+	}
+}
+
+void USerializerObject::WriteInt32(int32 InValue)
+{
+	if (IntEncoding == EDataSerializerIntEncoding::VarInt)
+	{
+		Serializer::WriteVarInt(GetMemoryWriterRef(), InValue);
+	}
+	else
+	{
+		GetMemoryWriterRef() << InValue;
+	}
+}
+
+void USerializerObject::WriteInt64(int64 InValue)
+{
+	if (IntEncoding == EDataSerializerIntEncoding::VarInt)
+	{
+		Serializer::WriteVarInt(GetMemoryWriterRef(), InValue);
+	}
+	else
+	{
+		GetMemoryWriterRef() << InValue;
+	}
+}
 
-void USerializerObject::SerializeInt(int32 InInteger) { GetMemoryWriterRef() << InInteger; }
+void USerializerObject::WriteArrayNum(int32 InNum)
+{
+	if (IntEncoding == EDataSerializerIntEncoding::VarInt)
+	{
+		Serializer::WriteVarUInt(GetMemoryWriterRef(), InNum);
+	}
+	else
+	{
+		GetMemoryWriterRef() << InNum;
+	}
+}
 
-void USerializerObject::SerializeBigInt(int64 InBigInt) { GetMemoryWriterRef() << InBigInt; }
+void USerializerObject::WriteByteArray(const TArray<uint8>& InBytes)
+{
+	WriteArrayNum(InBytes.Num());
+	Serializer::WriteArrayData(GetMemoryWriterRef(), InBytes);
+}
+
+void USerializerObject::GetBytes(TArray<uint8>& OutBytes)
+{
+	OutBytes = Bytes;
+	// Pending bits are copied without being flushed, later bit writes keep filling the same byte
+	if (NumPendingBits > 0)
+	{
+		OutBytes.Add(PendingBits);
+	}
+}
+
+void USerializerObject::SerializeInt(int32 InInteger) { WriteInt32(InInteger); }
+
+void USerializerObject::SerializeBigInt(int64 InBigInt) { WriteInt64(InBigInt); }
 
 void USerializerObject::SerializeFloat(float InFloat) { GetMemoryWriterRef() << InFloat; }
 
 void USerializerObject::SerializeDouble(double InDouble) { GetMemoryWriterRef() << InDouble; }
 
-void USerializerObject::SerializeBool(bool InBool) { GetMemoryWriterRef() << InBool; }
+void USerializerObject::SerializeBool(bool InBool)
+{
+	if (bPackBools)
+	{
+		SerializeBits(InBool ? 1 : 0, 1);
+	}
+	else
+	{
+		GetMemoryWriterRef() << InBool;
+	}
+}
+
+void USerializerObject::SerializeBits(int32 InValue, int32 InNumBits)
+{
+	if (!MemoryWriter.IsSet())
+	{
+		Prepare();
+	}
+
+	uint32 value = static_cast<uint32>(InValue);
+	int32 numBits = FMath::Clamp(InNumBits, 0, 32);
+	while (numBits > 0)
+	{
+		const int32 take = FMath::Min(8 - NumPendingBits, numBits);
+		PendingBits |= static_cast<uint8>((value & ((1u << take) - 1)) << NumPendingBits);
+		value >>= take;
+		numBits -= take;
+		NumPendingBits += take;
+
+		if (NumPendingBits == 8)
+		{
+			*MemoryWriter << PendingBits;
+			PendingBits = 0;
+			NumPendingBits = 0;
+		}
+	}
+}
 
 void USerializerObject::SerializeByte(uint8 InByte) { GetMemoryWriterRef() << InByte; }
 
 void USerializerObject::SerializeVector(FVector InVector) { GetMemoryWriterRef() << InVector; }
 
-void USerializerObject::SerializeIntVector(FIntVector InVector) { GetMemoryWriterRef() << InVector; }
+void USerializerObject::SerializeIntVector(FIntVector InVector)
+{
+	WriteInt32(InVector.X);
+	WriteInt32(InVector.Y);
+	WriteInt32(InVector.Z);
+}
 
 void USerializerObject::SerializeVector2D(FVector2D InVector) { GetMemoryWriterRef() << InVector; }
 
-void USerializerObject::SerializePoint(FIntPoint InPoint) { GetMemoryWriterRef() << InPoint; }
+void USerializerObject::SerializePoint(FIntPoint InPoint)
+{
+	WriteInt32(InPoint.X);
+	WriteInt32(InPoint.Y);
+}
 
 void USerializerObject::SerializeRotator(FRotator InRotator) { GetMemoryWriterRef() << InRotator; }
 
 void USerializerObject::SerializeTransform(FTransform InTransform) { GetMemoryWriterRef() << InTransform; }
 
+void USerializerObject::SerializeVectorQuantized(FVector InVector, double InPrecision, double InRange)
+{
+	Serializer::WriteQuantizedVector(GetMemoryWriterRef(), InVector, Serializer::FQuantizedRange(InPrecision, InRange));
+}
+
+void USerializerObject::SerializeRotatorCompressed(FRotator InRotator)
+{
+	Serializer::WriteCompressedRotator(GetMemoryWriterRef(), InRotator);
+}
+
+void USerializerObject::SerializeTransformQuantized(FTransform InTransform, double InTranslationPrecision,
+                                                    double InTranslationRange, double InScalePrecision,
+                                                    double InScaleRange)
+{
+	Serializer::WriteQuantizedTransform(GetMemoryWriterRef(), InTransform,
+	                                    Serializer::FQuantizedRange(InTranslationPrecision, InTranslationRange),
+	                                    Serializer::FQuantizedRange(InScalePrecision, InScaleRange));
+}
+
+void USerializerObject::SerializeIntArray(const TArray<int32>& InIntegers)
+{
+	WriteArrayNum(InIntegers.Num());
+	Serializer::WriteArrayData(GetMemoryWriterRef(), InIntegers);
+}
+
+void USerializerObject::SerializeBigIntArray(const TArray<int64>& InBigInts)
+{
+	WriteArrayNum(InBigInts.Num());
+	Serializer::WriteArrayData(GetMemoryWriterRef(), InBigInts);
+}
+
+void USerializerObject::SerializeFloatArray(const TArray<float>& InFloats)
+{
+	WriteArrayNum(InFloats.Num());
+	Serializer::WriteArrayData(GetMemoryWriterRef(), InFloats);
+}
+
+void USerializerObject::SerializeDoubleArray(const TArray<double>& InDoubles)
+{
+	WriteArrayNum(InDoubles.Num());
+	Serializer::WriteArrayData(GetMemoryWriterRef(), InDoubles);
+}
+
+void USerializerObject::SerializeByteArray(const TArray<uint8>& InBytes)
+{
+	WriteByteArray(InBytes);
+}
+
+void USerializerObject::SerializeVectorArray(const TArray<FVector>& InVectors)
+{
+	WriteArrayNum(InVectors.Num());
+	Serializer::WriteArrayData(GetMemoryWriterRef(), InVectors);
+}
+
+void USerializerObject::SerializeVector2DArray(const TArray<FVector2D>& InVectors)
+{
+	WriteArrayNum(InVectors.Num());
+	Serializer::WriteArrayData(GetMemoryWriterRef(), InVectors);
+}
+
+void USerializerObject::SerializeRotatorArray(const TArray<FRotator>& InRotators)
+{
+	WriteArrayNum(InRotators.Num());
+	Serializer::WriteArrayData(GetMemoryWriterRef(), InRotators);
+}
+
+void USerializerObject::SerializeTransformArray(const TArray<FTransform>& InTransforms)
+{
+	WriteArrayNum(InTransforms.Num());
+	Serializer::WriteTransformArrayData(GetMemoryWriterRef(), InTransforms);
+}
+
 void USerializerObject::SerializeString(FString InString) { GetMemoryWriterRef() << InString; }
 
 void USerializerObject::SerializeObject(UObject* InObject)
 {
-	if (!IsValid(InObject))
-		return;
+	// Invalid objects are written as an empty blob, so the stream stays aligned for the reader
 	TArray<uint8> bytes;
-	UDataSerializerLib::SerializeObject(bytes, InObject);
-	GetMemoryWriterRef() << bytes;
+	if (IsValid(InObject))
+	{
+		UDataSerializerLib::SerializeObject(bytes, InObject);
+	}
+	WriteByteArray(bytes);
 }
 
 void USerializerObject::SerializeObjects(const TArray<UObject*>& InObjects)
 {
 	TArray<uint8> bytes;
 	UDataSerializerLib::SerializeObjects(bytes, InObjects);
-	GetMemoryWriterRef() << bytes;
+	WriteByteArray(bytes);
+}
+
+void USerializerObject::SerializeProperty(const FProperty* InProperty, const void* InValue)
+{
+	if (InProperty == nullptr || InValue == nullptr)
+		return;
+
+	FMemoryWriter& writer = GetMemoryWriterRef();
+	uint32 typeHash = Serializer::GetPropertyTypeHash(InProperty);
+	writer << typeHash;
+	Serializer::WritePropertyValue(writer, InProperty, InValue);
+}
+
+// Stubs, Blueprint calls go through the exec functions below and C++ code calls SerializeProperty
+void USerializerObject::SerializeStruct(const int32& InValue) { check(0); }
+
+void USerializerObject::SerializeArray(const TArray<int32>& InValue) { check(0); }
+
+void USerializerObject::SerializeMap(const TMap<int32, int32>& InValue) { check(0); }
+
+void USerializerObject::SerializeSet(const TSet<int32>& InValue) { check(0); }
+
+DEFINE_FUNCTION(USerializerObject::execSerializeStruct)
+{
+	void* value = nullptr;
+	const FStructProperty* property = Serializer::StepWildcardParam<FStructProperty>(Stack, value);
+	P_FINISH;
+	P_NATIVE_BEGIN;
+	P_THIS->SerializeProperty(property, value);
+	P_NATIVE_END;
+}
+
+DEFINE_FUNCTION(USerializerObject::execSerializeArray)
+{
+	void* value = nullptr;
+	const FArrayProperty* property = Serializer::StepWildcardParam<FArrayProperty>(Stack, value);
+	P_FINISH;
+	P_NATIVE_BEGIN;
+	P_THIS->SerializeProperty(property, value);
+	P_NATIVE_END;
+}
+
+DEFINE_FUNCTION(USerializerObject::execSerializeMap)
+{
+	void* value = nullptr;
+	const FMapProperty* property = Serializer::StepWildcardParam<FMapProperty>(Stack, value);
+	P_FINISH;
+	P_NATIVE_BEGIN;
+	P_THIS->SerializeProperty(property, value);
+	P_NATIVE_END;
+}
+
+DEFINE_FUNCTION(USerializerObject::execSerializeSet)
+{
+	void* value = nullptr;
+	const FSetProperty* property = Serializer::StepWildcardParam<FSetProperty>(Stack, value);
+	P_FINISH;
+	P_NATIVE_BEGIN;
+	P_THIS->SerializeProperty(property, value);
+	P_NATIVE_END;
 }
 
 void USerializerObject::PushBytes(const TArray<uint8>& InBytes)
 {
-	this->Bytes.Append(InBytes);
+	GetMemoryWriterRef().Serialize(const_cast<uint8*>(InBytes.GetData()), InBytes.Num());
+}
+
+TArray<uint8> USerializerObject::MoveBytesOut()
+{
+	if (MemoryWriter.IsSet())
+	{
+		FlushBits();
+	}
+	MemoryWriter.Reset();
+	return MoveTemp(Bytes);
 }
 
 void USerializerObject::Clear()
 {
 	this->Bytes.Empty();
 	this->MemoryWriter.Reset();
+	this->PendingBits = 0;
+	this->NumPendingBits = 0;
 }
 
 void USerializerObject::Prepare()
 {
 	Clear();
-	this->MemoryWriter = MakeShareable<FMemoryWriter>(new FMemoryWriter(Bytes));
+	BeginStream();
+}
+
+void USerializerObject::Reset()
+{
+	this->Bytes.Reset();
+	this->PendingBits = 0;
+	this->NumPendingBits = 0;
+	BeginStream();
+}
+
+void USerializerObject::Reserve(int32 InNumBytes)
+{
+	this->Bytes.Reserve(InNumBytes);
+}
+
+void USerializerObject::BeginStream()
+{
+	this->MemoryWriter.Emplace(Bytes);
+
+	// Record non-default modes, so readers decode the stream the same way
+	Serializer::FStreamPreamble preamble;
+	preamble.Flags = IntEncoding == EDataSerializerIntEncoding::VarInt ? Serializer::StreamVarInt : 0;
+	preamble.Flags |= bPackBools ? Serializer::StreamPackedBools : 0;
+	if (preamble.IsNeeded())
+	{
+		preamble.Write(*MemoryWriter);
+	}
+}
+
+void USerializerObject::SetIntEncoding(EDataSerializerIntEncoding InEncoding)
+{
+	IntEncoding = InEncoding;
+	Prepare();
+}
+
+void USerializerObject::SetPackBools(bool bInPackBools)
+{
+	bPackBools = bInPackBools;
+	Prepare();
 }
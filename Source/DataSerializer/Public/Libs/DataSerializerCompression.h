@@ -0,0 +1,111 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DataSerializerCompression.generated.h"
+
+constexpr int32 XEUS_SAVEGAME_FILE_TYPE_TAG = 0x78657573; //XEUS
+
+/** Size of the uncompressed chunks used by the streaming compressed disk functions. */
+constexpr int32 XEUS_COMPRESSION_CHUNK_SIZE = 256 * 1024;
+
+/**
+ * @enum EDataSerializerCodec
+ * @brief Compression codec used by the compressed disk functions.
+ * @note Values are stored in file headers, never reorder them.
+ */
+UENUM(BlueprintType)
+enum class EDataSerializerCodec : uint8
+{
+	/** Data is stored uncompressed. */
+	None = 0,
+	Zlib = 1,
+	Gzip = 2,
+	/** Fast decompression, lower ratio. */
+	LZ4 = 3,
+	/** Oodle Kraken/Leviathan/Mermaid, picked from the compression level. */
+	Oodle = 4,
+};
+
+/**
+ * @enum EDataSerializerCompressionLevel
+ * @brief Speed/ratio trade-off of the compression.
+ *
+ * Oodle maps each level to a compressor and level, Zlib and Gzip map it to COMPRESS_BiasSpeed / COMPRESS_BiasSize
+ * flags, LZ4 ignores it. Decompression never depends on the level.
+ */
+UENUM(BlueprintType)
+enum class EDataSerializerCompressionLevel : uint8
+{
+	Fastest = 0,
+	Fast = 1,
+	Normal = 2,
+	Optimal = 3,
+	/** Best ratio, use for cold archives. */
+	Max = 4,
+};
+
+/**
+ * @struct FDataSerializerCompressionSettings
+ * @brief Codec and level used when writing compressed data.
+ */
+USTRUCT(BlueprintType)
+struct DATASERIALIZER_API FDataSerializerCompressionSettings
+{
+	GENERATED_BODY()
+
+public:
+	FDataSerializerCompressionSettings() = default;
+
+	explicit FDataSerializerCompressionSettings(EDataSerializerCodec InCodec,
+	                                            EDataSerializerCompressionLevel InLevel = EDataSerializerCompressionLevel::Normal);
+
+	/** Codec used to compress the data. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	EDataSerializerCodec Codec = EDataSerializerCodec::Zlib;
+
+	/** Speed/ratio trade-off. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	EDataSerializerCompressionLevel Level = EDataSerializerCompressionLevel::Normal;
+};
+
+/**
+ * @struct FDataSerializerFileHeader
+ * @brief Header written at the start of compressed files.
+ *
+ * Lets the reader pick the decoder and preallocate the output. The header is followed by independently
+ * compressed blocks of ChunkSize bytes, the block offset table and a footer. Blocks are compressed and
+ * decompressed in parallel and any byte range can be read without the other blocks.
+ */
+struct DATASERIALIZER_API FDataSerializerFileHeader
+{
+	/** Current format version. */
+	static constexpr uint16 CurrentVersion = 2;
+
+	/** Largest chunk size accepted by readers, guards against corrupted headers. */
+	static constexpr int32 MaxChunkSize = 64 * 1024 * 1024;
+
+	/** Always XEUS_SAVEGAME_FILE_TYPE_TAG. */
+	int32 Magic = XEUS_SAVEGAME_FILE_TYPE_TAG;
+
+	/** Format version of the file. */
+	uint16 Version = CurrentVersion;
+
+	/** Codec the chunks are compressed with. */
+	EDataSerializerCodec Codec = EDataSerializerCodec::Zlib;
+
+	/** Level the data was compressed with (informational). */
+	EDataSerializerCompressionLevel Level = EDataSerializerCompressionLevel::Normal;
+
+	/** Size of the uncompressed chunks (blocks). */
+	int32 ChunkSize = XEUS_COMPRESSION_CHUNK_SIZE;
+
+	/** Size of the whole uncompressed payload. */
+	int64 UncompressedSize = 0;
+
+	/** @return true if the magic, version and codec are known. */
+	bool IsValid() const;
+
+	friend DATASERIALIZER_API FArchive& operator<<(FArchive& Ar, FDataSerializerFileHeader& Header);
+};
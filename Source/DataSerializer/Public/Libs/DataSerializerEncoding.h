@@ -0,0 +1,25 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DataSerializerEncoding.generated.h"
+
+/**
+ * Written by USerializerObject at the start of a stream that uses a non-default encoding,
+ * followed by a version byte and a flags byte. Streams without it are read with the default encoding.
+ */
+constexpr uint32 XEUS_STREAM_TAG = 0x5845534D; //XESM
+
+/**
+ * @enum EDataSerializerIntEncoding
+ * @brief How USerializerObject writes integers and byte counts.
+ */
+UENUM(BlueprintType)
+enum class EDataSerializerIntEncoding : uint8
+{
+	/** Raw 4/8 byte values, compatible with streams written by older versions. */
+	Fixed,
+	/** LEB128 varints, zigzag for signed values. Small values take 1-2 bytes. */
+	VarInt
+};
@@ -4,9 +4,41 @@
 
 #include "CoreMinimal.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
+#include "Libs/DataSerializerCompression.h"
 #include "DataSerializerLib.generated.h"
 
-constexpr int32 XEUS_SAVEGAME_FILE_TYPE_TAG = 0x78657573; //XEUS
+class UDataSerializerObjectPool;
+
+/**
+ * Written by SerializeObjects in place of the object count of the older format,
+ * marks a batch with a class table. Negative so it can never be a valid count.
+ */
+constexpr int32 XEUS_OBJECT_BATCH_TAG = -0x78657562; //-XEUB
+
+/** Written by SerializeObjectsIndexed, marks an object archive with a record table. */
+constexpr int32 XEUS_OBJECT_INDEX_TAG = -0x78657569; //-XEUI
+
+/** Written by SerializeObjectGraph, marks objects serialized with their subobjects and shared references. */
+constexpr int32 XEUS_OBJECT_GRAPH_TAG = -0x78657547; //-XEUG
+
+/**
+ * Written by FSerializationHeader in place of the class name length, marks a delta blob.
+ * Negative and out of range for a string length, so full blobs can never start with it.
+ */
+constexpr int32 XEUS_DELTA_HEADER_TAG = -0x78657564; //-XEUD
+
+/**
+ * @enum EDataSerializerBlobKind
+ * @brief Content of an object blob.
+ */
+UENUM(BlueprintType)
+enum class EDataSerializerBlobKind : uint8
+{
+	/** Every saved property of the object. */
+	Full,
+	/** Only the properties that differ from a baseline, see UDataSerializerLib::SerializeObjectDelta */
+	Delta
+};
 
 /**
  * @brief Structure for handling serialization headers in any project.
@@ -43,13 +75,13 @@ public:
 	void Empty();
 
 	/**
-	 * @brief Reads header data from a memory reader.
+	 * @brief Reads header data from a seekable archive (memory reader, memory view...).
 	 * 
-	 * @param MemoryReader The memory reader from which the header data will be read.
+	 * @param MemoryReader The archive from which the header data will be read.
 	 * This method populates the FSerializationHeader's members based on the data
 	 * read from the provided MemoryReader.
 	 */
-	void Read(FMemoryReader& MemoryReader);
+	void Read(FArchive& MemoryReader);
 
 	/**
 	* @brief Writes header data to a memory writer.
@@ -60,6 +92,9 @@ public:
 	*/
 	void Write(FMemoryWriter& MemoryWriter);
 
+	/** @return true if the header is followed by a property delta instead of the full object state. */
+	bool IsDelta() const { return Kind == EDataSerializerBlobKind::Delta; }
+
 	/**
 	* @brief The class name of the game object being serialized.
 	* 
@@ -68,6 +103,38 @@ public:
 	*/
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
 	FString GameClassName;
+
+	/**
+	* @brief Whether the blob holds the full object state or a delta.
+	*
+	* Full headers are written exactly like before, delta headers start with XEUS_DELTA_HEADER_TAG.
+	*/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	EDataSerializerBlobKind Kind = EDataSerializerBlobKind::Full;
+
+	/**
+	* @brief Hash of the saved property list of the class (delta blobs only).
+	*
+	* Delta records refer to properties by index, the hash guards against applying them to a changed class layout.
+	*/
+	uint32 LayoutHash = 0;
+};
+
+/**
+ * @brief Named blob of a container file, see UDataSerializerLib::WriteBlobsToContainer.
+ */
+USTRUCT(BlueprintType)
+struct DATASERIALIZER_API FDataSerializerBlob
+{
+	GENERATED_BODY()
+
+	/** Name of the blob in the container. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	FString Key;
+
+	/** The data of the blob. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	TArray<uint8> Bytes;
 };
 
 /**
@@ -99,8 +166,9 @@ public:
 	/**
 	 * Writes a compressed byte array to a file on disk.
 	 *
-	 * This function first compresses the provided `InBytes` array and then writes the compressed data
+	 * This function compresses the provided `InBytes` array in independent blocks, in parallel, while writing it
 	 * to a file specified by `InPath`. The file will be created if it does not exist, or overwritten if it does.
+	 * @see WriteBytesToDiskCompressedCpp
 	 *
 	 * @param InBytes The byte array to be compressed and written to the file.
 	 * @param InPath The path to the file where the compressed byte array should be written.
@@ -109,6 +177,47 @@ public:
 	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Disk")
 	static bool WriteBytesToDiskCompressed(const TArray<uint8>& InBytes, FString InPath);
 
+	/**
+	 * Writes a compressed byte array to a file on disk using the given codec and level.
+	 *
+	 * The codec is stored in the file header, ReadCompressedBytesFromDisk picks the decoder automatically.
+	 *
+	 * @param InBytes The byte array to be compressed and written to the file.
+	 * @param InPath The path to the file where the compressed byte array should be written.
+	 * @param InSettings Codec and compression level.
+	 * @return Returns true if the operation was successful, otherwise false.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Disk")
+	static bool WriteBytesToDiskCompressedWithSettings(const TArray<uint8>& InBytes, FString InPath,
+	                                                   FDataSerializerCompressionSettings InSettings);
+
+	/**
+	 * Compresses a byte view straight into a file on disk.
+	 *
+	 * The data is split into blocks of XEUS_COMPRESSION_CHUNK_SIZE bytes, a batch of blocks is compressed
+	 * in parallel and written as soon as it is done, so no full size copy of the payload is ever made.
+	 *
+	 * @param InBytes The bytes to be compressed and written to the file.
+	 * @param InPath The path to the file where the compressed bytes should be written.
+	 * @param InSettings Codec and compression level.
+	 * @return Returns true if the operation was successful, otherwise false.
+	 */
+	static bool WriteBytesToDiskCompressedCpp(TArrayView<const uint8> InBytes, const FString& InPath,
+	                                          const FDataSerializerCompressionSettings& InSettings = {});
+
+	/**
+	 * Compresses the remaining content of an archive straight into a file on disk.
+	 *
+	 * The archive is read from its current position to its end, one batch of blocks at a time.
+	 *
+	 * @param InSource The archive to read the data from.
+	 * @param InPath The path to the file where the compressed bytes should be written.
+	 * @param InSettings Codec and compression level.
+	 * @return Returns true if the operation was successful, otherwise false.
+	 */
+	static bool WriteArchiveToDiskCompressedCpp(FArchive& InSource, const FString& InPath,
+	                                            const FDataSerializerCompressionSettings& InSettings = {});
+
 	/**
 	 * Reads a byte array from a file on disk.
 	 *
@@ -135,6 +244,122 @@ public:
 	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Disk")
 	static bool ReadCompressedBytesFromDisk(TArray<uint8>& OutBytes, FString InPath);
 
+	/**
+	 * Reads a compressed file block by block and decompresses it into an archive.
+	 *
+	 * Only one batch of compressed blocks is held in memory at a time.
+	 * Files written by older versions of the plugin are loaded whole and decompressed in one go.
+	 *
+	 * @param OutTarget The archive the decompressed data is written to.
+	 * @param InPath The path to the file from which the compressed data should be read.
+	 * @return Returns true if the operation was successful, otherwise false.
+	 */
+	static bool ReadCompressedBytesFromDiskCpp(FArchive& OutTarget, const FString& InPath);
+
+	/**
+	 * Reads a byte range of the decompressed content of a compressed file.
+	 *
+	 * Only the blocks covering the range are read and decompressed.
+	 * Files without a block table are decompressed whole and sliced.
+	 *
+	 * @param OutBytes The byte array that will be populated with the requested range.
+	 * @param InPath The path to the compressed file.
+	 * @param InOffset Offset of the range in the decompressed data.
+	 * @param InLength Length of the range, clamped to the end of the data.
+	 * @return Returns true if the operation was successful, otherwise false.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Disk")
+	static bool ReadCompressedBytesRangeFromDisk(TArray<uint8>& OutBytes, FString InPath, int64 InOffset,
+	                                             int64 InLength);
+
+	/**
+	 * Deserializes objects straight from a file written with WriteBytesToDisk, without loading it into memory.
+	 *
+	 * The file is memory mapped, see FDataSerializerMappedFile.
+	 *
+	 * @param InPath The path to the file written from SerializeObjects or SerializeObjectsIndexed bytes.
+	 * @param InObjectOuter The outer object for the deserialized objects.
+	 * @param OutObjects The deserialized objects.
+	 * @return Returns true if the deserialization was successful, otherwise false.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Disk")
+	static bool DeSerializeObjectsFromFile(FString InPath, UObject* InObjectOuter, TArray<UObject*>& OutObjects);
+
+	/**
+	 * Deserializes objects from a file written with WriteBytesToDisk, reading it in chunks.
+	 *
+	 * Unlike DeSerializeObjectsFromFile the file is never held in memory as a whole, only two chunks of it,
+	 * the next one being read in the background. Meant for archives larger than the memory budget.
+	 *
+	 * @param InPath The path to the file written from SerializeObjects or SerializeObjectsIndexed bytes.
+	 * @param InObjectOuter The outer object for the deserialized objects.
+	 * @param OutObjects The deserialized objects.
+	 * @param InChunkSize Size of each read in bytes.
+	 * @return Returns true if the file could be read and every object deserialized.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Disk")
+	static bool DeSerializeObjectsFromFileStreamed(FString InPath, UObject* InObjectOuter, TArray<UObject*>& OutObjects,
+	                                               int32 InChunkSize = 1048576);
+
+	/**
+	 * Deserializes a single record of an indexed object archive file written with WriteBytesToDisk.
+	 *
+	 * The file is memory mapped, only the pages of the record table and of the record are loaded.
+	 *
+	 * @param InPath The path to the file written from SerializeObjectsIndexed bytes.
+	 * @param InIndex Index of the record.
+	 * @param InObjectOuter The outer object for the deserialized object.
+	 * @param OutObject The deserialized object.
+	 * @return Returns true if the deserialization was successful, otherwise false.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Disk")
+	static bool DeSerializeIndexedObjectFromFile(FString InPath, int32 InIndex, UObject* InObjectOuter,
+	                                             UObject*& OutObject);
+
+	/**
+	 * Reads the header of a compressed file without decompressing it.
+	 *
+	 * @param InPath The path to the compressed file.
+	 * @param OutHeader The header of the file.
+	 * @return Returns false if the file cannot be opened or has no header (written by an older version).
+	 */
+	static bool ReadCompressedFileHeaderCpp(const FString& InPath, FDataSerializerFileHeader& OutHeader);
+
+	/**
+	 * Writes blobs to a container file, where many blobs share a single file.
+	 *
+	 * The container is created if it does not exist, blobs with the same key are replaced.
+	 * All the blobs are written with as few writes as possible, prefer it to one WriteBytesToDisk per blob.
+	 *
+	 * @param InBlobs The blobs to write.
+	 * @param InPath The path to the container file.
+	 * @return Returns true if all the blobs have been written.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Disk")
+	static bool WriteBlobsToContainer(const TArray<FDataSerializerBlob>& InBlobs, FString InPath);
+
+	/**
+	 * Reads blobs from a container file written by WriteBlobsToContainer.
+	 *
+	 * @param OutBlobs The blobs found, in the order of the keys.
+	 * @param InPath The path to the container file.
+	 * @param InKeys The keys of the blobs to read, every blob of the container if empty.
+	 * @return Returns false if the container cannot be opened, a key is missing or a blob is corrupt.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Disk")
+	static bool ReadBlobsFromContainer(TArray<FDataSerializerBlob>& OutBlobs, FString InPath,
+	                                   const TArray<FString>& InKeys);
+
+	/**
+	 * Removes blobs from a container file, their space is reused by later writes.
+	 *
+	 * @param InPath The path to the container file.
+	 * @param InKeys The keys of the blobs to remove.
+	 * @return Returns false if the container cannot be opened or a key is missing.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Disk")
+	static bool RemoveBlobsFromContainer(FString InPath, const TArray<FString>& InKeys);
+
 #pragma endregion
 
 #pragma region Serialize
@@ -165,12 +390,13 @@ public:
 	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Serialization")
 	static bool DeserializeObject(const TArray<uint8>& InBytes, UObject* ObjectOuter, UObject*& OutObject);
 
-	static bool DeSerializeObjectCpp(FMemoryReader& InReader, UObject* ObjectOuter, UObject*& OutObject);
+	static bool DeSerializeObjectCpp(FArchive& InReader, UObject* ObjectOuter, UObject*& OutObject);
 	/**
 	 * Serializes multiple objects into a byte array.
 	 *
 	 * This function converts the array of objects `InObjects` into a byte array and populates `OutBytes` with the serialized data.
-	 * Each object is serialized in sequence and combined into a single byte array.
+	 * The class of every object is written once in a class table, each object then refers to its class by index
+	 * and is serialized in sequence.
 	 *
 	 * @param OutBytes The byte array that will be populated with the serialized objects data.
 	 * @param InObjects The array of objects to be serialized.
@@ -179,6 +405,24 @@ public:
 	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Serialization")
 	static bool SerializeObjects(TArray<uint8>& OutBytes, TArray<UObject*> InObjects);
 
+	/**
+	 * Serializes only the SaveGame properties of multiple objects.
+	 *
+	 * Same batch layout as SerializeObjects, but every object is written from a cached per-class list of its
+	 * CPF_SaveGame properties: plain old data is copied straight from memory, skipping tagged property
+	 * serialization. Data written with an older class layout is still read, property by property, by name.
+	 * Read the result with DeSerializeObjects.
+	 *
+	 * @param OutBytes The byte array that will be populated with the serialized objects data.
+	 * @param InObjects The array of objects to be serialized.
+	 * @return Returns true if the serialization was successful, otherwise false.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Serialization")
+	static bool SerializeObjectsWithSchema(TArray<uint8>& OutBytes, TArray<UObject*> InObjects);
+
+	static bool SerializeObjectsCpp(FMemoryWriter& InWriter, TArrayView<UObject* const> InObjects,
+	                                bool bInSaveGameSchema = false);
+
 	/**
 	 * Deserializes a byte array into multiple objects.
 	 *
@@ -193,7 +437,235 @@ public:
 	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Serialization")
 	static bool DeSerializeObjects(const TArray<uint8>& InBytes, UObject* InObjectOuter, TArray<UObject*>& OutObjects);
 
-	static bool DeSerializeObjectsCpp(FMemoryReader& InReader, UObject* InObjectOuter, TArray<UObject*>& OutObjects);
+	static bool DeSerializeObjectsCpp(FArchive& InReader, UObject* InObjectOuter, TArray<UObject*>& OutObjects);
+
+	/**
+	 * Loads a blob written by SerializeObject into an existing object instead of creating one.
+	 *
+	 * Full blobs replace the saved state of the object, delta blobs patch it like ApplyObjectDelta.
+	 *
+	 * @param InBytes The blob.
+	 * @param InTarget The object to load into, its class must match the blob.
+	 * @return Returns true if the blob was loaded, otherwise false.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Serialization")
+	static bool DeSerializeObjectInto(const TArray<uint8>& InBytes, UObject* InTarget);
+
+	static bool DeSerializeObjectIntoCpp(FArchive& InReader, UObject* InTarget);
+
+	/**
+	 * Loads objects written by SerializeObjects or SerializeObjectsIndexed into existing objects, matched by index.
+	 *
+	 * No object is created: reloading a snapshot into the objects it was taken from allocates no UObject.
+	 * Each target is reset to its defaults, then loaded. Object graphs are not supported.
+	 *
+	 * @param InBytes The serialized objects.
+	 * @param InTargets One object per record, in record order, of the record class.
+	 * @return Returns false if a target is missing or of another class, or if the target and record counts differ.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Serialization")
+	static bool DeSerializeObjectsInto(const TArray<uint8>& InBytes, TArray<UObject*> InTargets);
+
+	static bool DeSerializeObjectsIntoCpp(FArchive& InReader, TArrayView<UObject* const> InTargets);
+
+	/**
+	 * Loads records of SerializeObjectsIndexedWithKeys bytes into existing objects, matched by key.
+	 *
+	 * Records without a target are skipped without being read.
+	 *
+	 * @param InBytes The serialized objects, written with keys.
+	 * @param InTargets The object to load each key into, of the record class.
+	 * @return Returns false if a key has no record or a target is of another class.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Serialization")
+	static bool DeSerializeObjectsIntoByKey(const TArray<uint8>& InBytes, const TMap<FString, UObject*>& InTargets);
+
+	/**
+	 * Deserializes objects like DeSerializeObjects, taking them from a pool instead of creating them.
+	 *
+	 * Release the objects of the previous load to the pool first, steady-state reloads then create no UObject.
+	 * Object graphs are not supported.
+	 *
+	 * @param InBytes The serialized objects.
+	 * @param InObjectOuter The outer object for the deserialized objects.
+	 * @param InPool The pool objects are taken from, new objects are created without a pool.
+	 * @param OutObjects The deserialized objects.
+	 * @return Returns true if the deserialization was successful, otherwise false.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Serialization")
+	static bool DeSerializeObjectsPooled(const TArray<uint8>& InBytes, UObject* InObjectOuter,
+	                                     UDataSerializerObjectPool* InPool, TArray<UObject*>& OutObjects);
+
+	static bool DeSerializeObjectsPooledCpp(FArchive& InReader, UObject* InObjectOuter,
+	                                        UDataSerializerObjectPool* InPool, TArray<UObject*>& OutObjects);
+
+	/**
+	 * Serializes objects together with the subobjects they reference.
+	 *
+	 * The roots, the subobjects they own and the objects they reference through instanced or SaveGame properties
+	 * are written once each, however many references there are to them. Other references are written by path. References between these objects are written as IDs,
+	 * so DeSerializeObjects rebuilds the same graph, shared objects included.
+	 *
+	 * @param OutBytes The byte array that will be populated with the serialized graph.
+	 * @param InObjects The root objects, DeSerializeObjects returns them in the same order.
+	 * @return Returns true if the serialization was successful, otherwise false.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Serialization")
+	static bool SerializeObjectGraph(TArray<uint8>& OutBytes, TArray<UObject*> InObjects);
+
+	static bool SerializeObjectGraphCpp(FMemoryWriter& InWriter, TArrayView<UObject* const> InObjects);
+
+	/**
+	 * Serializes only the properties of an object that differ from a baseline object.
+	 *
+	 * Changed properties are written by property index after a delta FSerializationHeader, so delta and
+	 * full blobs can be mixed in one stream. Apply the result with ApplyObjectDelta.
+	 *
+	 * @param OutBytes The byte array that will be populated with the delta.
+	 * @param InObject The object to be serialized.
+	 * @param InBaseline Object of the same class to compare against, the class default object if null.
+	 * @return Returns true if the serialization was successful, otherwise false.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Serialization")
+	static bool SerializeObjectDelta(TArray<uint8>& OutBytes, UObject* InObject, UObject* InBaseline);
+
+	/**
+	 * Serializes only the properties of an object that differ from a baseline blob.
+	 *
+	 * @param OutBytes The byte array that will be populated with the delta.
+	 * @param InObject The object to be serialized.
+	 * @param InBaselineBytes A full blob (see SerializeObject) of an object of the same class.
+	 * @return Returns true if the serialization was successful, otherwise false.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Serialization")
+	static bool SerializeObjectDeltaFromBytes(TArray<uint8>& OutBytes, UObject* InObject,
+	                                          const TArray<uint8>& InBaselineBytes);
+
+	static bool SerializeObjectDeltaCpp(FMemoryWriter& InWriter, UObject* InObject, const UObject* InBaseline);
+
+	/**
+	 * Patches an existing object with a blob.
+	 *
+	 * Delta blobs only overwrite the properties they contain, full blobs overwrite every saved property.
+	 *
+	 * @param InBytes The blob written by SerializeObjectDelta or SerializeObject.
+	 * @param InTarget The object to patch, its class must match the blob.
+	 * @return Returns true if the blob was applied, otherwise false.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Serialization")
+	static bool ApplyObjectDelta(const TArray<uint8>& InBytes, UObject* InTarget);
+
+	static bool ApplyObjectDeltaCpp(FArchive& InReader, UObject* InTarget);
+
+	/**
+	 * Patches a baseline blob with a delta, producing a full blob.
+	 *
+	 * @param InBaselineBytes The full blob the delta was computed against.
+	 * @param InDeltaBytes The blob written by SerializeObjectDelta.
+	 * @param OutBytes The byte array that will be populated with the patched full blob.
+	 * @return Returns true if the delta was applied, otherwise false.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Serialization")
+	static bool ApplyObjectDeltaToBytes(const TArray<uint8>& InBaselineBytes, const TArray<uint8>& InDeltaBytes,
+	                                    TArray<uint8>& OutBytes);
+
+	/**
+	 * Serializes multiple objects into a byte array with a record table.
+	 *
+	 * Unlike SerializeObjects, every record carries its offset and size, so a single object or a range of objects
+	 * can be deserialized later without deserializing the records before it.
+	 * The result can also be read whole with DeSerializeObjects.
+	 *
+	 * @param OutBytes The byte array that will be populated with the serialized objects data.
+	 * @param InObjects The array of objects to be serialized.
+	 * @param bUseObjectNamesAsKeys Store the object names as record keys.
+	 * @return Returns true if the serialization was successful, otherwise false.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Serialization")
+	static bool SerializeObjectsIndexed(TArray<uint8>& OutBytes, TArray<UObject*> InObjects,
+	                                    bool bUseObjectNamesAsKeys = true);
+
+	/**
+	 * Serializes multiple objects into a byte array with a record table and caller provided keys.
+	 *
+	 * @param OutBytes The byte array that will be populated with the serialized objects data.
+	 * @param InObjects The array of objects to be serialized.
+	 * @param InKeys One key per object (e.g. object IDs), used by DeSerializeIndexedObjectByKey.
+	 * @return Returns true if the serialization was successful, otherwise false.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Serialization")
+	static bool SerializeObjectsIndexedWithKeys(TArray<uint8>& OutBytes, TArray<UObject*> InObjects,
+	                                            const TArray<FString>& InKeys);
+
+	static bool SerializeObjectsIndexedCpp(FMemoryWriter& InWriter, TArrayView<UObject* const> InObjects,
+	                                       TArrayView<const FString> InKeys);
+
+	/**
+	 * Gets the number of records of an indexed object archive.
+	 *
+	 * @param InBytes The bytes written by SerializeObjectsIndexed.
+	 * @return Number of records, INDEX_NONE if the bytes are not an indexed object archive.
+	 */
+	UFUNCTION(BlueprintPure, Category="UDataSerializerLib|Serialization")
+	static int32 GetIndexedObjectCount(const TArray<uint8>& InBytes);
+
+	/**
+	 * Deserializes a single record of an indexed object archive, the other records are not touched.
+	 *
+	 * @param InBytes The bytes written by SerializeObjectsIndexed.
+	 * @param InIndex Index of the record.
+	 * @param InObjectOuter The outer object for the deserialized object.
+	 * @param OutObject The deserialized object.
+	 * @return Returns true if the deserialization was successful, otherwise false.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Serialization")
+	static bool DeSerializeIndexedObject(const TArray<uint8>& InBytes, int32 InIndex, UObject* InObjectOuter,
+	                                     UObject*& OutObject);
+
+	/**
+	 * Deserializes the record with the given key of an indexed object archive.
+	 *
+	 * @param InBytes The bytes written by SerializeObjectsIndexed.
+	 * @param InKey Key of the record.
+	 * @param InObjectOuter The outer object for the deserialized object.
+	 * @param OutObject The deserialized object.
+	 * @return Returns true if the deserialization was successful, otherwise false.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Serialization")
+	static bool DeSerializeIndexedObjectByKey(const TArray<uint8>& InBytes, const FString& InKey,
+	                                          UObject* InObjectOuter, UObject*& OutObject);
+
+	/**
+	 * Deserializes a range of records of an indexed object archive.
+	 *
+	 * @param InBytes The bytes written by SerializeObjectsIndexed.
+	 * @param InFirst Index of the first record.
+	 * @param InCount Number of records.
+	 * @param InObjectOuter The outer object for the deserialized objects.
+	 * @param OutObjects The deserialized objects.
+	 * @return Returns true if the deserialization was successful, otherwise false.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Serialization")
+	static bool DeSerializeIndexedObjectRange(const TArray<uint8>& InBytes, int32 InFirst, int32 InCount,
+	                                          UObject* InObjectOuter, TArray<UObject*>& OutObjects);
+
+	/**
+	 * Finds or loads a class by path.
+	 *
+	 * Resolved classes are cached across calls, so each class is looked up once.
+	 * Classes that are not loaded yet can only be loaded from the game thread.
+	 *
+	 * @param InClassPath Path name of the class.
+	 * @return The class, or nullptr if it cannot be found.
+	 */
+	static UClass* ResolveClassCpp(const FString& InClassPath);
+
+	/**
+	 * Clears the cache of resolved classes used by the deserialization functions,
+	 * and the SaveGame property layouts used by SerializeObjectsWithSchema.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Serialization")
+	static void ClearClassCache();
 #pragma endregion
 
 
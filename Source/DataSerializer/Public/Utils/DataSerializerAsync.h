@@ -0,0 +1,147 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Libs/DataSerializerCompression.h"
+
+/**
+ * @enum EDataSerializerAsyncOp
+ * @brief Disk operation performed by an async request.
+ */
+enum class EDataSerializerAsyncOp : uint8
+{
+	/** Plain write, see UDataSerializerLib::WriteBytesToDisk */
+	Write,
+	/** Compressed write, see UDataSerializerLib::WriteBytesToDiskCompressed */
+	WriteCompressed,
+	/** Plain read, see UDataSerializerLib::ReadBytesFromDisk */
+	Read,
+	/** Compressed read, see UDataSerializerLib::ReadCompressedBytesFromDisk */
+	ReadCompressed
+};
+
+/**
+ * @struct FDataSerializerAsyncResult
+ * @brief Result of an async disk operation.
+ */
+struct DATASERIALIZER_API FDataSerializerAsyncResult
+{
+	/** True if the disk operation succeeded. */
+	bool bSuccess = false;
+
+	/** True if the request was cancelled before it completed. */
+	bool bCancelled = false;
+
+	/** Bytes read from disk (read operations only). */
+	TArray<uint8> Bytes;
+};
+
+/** Result shared by the future and the callbacks of every caller of a request, the bytes are never copied. */
+using FDataSerializerAsyncResultRef = TSharedRef<const FDataSerializerAsyncResult, ESPMode::ThreadSafe>;
+
+namespace Serializer
+{
+	struct FAsyncWaiter;
+}
+
+/**
+ * @class FDataSerializerAsyncHandle
+ * @brief Handle to a pending async disk operation.
+ *
+ * Several handles may share one underlying request when requests to the same path are coalesced,
+ * cancelling a handle only detaches that caller.
+ */
+class DATASERIALIZER_API FDataSerializerAsyncHandle
+{
+public:
+	FDataSerializerAsyncHandle() = default;
+	FDataSerializerAsyncHandle(TSharedRef<Serializer::FAsyncWaiter, ESPMode::ThreadSafe> InWaiter,
+	                           TSharedFuture<FDataSerializerAsyncResultRef> InFuture);
+
+	/** @return true if the handle refers to a request. */
+	bool IsValid() const;
+
+	/** @return true if the request has completed or has been cancelled. */
+	bool IsDone() const;
+
+	/**
+	 * @brief Detaches this caller from the request.
+	 *
+	 * The future is fulfilled with bCancelled set and the completion callback is not called.
+	 * The disk operation itself is dropped if no other caller waits for it and it has not started yet.
+	 */
+	void Cancel();
+
+	/**
+	 * @brief Gets the future fulfilled on the worker thread once the operation finishes.
+	 * @note Do not block the game thread on it while the game thread is needed to finish the work.
+	 */
+	const TSharedFuture<FDataSerializerAsyncResultRef>& GetFuture() const { return Future; }
+
+private:
+	TSharedPtr<Serializer::FAsyncWaiter, ESPMode::ThreadSafe> Waiter;
+	TSharedFuture<FDataSerializerAsyncResultRef> Future;
+};
+
+/**
+ * @class FDataSerializerAsyncIO
+ * @brief Runs the UDataSerializerLib disk functions off the game thread.
+ *
+ * Compression and file I/O run on the thread pool, completion callbacks are delivered on the game thread.
+ * Requests are queued per file path so they never overlap on the same file:
+ * - a write queued behind a pending write of the same kind replaces its payload (only the latest data is written);
+ * - a read queued behind a pending read of the same kind joins it (the file is read once).
+ */
+class DATASERIALIZER_API FDataSerializerAsyncIO
+{
+public:
+	/** Completion callback, always called on the game thread. */
+	using FCallback = TFunction<void(const FDataSerializerAsyncResult&)>;
+
+	/**
+	 * Writes a byte array to a file on disk asynchronously.
+	 * @param InBytes The byte array to be written (moved into the request).
+	 * @param InPath The path to the file where the byte array should be written.
+	 * @param bCompressed Compress the data, see UDataSerializerLib::WriteBytesToDiskCompressed.
+	 * @param OnComplete Optional callback called on the game thread.
+	 * @return Handle to the request.
+	 */
+	static FDataSerializerAsyncHandle WriteBytesToDisk(TArray<uint8> InBytes, const FString& InPath,
+	                                                  bool bCompressed, FCallback OnComplete = nullptr);
+
+	/**
+	 * Compresses a byte array with the given codec and writes it to a file on disk asynchronously.
+	 * @param InBytes The byte array to be written (moved into the request).
+	 * @param InPath The path to the file where the byte array should be written.
+	 * @param InSettings Codec and compression level, see UDataSerializerLib::WriteBytesToDiskCompressedWithSettings.
+	 * @param OnComplete Optional callback called on the game thread.
+	 * @return Handle to the request.
+	 */
+	static FDataSerializerAsyncHandle WriteBytesToDiskCompressed(TArray<uint8> InBytes, const FString& InPath,
+	                                                            const FDataSerializerCompressionSettings& InSettings,
+	                                                            FCallback OnComplete = nullptr);
+
+	/**
+	 * Reads a byte array from a file on disk asynchronously.
+	 * @param InPath The path to the file from which the byte array should be read.
+	 * @param bCompressed Decompress the data, see UDataSerializerLib::ReadCompressedBytesFromDisk.
+	 * @param OnComplete Optional callback called on the game thread.
+	 * @return Handle to the request.
+	 */
+	static FDataSerializerAsyncHandle ReadBytesFromDisk(const FString& InPath, bool bCompressed,
+	                                                   FCallback OnComplete = nullptr);
+
+	/**
+	 * Cancels every pending request for the path.
+	 * @param InPath The path of the file.
+	 */
+	static void CancelAll(const FString& InPath);
+
+	/**
+	 * Blocks until every queued disk operation has finished.
+	 * @note Completion callbacks are still delivered later on the game thread.
+	 */
+	static void Flush();
+};
@@ -0,0 +1,106 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintAsyncActionBase.h"
+#include "Utils/DataSerializerAsync.h"
+#include "DataSerializerAsyncAction.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FDataSerializerAsyncDiskPin, bool, bSuccess, const TArray<uint8>&, Bytes);
+
+/**
+ * @class UDataSerializerAsyncDiskAction
+ * @brief Blueprint async nodes for the UDataSerializerLib disk functions.
+ *
+ * Compression and file I/O run off the game thread (see FDataSerializerAsyncIO),
+ * output pins fire on the game thread.
+ */
+UCLASS()
+class DATASERIALIZER_API UDataSerializerAsyncDiskAction : public UBlueprintAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	/** Called when the operation succeeded. Bytes are only filled by read operations. */
+	UPROPERTY(BlueprintAssignable)
+	FDataSerializerAsyncDiskPin OnCompleted;
+
+	/** Called when the operation failed. */
+	UPROPERTY(BlueprintAssignable)
+	FDataSerializerAsyncDiskPin OnFailed;
+
+public:
+	/**
+	 * Writes a byte array to a file on disk without blocking the game thread.
+	 *
+	 * @param WorldContextObject World context.
+	 * @param InBytes The byte array to be written to the file.
+	 * @param InPath The path to the file where the byte array should be written.
+	 * @return The async action.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Disk|Async",
+		meta=(BlueprintInternalUseOnly="true", WorldContext="WorldContextObject"))
+	static UDataSerializerAsyncDiskAction* WriteBytesToDiskAsync(UObject* WorldContextObject,
+	                                                             const TArray<uint8>& InBytes, FString InPath);
+
+	/**
+	 * Compresses a byte array and writes it to a file on disk without blocking the game thread.
+	 *
+	 * @param WorldContextObject World context.
+	 * @param InBytes The byte array to be compressed and written to the file.
+	 * @param InPath The path to the file where the compressed byte array should be written.
+	 * @param InSettings Codec and compression level.
+	 * @return The async action.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Disk|Async",
+		meta=(BlueprintInternalUseOnly="true", WorldContext="WorldContextObject"))
+	static UDataSerializerAsyncDiskAction* WriteBytesToDiskCompressedAsync(UObject* WorldContextObject,
+	                                                                       const TArray<uint8>& InBytes, FString InPath,
+	                                                                       FDataSerializerCompressionSettings InSettings);
+
+	/**
+	 * Reads a byte array from a file on disk without blocking the game thread.
+	 *
+	 * @param WorldContextObject World context.
+	 * @param InPath The path to the file from which the byte array should be read.
+	 * @return The async action.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Disk|Async",
+		meta=(BlueprintInternalUseOnly="true", WorldContext="WorldContextObject"))
+	static UDataSerializerAsyncDiskAction* ReadBytesFromDiskAsync(UObject* WorldContextObject, FString InPath);
+
+	/**
+	 * Reads and decompresses a byte array from a file on disk without blocking the game thread.
+	 *
+	 * @param WorldContextObject World context.
+	 * @param InPath The path to the file from which the compressed byte array should be read.
+	 * @return The async action.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Disk|Async",
+		meta=(BlueprintInternalUseOnly="true", WorldContext="WorldContextObject"))
+	static UDataSerializerAsyncDiskAction* ReadCompressedBytesFromDiskAsync(UObject* WorldContextObject, FString InPath);
+
+	/**
+	 * Cancels the operation, no output pin will fire.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Disk|Async")
+	void Cancel();
+
+	//~ Begin UBlueprintAsyncActionBase Interface
+	virtual void Activate() override;
+	//~ End UBlueprintAsyncActionBase Interface
+
+protected:
+	static UDataSerializerAsyncDiskAction* Create(UObject* WorldContextObject, EDataSerializerAsyncOp InOp,
+	                                              const TArray<uint8>& InBytes, const FString& InPath);
+
+	void HandleCompleted(const FDataSerializerAsyncResult& InResult);
+
+protected:
+	EDataSerializerAsyncOp Op = EDataSerializerAsyncOp::Read;
+	FString Path;
+	TArray<uint8> Bytes;
+	FDataSerializerCompressionSettings Settings;
+	FDataSerializerAsyncHandle Handle;
+};
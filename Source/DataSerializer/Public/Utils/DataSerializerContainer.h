@@ -0,0 +1,159 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IFileHandle;
+
+/** First bytes of container files, see FDataSerializerContainer. */
+constexpr uint32 XEUS_CONTAINER_FILE_TAG = 0x78657570; //xeup
+
+/**
+ * @class FDataSerializerContainer
+ * @brief Many named blobs packed in a single file.
+ *
+ * The key index lives at the head of the file, so opening a container is one small read and loading
+ * a blob is a seek and a read instead of an open, stat and close per file. ReadMany and WriteMany sort
+ * the slots they touch by offset and merge neighbours into large sequential reads and writes.
+ *
+ * Blobs are never written in place: a rewritten blob gets a new slot, and its old slot is only released for
+ * later writes once the index pointing at the new one is written. A failed write leaves the previous blob
+ * readable. Slots are rounded up to SlotAlignment so released slots fit later blobs of similar sizes.
+ * Repack() drops the free space into a new file (<path>.repack) that replaces the container, Open recovers
+ * it if a crash happens meanwhile. Every blob is CRC checked on load. Every function is thread safe.
+ */
+class DATASERIALIZER_API FDataSerializerContainer
+{
+public:
+	/** Version byte written after XEUS_CONTAINER_FILE_TAG. */
+	static constexpr uint8 CurrentVersion = 1;
+
+	/** Slot sizes are rounded up to this, so released slots can be reused by blobs of similar sizes. */
+	static constexpr int32 SlotAlignment = 64;
+
+	~FDataSerializerContainer();
+
+	/**
+	 * Opens a container.
+	 * @param InPath The path to the file.
+	 * @param bInCreate Creates the container if the file does not exist, opening fails otherwise.
+	 * @return The container, nullptr if the file cannot be opened or is not a container.
+	 */
+	static TSharedPtr<FDataSerializerContainer, ESPMode::ThreadSafe> Open(const FString& InPath, bool bInCreate = true);
+
+	/**
+	 * Writes a blob, replacing the previous blob of the key.
+	 * @param InKey Name of the blob.
+	 * @param InBytes The data of the blob.
+	 * @return true on success.
+	 */
+	bool Write(const FString& InKey, TArrayView<const uint8> InBytes);
+
+	/**
+	 * Writes several blobs, the index is written and the file flushed once.
+	 * On failure the container is left as it was, previous blobs of the keys included.
+	 * @param InKeys One key per blob.
+	 * @param InBlobs The data of each blob.
+	 * @return true on success.
+	 */
+	bool WriteMany(TArrayView<const FString> InKeys, TArrayView<const TArray<uint8>> InBlobs);
+
+	/**
+	 * Reads a blob.
+	 * @param InKey Name of the blob.
+	 * @param OutBytes The data of the blob.
+	 * @return true if the blob exists and is intact.
+	 */
+	bool Read(const FString& InKey, TArray<uint8>& OutBytes) const;
+
+	/**
+	 * Reads several blobs, neighbouring slots are read together.
+	 * @param InKeys The names of the blobs.
+	 * @param OutBlobs The data of each blob, empty for the missing ones.
+	 * @return true if every blob exists and is intact.
+	 */
+	bool ReadMany(TArrayView<const FString> InKeys, TArray<TArray<uint8>>& OutBlobs) const;
+
+	/**
+	 * Removes a blob, its slot is reused by later writes.
+	 * @param InKey Name of the blob.
+	 * @return true if the blob existed and the index has been written.
+	 */
+	bool Remove(const FString& InKey);
+
+	/**
+	 * Removes several blobs, the index is written once.
+	 * @param InKeys The names of the blobs.
+	 * @return true if every blob existed and the index has been written.
+	 */
+	bool RemoveMany(TArrayView<const FString> InKeys);
+
+	/** @return The names of the blobs. */
+	TArray<FString> GetKeys() const;
+
+	/** @return true if the container has a blob with this name. */
+	bool Contains(const FString& InKey) const;
+
+	/** @return Number of blobs. */
+	int32 Num() const;
+
+	/** @return Bytes of the data area that are not used by any blob. */
+	int64 GetFreeBytes() const;
+
+	/**
+	 * Rewrites the container with the blobs packed one after the other.
+	 * @return true on success, the container is left as it was otherwise.
+	 */
+	bool Repack();
+
+	/** @return The path of the file. */
+	const FString& GetPath() const { return Path; }
+
+private:
+	/** Location of a blob. */
+	struct FSlot
+	{
+		int64 Offset = 0;
+		int32 Size = 0;
+		int32 Capacity = 0;
+		uint32 Crc = 0;
+	};
+
+	/** Unused range of the data area. */
+	struct FFreeRange
+	{
+		int64 Offset = 0;
+		int32 Capacity = 0;
+	};
+
+	FDataSerializerContainer() = default;
+
+	/** Reads the header and the index. */
+	bool ReadIndex();
+
+	/** Writes the header and the index at the head of the file, Lock must be held. */
+	bool WriteIndex();
+
+	/** Returns a range of the data area, Lock must be held. */
+	FFreeRange Allocate(int32 InSize);
+
+	/** Gives a range back to the free list, merging it with its neighbours, Lock must be held. */
+	void Release(int64 InOffset, int32 InCapacity);
+
+	/** Rewrites the file with the given index capacity, Lock must be held. */
+	bool RepackInternal(int32 InIndexCapacity);
+
+	FString Path;
+
+	/** Guards everything below, reads share the file handle with writes. */
+	mutable FCriticalSection Lock;
+	TUniquePtr<IFileHandle> File;
+	TMap<FString, FSlot> Index;
+	/** Sorted by offset, neighbours are always merged. */
+	TArray<FFreeRange> FreeRanges;
+	/** Bytes reserved for the index after the header. */
+	int32 IndexCapacity = 0;
+	/** End of the used part of the data area. */
+	int64 DataEnd = 0;
+};
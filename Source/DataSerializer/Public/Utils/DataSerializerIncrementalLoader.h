@@ -0,0 +1,139 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Serialization/MemoryReader.h"
+#include "Tickable.h"
+#include "UObject/Object.h"
+#include "DataSerializerIncrementalLoader.generated.h"
+
+namespace Serializer
+{
+	struct FIncrementalLoadPlan;
+}
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FDataSerializerLoaderProgress, int32, NumLoaded, int32, NumTotal);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FDataSerializerLoaderCompleted, bool, bSuccess,
+                                             const TArray<UObject*>&, Objects);
+
+/**
+ * @class UDataSerializerIncrementalLoader
+ * @brief Deserializes a batch of objects over several frames.
+ *
+ * The record layout is parsed and the classes are resolved on the thread pool, garbage collection waits
+ * for it. The resolved classes of batches and of indexed archives are reported to garbage collection
+ * until the loader finishes. Then every tick creates and loads as many objects as fit in the frame budget,
+ * so large batches no longer stall the game thread.
+ * Archives written by SerializeObjectsIndexed are parsed completely ahead of time, batches written by
+ * SerializeObjects are read record after record. Object graphs are loaded in a single step.
+ * The loader keeps itself alive until it completes or is cancelled.
+ */
+UCLASS(BlueprintType)
+class DATASERIALIZER_API UDataSerializerIncrementalLoader : public UObject, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Called after each tick that loaded objects, except the last one. */
+	UPROPERTY(BlueprintAssignable)
+	FDataSerializerLoaderProgress OnProgress;
+
+	/** Called once every object has been loaded, or on the first failure. */
+	UPROPERTY(BlueprintAssignable)
+	FDataSerializerLoaderCompleted OnCompleted;
+
+public:
+	/**
+	 * Starts deserializing bytes written by SerializeObjects or SerializeObjectsIndexed over several frames.
+	 *
+	 * @param InBytes The serialized objects.
+	 * @param InObjectOuter The outer object for the deserialized objects.
+	 * @param InBudgetMs Time spent loading objects per frame, at least one object is loaded per frame.
+	 * @return The loader, bind its events right away, they fire from the next frame on.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Serialization")
+	static UDataSerializerIncrementalLoader* DeSerializeObjectsIncremental(const TArray<uint8>& InBytes,
+	                                                                       UObject* InObjectOuter,
+	                                                                       float InBudgetMs = 2.0f);
+
+	/** C++ version of DeSerializeObjectsIncremental, takes the buffer without copying it. */
+	static UDataSerializerIncrementalLoader* DeSerializeObjectsIncrementalCpp(TArray<uint8>&& InBytes,
+	                                                                          UObject* InObjectOuter,
+	                                                                          float InBudgetMs = 2.0f);
+
+	/** Stops loading, the objects loaded so far are kept and OnCompleted does not fire. */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerLib|Serialization")
+	void Cancel();
+
+	/** @return Share of the objects loaded, in [0, 1]. */
+	UFUNCTION(BlueprintPure, Category="UDataSerializerLib|Serialization")
+	float GetProgress() const;
+
+	/** @return true once the loader completed or was cancelled. */
+	UFUNCTION(BlueprintPure, Category="UDataSerializerLib|Serialization")
+	bool IsDone() const { return State == EState::Done; }
+
+	/** @return The objects loaded so far. */
+	UFUNCTION(BlueprintPure, Category="UDataSerializerLib|Serialization")
+	const TArray<UObject*>& GetObjects() const { return Objects; }
+
+	//~ Begin UObject Interface
+	virtual void BeginDestroy() override;
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+	//~ End UObject Interface
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual bool IsTickable() const override { return State != EState::Done; }
+	virtual bool IsTickableWhenPaused() const override { return true; }
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject Interface
+
+protected:
+	enum class EState : uint8
+	{
+		/** The record layout is parsed on the thread pool. */
+		Preparing,
+		/** Objects are loaded on the game thread. */
+		Loading,
+		Done
+	};
+
+	/** Starts parsing the records on the thread pool. */
+	void Begin(TArray<uint8>&& InBytes, UObject* InObjectOuter, float InBudgetMs);
+
+	/** Resolves the classes that could not be loaded off the game thread, opens the reader. */
+	bool BeginLoading();
+
+	/** Loads the next record. */
+	bool LoadNext();
+
+	/** Stops ticking, lets the loader be collected and fires OnCompleted if asked. */
+	void Finish(bool bInSuccess, bool bInBroadcast);
+
+protected:
+	/** Outer of the loaded objects. */
+	UPROPERTY()
+	UObject* ObjectOuter = nullptr;
+
+	/** Objects loaded so far. */
+	UPROPERTY()
+	TArray<UObject*> Objects;
+
+	/** The serialized objects, read by the preparation task then by the game thread. */
+	TArray<uint8> Bytes;
+
+	/** Record layout, filled by the preparation task. */
+	TSharedPtr<Serializer::FIncrementalLoadPlan, ESPMode::ThreadSafe> Plan;
+	TFuture<bool> PlanTask;
+
+	/** Reader of the game thread, created once the plan is ready. */
+	TOptional<FMemoryReaderView> Reader;
+
+	EState State = EState::Done;
+	float BudgetSeconds = 0.002f;
+	int32 NumLoaded = 0;
+};
@@ -0,0 +1,170 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <atomic>
+
+class IFileHandle;
+
+/** First bytes of journal files, see FDataSerializerJournal. */
+constexpr uint32 XEUS_JOURNAL_FILE_TAG = 0x7865756A; //xeuj
+
+/**
+ * @class FDataSerializerJournal
+ * @brief Append-only save file of keyed records.
+ *
+ * Every save appends length-prefixed, CRC checked records keyed by object ID, so persisting a few changed
+ * objects only writes those objects. Opening the file replays it: the latest record of each key wins,
+ * removals are recorded as tombstones, and a torn record at the end (crash during a save) is dropped.
+ *
+ * Overwritten records stay in the file as garbage until compaction rewrites the live records into a packed
+ * file. Compaction starts on the thread pool once the garbage ratio passes GetCompactionThreshold(),
+ * saves and loads can go on meanwhile. The packed file is written next to the journal (<path>.compact)
+ * and recovered by Open if a crash happens while it replaces the journal. Every function is thread safe.
+ */
+class DATASERIALIZER_API FDataSerializerJournal : public TSharedFromThis<FDataSerializerJournal, ESPMode::ThreadSafe>
+{
+public:
+	/** Version byte written after XEUS_JOURNAL_FILE_TAG. */
+	static constexpr uint8 CurrentVersion = 1;
+
+	~FDataSerializerJournal();
+
+	/**
+	 * Opens a journal, creating it if needed, and replays it.
+	 * @param InPath The path to the file.
+	 * @return The journal, nullptr if the file cannot be opened or is not a journal.
+	 */
+	static TSharedPtr<FDataSerializerJournal, ESPMode::ThreadSafe> Open(const FString& InPath);
+
+	/**
+	 * Appends a record.
+	 * @param InKey ID of the object, replaces the previous record of the key.
+	 * @param InBytes The data of the record, e.g. bytes written by UDataSerializerLib::SerializeObject.
+	 * @return true if the record has been written.
+	 */
+	bool Append(const FString& InKey, TArrayView<const uint8> InBytes);
+
+	/**
+	 * Appends several records with a single write.
+	 * @param InKeys One key per record.
+	 * @param InRecords The data of each record.
+	 * @return true if the records have been written.
+	 */
+	bool AppendBatch(TArrayView<const FString> InKeys, TArrayView<const TArray<uint8>> InRecords);
+
+	/**
+	 * Removes a key by appending a tombstone.
+	 * @param InKey ID of the object.
+	 * @return true if the key existed and the tombstone has been written.
+	 */
+	bool Remove(const FString& InKey);
+
+	/**
+	 * Reads the latest record of a key.
+	 * @param InKey ID of the object.
+	 * @param OutBytes The data of the record.
+	 * @return true if the key exists and the record could be read.
+	 */
+	bool Load(const FString& InKey, TArray<uint8>& OutBytes) const;
+
+	/**
+	 * Reads the latest record of every key, the file is read once.
+	 * @param OutRecords The data of each key.
+	 * @return true on success.
+	 */
+	bool LoadAll(TMap<FString, TArray<uint8>>& OutRecords) const;
+
+	/** @return The keys that have a record. */
+	TArray<FString> GetKeys() const;
+
+	/** @return true if the key has a record. */
+	bool Contains(const FString& InKey) const;
+
+	/** @return Size of the file. */
+	int64 GetFileSize() const;
+
+	/** @return Share of the file taken by overwritten records and tombstones, in [0, 1]. */
+	double GetGarbageRatio() const;
+
+	/**
+	 * Sets when compaction starts by itself.
+	 * @param InThreshold Garbage ratio above which the journal is compacted, 1 or more disables it.
+	 * @param InMinFileSize Smaller files are never compacted by themselves.
+	 */
+	void SetCompactionThreshold(double InThreshold, int64 InMinFileSize = 1024 * 1024);
+
+	/** @return Garbage ratio above which the journal is compacted. */
+	double GetCompactionThreshold() const { return CompactionThreshold; }
+
+	/**
+	 * Rewrites the live records into a packed file, waits for a running compaction first.
+	 * @return true on success, the journal is left as it was otherwise.
+	 */
+	bool Compact();
+
+	/** Starts a compaction on the thread pool, unless one is already running. */
+	void CompactAsync();
+
+	/** @return true while a background compaction runs. */
+	bool IsCompacting() const { return bCompacting; }
+
+	/** Blocks until the background compaction, if any, has finished. */
+	void WaitForCompaction() const;
+
+	/** @return The path of the file. */
+	const FString& GetPath() const { return Path; }
+
+private:
+	/** Location of the latest record of a key. */
+	struct FEntry
+	{
+		/** Offset of the record in the file. */
+		int64 Offset = 0;
+
+		/** Size of the record, length prefix and checksum included. */
+		int32 RecordSize = 0;
+
+		/** Offset of the data in the record. */
+		int32 DataOffset = 0;
+
+		/** Size of the data. */
+		int32 DataSize = 0;
+	};
+
+	FDataSerializerJournal() = default;
+
+	/** Reads the records, stops at the first torn or corrupt one and returns its offset. */
+	bool Replay(int64& OutValidEnd);
+
+	/** Writes encoded records and updates the index, Lock must be held. */
+	bool WriteRecords(const TArray<uint8>& InRecords, TArrayView<const FString> InKeys,
+	                  const TArray<FEntry>& InEntries, const TArray<bool>& InTombstones);
+
+	/** Opens the file for appending, Lock must be held. */
+	bool OpenWriter();
+
+	/** Starts a compaction if the garbage ratio calls for it. */
+	void CompactIfNeeded();
+
+	/** Does the compaction, CompactionLock must be held. */
+	bool CompactInternal();
+
+	FString Path;
+
+	/** Guards the index, the writer and the sizes. */
+	mutable FCriticalSection Lock;
+	TMap<FString, FEntry> Index;
+	TUniquePtr<IFileHandle> Writer;
+	int64 FileSize = 0;
+	int64 LiveSize = 0;
+
+	/** Held for the whole compaction, so only one runs at a time. */
+	FCriticalSection CompactionLock;
+	std::atomic<bool> bCompacting{false};
+
+	double CompactionThreshold = 0.5;
+	int64 MinCompactionFileSize = 1024 * 1024;
+};
@@ -0,0 +1,53 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * @class FDataSerializerMappedFile
+ * @brief Read-only memory mapping of a whole file.
+ *
+ * Pages are loaded lazily by the OS when they are first touched, so reading a header or a few records
+ * of a large archive only loads those pages. The mapping lives as long as the handle, share it with
+ * UDeSerializerObject::StartMapped or read it with an FMemoryReaderView over GetView().
+ * Platforms without memory mapping fall back to loading the file into memory.
+ */
+class DATASERIALIZER_API FDataSerializerMappedFile
+{
+public:
+	~FDataSerializerMappedFile();
+
+	/**
+	 * Maps a file.
+	 * @param InPath The path to the file.
+	 * @return The mapping, nullptr if the file cannot be opened.
+	 */
+	static TSharedPtr<FDataSerializerMappedFile, ESPMode::ThreadSafe> Open(const FString& InPath);
+
+	/** @return The mapped bytes, valid as long as this object lives. */
+	TArrayView64<const uint8> GetView() const { return View; }
+
+	/** @return Size of the file. */
+	int64 Num() const { return View.Num(); }
+
+	/** @return true if the file is memory mapped, false if it has been loaded (fallback). */
+	bool IsMapped() const { return Region.IsValid(); }
+
+	/** @return The path of the file. */
+	const FString& GetPath() const { return Path; }
+
+private:
+	FDataSerializerMappedFile() = default;
+
+	FString Path;
+	TUniquePtr<IMappedFileHandle> Handle;
+	/** Declared after Handle, so it is unmapped before the handle is closed. */
+	TUniquePtr<IMappedFileRegion> Region;
+	/** File content when the platform cannot map it. */
+	TArray<uint8> LoadedBytes;
+	TArrayView64<const uint8> View;
+};
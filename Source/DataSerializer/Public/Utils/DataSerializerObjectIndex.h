@@ -0,0 +1,125 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * @class FDataSerializerObjectIndex
+ * @brief Record table of an indexed object archive written by UDataSerializerLib::SerializeObjectsIndexed.
+ *
+ * Every record carries its offset and size, so a single object or a range of objects can be
+ * deserialized without touching the other records. Read the index once and keep it to reach
+ * many records of the same buffer.
+ */
+class DATASERIALIZER_API FDataSerializerObjectIndex
+{
+public:
+	/** Version of the indexed object archive format. */
+	static constexpr uint8 CurrentVersion = 1;
+
+	/** Record of the table. */
+	struct FEntry
+	{
+		/** Index of the record class in the class table. */
+		uint32 ClassIndex = 0;
+
+		/** Offset of the record from the start of the data section. */
+		int64 Offset = 0;
+
+		/** Size of the record. */
+		int64 Size = 0;
+
+		friend FArchive& operator<<(FArchive& Ar, FEntry& Entry)
+		{
+			Ar << Entry.ClassIndex;
+			Ar << Entry.Offset;
+			Ar << Entry.Size;
+			return Ar;
+		}
+	};
+
+public:
+	/**
+	 * Reads the header, class table and record table.
+	 *
+	 * Classes are resolved here. On success the reader is left at the end of the archive data,
+	 * so sequential reading can carry on after it.
+	 *
+	 * @param InReader Seekable archive positioned at the start of an indexed object archive.
+	 * @return true if the table was read.
+	 */
+	bool Read(FArchive& InReader);
+
+	/** @return Number of records. */
+	int32 Num() const { return Entries.Num(); }
+
+	/** @return true if the records have keys. */
+	bool HasKeys() const { return Keys.Num() > 0; }
+
+	/**
+	 * Finds a record by key.
+	 * @param InKey Key given when writing (object name by default).
+	 * @return Index of the record or INDEX_NONE.
+	 */
+	int32 FindByKey(const FString& InKey) const;
+
+	/**
+	 * Gets the key of a record.
+	 * @param InIndex Index of the record.
+	 * @return The key, empty if the archive has no keys.
+	 */
+	FString GetKey(int32 InIndex) const;
+
+	/** @return The table entries. */
+	const TArray<FEntry>& GetEntries() const { return Entries; }
+
+	/**
+	 * Gets the class of a record.
+	 * @param InIndex Index of the record.
+	 * @return The class or nullptr if it could not be resolved.
+	 */
+	UClass* GetClass(int32 InIndex) const;
+
+	/** @return Position of the data section in the archive. */
+	int64 GetDataStart() const { return DataStart; }
+
+	/**
+	 * Deserializes a single record.
+	 * @param InReader The archive the index was read from.
+	 * @param InIndex Index of the record.
+	 * @param InObjectOuter The outer of the new object.
+	 * @param OutObject The new object.
+	 * @return true on success.
+	 */
+	bool DeSerializeObject(FArchive& InReader, int32 InIndex, UObject* InObjectOuter, UObject*& OutObject) const;
+
+	/**
+	 * Deserializes a single record into an existing object.
+	 * @param InReader The archive the index was read from.
+	 * @param InIndex Index of the record.
+	 * @param InTarget The object to load into, of the record class. Reset it first, see ResetObjectToDefaults.
+	 * @return true on success.
+	 */
+	bool DeSerializeInto(FArchive& InReader, int32 InIndex, UObject* InTarget) const;
+
+	/**
+	 * Deserializes a range of records.
+	 * @param InReader The archive the index was read from.
+	 * @param InFirst Index of the first record.
+	 * @param InCount Number of records.
+	 * @param InObjectOuter The outer of the new objects.
+	 * @param OutObjects Array the new objects are appended to.
+	 * @return true on success.
+	 */
+	bool DeSerializeObjects(FArchive& InReader, int32 InFirst, int32 InCount, UObject* InObjectOuter,
+	                        TArray<UObject*>& OutObjects) const;
+
+private:
+	TArray<TWeakObjectPtr<UClass>> Classes;
+	TArray<FString> Keys;
+	TMap<FString, int32> KeyToIndex;
+	TArray<FEntry> Entries;
+	int64 DataStart = 0;
+	int64 DataEnd = 0;
+};
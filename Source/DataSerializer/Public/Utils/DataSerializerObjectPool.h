@@ -0,0 +1,91 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "DataSerializerObjectPool.generated.h"
+
+/** Pooled objects of one class. */
+USTRUCT()
+struct DATASERIALIZER_API FDataSerializerPoolBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<UObject*> Objects;
+};
+
+/**
+ * @class UDataSerializerObjectPool
+ * @brief Per-class pool of objects reused by UDataSerializerLib::DeSerializeObjectsPooled.
+ *
+ * Release the objects of the previous load before the next one: their instances are reset to their defaults
+ * and loaded again instead of creating new objects, so reloading the same snapshot creates no garbage.
+ * The pool keeps the released objects alive.
+ */
+UCLASS(BlueprintType)
+class DATASERIALIZER_API UDataSerializerObjectPool : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Released objects beyond this count per class are left to the garbage collector. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category="UDataSerializerObjectPool")
+	int32 MaxObjectsPerClass = 4096;
+
+	/**
+	 * Creates an empty pool.
+	 * @param InMaxObjectsPerClass Released objects beyond this count per class are dropped.
+	 * @return The pool, keep a reference to it.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerObjectPool")
+	static UDataSerializerObjectPool* CreateObjectPool(int32 InMaxObjectsPerClass = 4096);
+
+	/**
+	 * Takes an object out of the pool, reset to its defaults, or creates one if the pool has none.
+	 * @param InClass The class of the object.
+	 * @param InOuter The outer of the object, pooled objects are moved to it if needed.
+	 * @return The object.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerObjectPool")
+	UObject* Acquire(TSubclassOf<UObject> InClass, UObject* InOuter);
+
+	/**
+	 * Gives an object back to the pool, it must not be used anymore nor released twice.
+	 * @param InObject The object.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerObjectPool")
+	void Release(UObject* InObject);
+
+	/**
+	 * Gives objects back to the pool, typically the objects of the previous load.
+	 * @param InObjects The objects.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerObjectPool")
+	void ReleaseObjects(const TArray<UObject*>& InObjects);
+
+	/** @return Number of pooled objects of a class. */
+	UFUNCTION(BlueprintPure, Category="UDataSerializerObjectPool")
+	int32 GetNumPooled(TSubclassOf<UObject> InClass) const;
+
+	/** @return Number of objects created because the pool had none, since the pool was created. */
+	UFUNCTION(BlueprintPure, Category="UDataSerializerObjectPool")
+	int32 GetNumCreated() const { return NumCreated; }
+
+	/** @return Number of pooled objects handed out again, since the pool was created. */
+	UFUNCTION(BlueprintPure, Category="UDataSerializerObjectPool")
+	int32 GetNumReused() const { return NumReused; }
+
+	/** Drops every pooled object. */
+	UFUNCTION(BlueprintCallable, Category="UDataSerializerObjectPool")
+	void Empty();
+
+protected:
+	/** Released objects per class. */
+	UPROPERTY()
+	TMap<UClass*, FDataSerializerPoolBucket> Buckets;
+
+	int32 NumCreated = 0;
+	int32 NumReused = 0;
+};
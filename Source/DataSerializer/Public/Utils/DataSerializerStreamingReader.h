@@ -0,0 +1,74 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Serialization/Archive.h"
+
+class IFileHandle;
+
+/**
+ * @class FDataSerializerStreamingReader
+ * @brief Read-only archive over a file that keeps at most two chunks in memory.
+ *
+ * Reads are served from the current chunk while the next one is read on the thread pool, so sequential
+ * reads rarely wait on the disk and archives larger than memory can be read with a fixed budget.
+ * Seeks are allowed anywhere, a seek out of the loaded chunks costs a synchronous read.
+ * Pass it to UDeSerializerObject::StartStream or to any function taking an FArchive.
+ */
+class DATASERIALIZER_API FDataSerializerStreamingReader : public FArchive
+{
+public:
+	/** Chunk size used when none is given. */
+	static constexpr int32 DefaultChunkSize = 1024 * 1024;
+
+	virtual ~FDataSerializerStreamingReader() override;
+
+	/**
+	 * Opens a file for streaming.
+	 * @param InPath The path to the file.
+	 * @param InChunkSize Size of each read, the reader holds two chunks.
+	 * @return The reader, nullptr if the file cannot be opened.
+	 */
+	static TUniquePtr<FDataSerializerStreamingReader> Open(const FString& InPath, int32 InChunkSize = DefaultChunkSize);
+
+	//~ Begin FArchive Interface
+	virtual void Serialize(void* Data, int64 Num) override;
+	virtual void Seek(int64 InPos) override;
+	virtual int64 Tell() override { return Pos; }
+	virtual int64 TotalSize() override { return Size; }
+	virtual bool Close() override;
+	virtual FString GetArchiveName() const override { return Path; }
+	//~ End FArchive Interface
+
+private:
+	FDataSerializerStreamingReader() = default;
+
+	/** Makes the chunk holding Pos current, returns false on read errors. */
+	bool LoadChunk();
+
+	/** Reads the chunk after the current one on the thread pool. */
+	void StartPrefetch();
+
+	/** Waits for the prefetch, the file handle is free afterwards. */
+	bool WaitForPrefetch();
+
+	/** Reads a range of the file on the calling thread. */
+	bool ReadAt(int64 InOffset, uint8* OutData, int64 InNum);
+
+	FString Path;
+	TUniquePtr<IFileHandle> Handle;
+	int64 Size = 0;
+	int64 Pos = 0;
+	int32 ChunkSize = DefaultChunkSize;
+
+	/** Chunk reads are served from. */
+	TArray<uint8> Current;
+	int64 CurrentOffset = 0;
+
+	/** Chunk being read in the background, owns the file handle until the future is ready. */
+	TArray<uint8> Next;
+	int64 NextOffset = INDEX_NONE;
+	TFuture<bool> Prefetch;
+};
@@ -4,6 +4,10 @@
 
 #include "CoreMinimal.h"
 #include "UObject/Object.h"
+#include "Serialization/MemoryReader.h"
+#include "Libs/DataSerializerEncoding.h"
+#include "Utils/DataSerializerMappedFile.h"
+#include "Utils/DataSerializerStreamingReader.h"
 #include "DeSerializerObject.generated.h"
 
 /**
@@ -11,6 +15,9 @@
  * @brief A class responsible for deserializing data from a memory buffer.
  * 
  * This class provides various functions to read different data types from a memory buffer.
+ * The buffer can be copied (Start), moved in (StartOwned), borrowed (StartView) or shared (StartShared),
+ * a view or a shared buffer may cover only a sub-range of a larger buffer.
+ * Files larger than memory can be streamed in chunks instead (StartStream).
  */
 UCLASS(Blueprintable, BlueprintType)
 class DATASERIALIZER_API UDeSerializerObject : public UObject
@@ -22,15 +29,67 @@ public:
 	UDeSerializerObject();
 
 protected:
-	/** Memory reader used to deserialize data from a buffer. */
-	TSharedPtr<FMemoryReader> MemoryReader;
+	/** Memory reader used to deserialize data from a buffer, reads the current view in place. */
+	TOptional<FMemoryReaderView> MemoryReader;
+
+	/** Buffer owned by the deserializer (Start, StartOwned). */
+	TArray<uint8> OwnedBytes;
+
+	/** Buffer shared with other readers (StartShared). */
+	TSharedPtr<const TArray<uint8>, ESPMode::ThreadSafe> SharedBytes;
+
+	/** Mapped file kept alive while it is read (StartMapped). */
+	TSharedPtr<FDataSerializerMappedFile, ESPMode::ThreadSafe> MappedFile;
+
+	/** File read in chunks, used instead of MemoryReader (StartStream). */
+	TUniquePtr<FDataSerializerStreamingReader> StreamReader;
+
+	/** Encoding of integers and byte counts, must match the writer. Kept by Clear() and Start(). */
+	UPROPERTY(BlueprintReadOnly)
+	EDataSerializerIntEncoding IntEncoding = EDataSerializerIntEncoding::Fixed;
+
+	/** Booleans are read as single bits, must match the writer. Kept by Clear() and Start(). */
+	UPROPERTY(BlueprintReadOnly)
+	bool bPackBools = false;
+
+	/** Remaining bits of the last byte read by TryReadBits. */
+	uint8 BitBuffer = 0;
+
+	/** Number of bits left in BitBuffer, dropped by any byte-level read. */
+	int32 NumBitsLeft = 0;
 
 protected:
 	/**
 	 * Gets a reference to the memory reader.
-	 * @return A reference to the FMemoryReader instance.
+	 * @note Drops the bits left by TryReadBits, byte-level reads always start on a byte boundary.
+	 * @return A reference to the reader archive.
 	 */
-	FMemoryReader& GetMemoryReaderRef() const;
+	FArchive& GetMemoryReaderRef();
+
+	/** @return true if a buffer or a file is being read. */
+	bool HasReader() const { return MemoryReader.IsSet() || StreamReader.IsValid(); }
+
+	/**
+	 * Starts reading a view, the memory must outlive the reading.
+	 * @param InBytes The bytes to read.
+	 */
+	void BeginStream(TArrayView64<const uint8> InBytes);
+
+	/** Checks the stream preamble of the current reader against the selected mode. */
+	void ReadPreamble();
+
+	/** Reads a 32-bit integer in the stream encoding. */
+	bool TryReadInt32Encoded(int32& OutValue);
+
+	/** Reads a 64-bit integer in the stream encoding. */
+	bool TryReadInt64Encoded(int64& OutValue);
+
+	/**
+	 * Reads an array length or byte count written by USerializerObject::WriteArrayNum.
+	 * @param OutCount The count.
+	 * @param InElementSize Size of one element, the count is checked against the remaining data.
+	 */
+	bool TryReadCount(int64& OutCount, int64 InElementSize = 1);
 
 public:
 	/**
@@ -47,6 +106,87 @@ public:
 	UFUNCTION(BlueprintCallable, Category="UDeSerializerObject")
 	virtual void Start(const TArray<uint8>& InBytes);
 
+	/**
+	 * Starts the deserialization process on a buffer moved into the deserializer, without copying it.
+	 * @param InBytes The array of bytes to deserialize.
+	 */
+	void StartOwned(TArray<uint8>&& InBytes);
+
+	/**
+	 * Starts the deserialization process on borrowed memory, without copying it.
+	 * @note The memory must stay alive and unchanged until Clear() or the next Start.
+	 * @param InBytes The memory to deserialize (a packet, a mapped file region...).
+	 * @param InOffset Offset of the range to read in InBytes.
+	 * @param InLength Length of the range, INDEX_NONE reads to the end.
+	 */
+	void StartView(TArrayView64<const uint8> InBytes, int64 InOffset = 0, int64 InLength = INDEX_NONE);
+
+	/**
+	 * Starts the deserialization process on a ref-counted buffer, kept alive while it is read.
+	 * One loaded buffer can feed many deserializers this way.
+	 * @param InBytes The buffer to deserialize.
+	 * @param InOffset Offset of the range to read in InBytes.
+	 * @param InLength Length of the range, INDEX_NONE reads to the end.
+	 */
+	void StartShared(const TSharedRef<const TArray<uint8>, ESPMode::ThreadSafe>& InBytes, int64 InOffset = 0,
+	                 int64 InLength = INDEX_NONE);
+
+	/**
+	 * Starts the deserialization process on a memory mapped file, pages are loaded as they are read.
+	 * @param InFile The mapped file, kept alive while it is read.
+	 * @param InOffset Offset of the range to read in the file.
+	 * @param InLength Length of the range, INDEX_NONE reads to the end.
+	 */
+	void StartMapped(const TSharedRef<FDataSerializerMappedFile, ESPMode::ThreadSafe>& InFile, int64 InOffset = 0,
+	                 int64 InLength = INDEX_NONE);
+
+	/**
+	 * Maps a file written with WriteBytesToDisk and starts the deserialization process on it.
+	 * @param InPath The path to the file.
+	 * @return true if the file could be opened.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDeSerializerObject")
+	virtual bool StartFromFile(FString InPath);
+
+	/**
+	 * Starts the deserialization process on a file read in chunks, for files that do not fit in memory.
+	 * At most two chunks are held, the next one is read in the background.
+	 * @param InPath The path to the file.
+	 * @param InChunkSize Size of each read in bytes.
+	 * @return true if the file could be opened.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDeSerializerObject")
+	virtual bool StartFromFileStreamed(FString InPath,
+	                                   int32 InChunkSize = FDataSerializerStreamingReader::DefaultChunkSize);
+
+	/**
+	 * Starts the deserialization process on a streaming reader, owned by the deserializer from now on.
+	 * @param InReader The reader, positioned at the start of the stream.
+	 */
+	void StartStream(TUniquePtr<FDataSerializerStreamingReader>&& InReader);
+
+	/**
+	 * Selects how integers and byte counts are read, same as USerializerObject::SetIntEncoding on the writer.
+	 * @note Applies to the next Start, streams written with a non-default mode are checked against their preamble.
+	 * @param InEncoding The encoding.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDeSerializerObject")
+	virtual void SetIntEncoding(EDataSerializerIntEncoding InEncoding);
+
+	/**
+	 * Gets the encoding of integers and byte counts.
+	 */
+	UFUNCTION(BlueprintPure, Category="UDeSerializerObject")
+	EDataSerializerIntEncoding GetIntEncoding() const { return IntEncoding; }
+
+	/**
+	 * Selects whether booleans are read as single bits, same as USerializerObject::SetPackBools on the writer.
+	 * @note Applies to the next Start.
+	 * @param bInPackBools Read booleans as bits.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDeSerializerObject")
+	virtual void SetPackBools(bool bInPackBools);
+
 
 	/**
 	 * Attempts to read a value of type T from the memory buffer.
@@ -57,10 +197,10 @@ public:
 	template <typename T>
 	bool TryReadT(T& OutValue)
 	{
-		if (!MemoryReader.IsValid())
+		if (!HasReader())
 			return false;
 
-		FMemoryReader& reader = GetMemoryReaderRef();
+		FArchive& reader = GetMemoryReaderRef();
 		T value;
 		reader << value;
 
@@ -113,6 +253,15 @@ public:
 	UFUNCTION(BlueprintCallable, Category="UDeSerializerObject|DeSerialization")
 	virtual bool TryReadBool(bool& OutBool);
 
+	/**
+	 * Tries to read bits written by USerializerObject::SerializeBits.
+	 * @param OutValue Reference to the int32 variable where the read bits will be stored.
+	 * @param InNumBits Number of bits, 1 to 32.
+	 * @return true if the bits were successfully read; false otherwise.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDeSerializerObject|DeSerialization")
+	virtual bool TryReadBits(int32& OutValue, UPARAM(DisplayName="Num Bits") int32 InNumBits);
+
 	/**
 	 * Tries to read a uint8 value from the buffer.
 	 * @param OutUInt8 Reference to the uint8 variable where the read value will be stored.
@@ -169,6 +318,113 @@ public:
 	UFUNCTION(BlueprintCallable, Category="UDeSerializerObject|DeSerialization")
 	virtual bool TryReadTransform(FTransform& OutTransform);
 
+	/**
+	 * Tries to read a vector written by USerializerObject::SerializeVectorQuantized.
+	 * @param OutVector Reference to the FVector variable where the read value will be stored.
+	 * @param InPrecision Quantization step used when writing.
+	 * @param InRange Range used when writing.
+	 * @return true if the FVector value was successfully read; false otherwise.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDeSerializerObject|DeSerialization|Quantized")
+	virtual bool TryReadVectorQuantized(FVector& OutVector, UPARAM(DisplayName="Precision") double InPrecision = 0.01,
+	                                    UPARAM(DisplayName="Range") double InRange = 1048576.0);
+
+	/**
+	 * Tries to read a rotator written by USerializerObject::SerializeRotatorCompressed.
+	 * @param OutRotator Reference to the FRotator variable where the read value will be stored.
+	 * @return true if the FRotator value was successfully read; false otherwise.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDeSerializerObject|DeSerialization|Quantized")
+	virtual bool TryReadRotatorCompressed(FRotator& OutRotator);
+
+	/**
+	 * Tries to read a transform written by USerializerObject::SerializeTransformQuantized.
+	 * @param OutTransform Reference to the FTransform variable where the read value will be stored.
+	 * @param InTranslationPrecision Quantization step of the translation used when writing.
+	 * @param InTranslationRange Translation range used when writing.
+	 * @param InScalePrecision Quantization step of the scale used when writing.
+	 * @param InScaleRange Scale range used when writing.
+	 * @return true if the FTransform value was successfully read; false otherwise.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDeSerializerObject|DeSerialization|Quantized")
+	virtual bool TryReadTransformQuantized(FTransform& OutTransform,
+	                                       UPARAM(DisplayName="Translation Precision") double InTranslationPrecision = 0.01,
+	                                       UPARAM(DisplayName="Translation Range") double InTranslationRange = 1048576.0,
+	                                       UPARAM(DisplayName="Scale Precision") double InScalePrecision = 0.001,
+	                                       UPARAM(DisplayName="Scale Range") double InScaleRange = 100.0);
+
+	/**
+	 * Tries to read an array of 32-bit integers written by USerializerObject::SerializeIntArray.
+	 * @param OutInts Reference to the array where the read values will be stored.
+	 * @return true if the array was successfully read; false otherwise.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDeSerializerObject|DeSerialization|Arrays")
+	virtual bool TryReadIntArray(TArray<int32>& OutInts);
+
+	/**
+	 * Tries to read an array of 64-bit integers written by USerializerObject::SerializeBigIntArray.
+	 * @param OutInt64s Reference to the array where the read values will be stored.
+	 * @return true if the array was successfully read; false otherwise.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDeSerializerObject|DeSerialization|Arrays")
+	virtual bool TryReadInt64Array(TArray<int64>& OutInt64s);
+
+	/**
+	 * Tries to read an array of floating-point numbers written by USerializerObject::SerializeFloatArray.
+	 * @param OutFloats Reference to the array where the read values will be stored.
+	 * @return true if the array was successfully read; false otherwise.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDeSerializerObject|DeSerialization|Arrays")
+	virtual bool TryReadFloatArray(TArray<float>& OutFloats);
+
+	/**
+	 * Tries to read an array of double-precision floating-point numbers written by USerializerObject::SerializeDoubleArray.
+	 * @param OutDoubles Reference to the array where the read values will be stored.
+	 * @return true if the array was successfully read; false otherwise.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDeSerializerObject|DeSerialization|Arrays")
+	virtual bool TryReadDoubleArray(TArray<double>& OutDoubles);
+
+	/**
+	 * Tries to read an array of bytes written by USerializerObject::SerializeByteArray.
+	 * @param OutBytes Reference to the array where the read values will be stored.
+	 * @return true if the array was successfully read; false otherwise.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDeSerializerObject|DeSerialization|Arrays")
+	virtual bool TryReadUInt8Array(TArray<uint8>& OutBytes);
+
+	/**
+	 * Tries to read an array of 3D vectors (FVector) written by USerializerObject::SerializeVectorArray.
+	 * @param OutVectors Reference to the array where the read values will be stored.
+	 * @return true if the array was successfully read; false otherwise.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDeSerializerObject|DeSerialization|Arrays")
+	virtual bool TryReadVectorArray(TArray<FVector>& OutVectors);
+
+	/**
+	 * Tries to read an array of 2D vectors (FVector2D) written by USerializerObject::SerializeVector2DArray.
+	 * @param OutVectors Reference to the array where the read values will be stored.
+	 * @return true if the array was successfully read; false otherwise.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDeSerializerObject|DeSerialization|Arrays")
+	virtual bool TryReadVector2DArray(TArray<FVector2D>& OutVectors);
+
+	/**
+	 * Tries to read an array of rotations (FRotator) written by USerializerObject::SerializeRotatorArray.
+	 * @param OutRotators Reference to the array where the read values will be stored.
+	 * @return true if the array was successfully read; false otherwise.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDeSerializerObject|DeSerialization|Arrays")
+	virtual bool TryReadRotatorArray(TArray<FRotator>& OutRotators);
+
+	/**
+	 * Tries to read an array of transforms (FTransform) written by USerializerObject::SerializeTransformArray.
+	 * @param OutTransforms Reference to the array where the read values will be stored.
+	 * @return true if the array was successfully read; false otherwise.
+	 */
+	UFUNCTION(BlueprintCallable, Category="UDeSerializerObject|DeSerialization|Arrays")
+	virtual bool TryReadTransformArray(TArray<FTransform>& OutTransforms);
+
 	/**
 	 * Tries to read an FString value from the buffer.
 	 * @param OutString Reference to the FString variable where the read value will be stored.
@@ -195,4 +451,52 @@ public:
 	UFUNCTION(BlueprintCallable, Category="UDeSerializerObject|DeSerialization")
 	virtual bool TryReadObjects(UObject* InObjectOuter, TArray<UObject*>& OutObjects);
 
+	/**
+	 * Tries to read a value written by USerializerObject::SerializeProperty.
+	 * @param InProperty The property describing the value, of the type it was written with.
+	 * @param OutValue Address of the value, cleared if the data could not be read.
+	 * @return true if the value was successfully read; false otherwise.
+	 */
+	bool TryReadProperty(const FProperty* InProperty, void* OutValue);
+
+	/**
+	 * Tries to read a struct written by USerializerObject::SerializeStruct.
+	 * @param OutValue The struct to fill, of the type that was written.
+	 * @return true if the struct was successfully read; false otherwise.
+	 */
+	UFUNCTION(BlueprintCallable, CustomThunk, Category="UDeSerializerObject|DeSerialization|Containers",
+		meta=(CustomStructureParam="OutValue"))
+	bool TryReadStruct(UPARAM(ref) int32& OutValue);
+	DECLARE_FUNCTION(execTryReadStruct);
+
+	/**
+	 * Tries to read an array written by USerializerObject::SerializeArray.
+	 * @param OutValue The array to fill, of the type that was written.
+	 * @return true if the array was successfully read; false otherwise.
+	 */
+	UFUNCTION(BlueprintCallable, CustomThunk, Category="UDeSerializerObject|DeSerialization|Containers",
+		meta=(ArrayParm="OutValue"))
+	bool TryReadArray(UPARAM(ref) TArray<int32>& OutValue);
+	DECLARE_FUNCTION(execTryReadArray);
+
+	/**
+	 * Tries to read a map written by USerializerObject::SerializeMap.
+	 * @param OutValue The map to fill, of the type that was written.
+	 * @return true if the map was successfully read; false otherwise.
+	 */
+	UFUNCTION(BlueprintCallable, CustomThunk, Category="UDeSerializerObject|DeSerialization|Containers",
+		meta=(MapParam="OutValue"))
+	bool TryReadMap(UPARAM(ref) TMap<int32, int32>& OutValue);
+	DECLARE_FUNCTION(execTryReadMap);
+
+	/**
+	 * Tries to read a set written by USerializerObject::SerializeSet.
+	 * @param OutValue The set to fill, of the type that was written.
+	 * @return true if the set was successfully read; false otherwise.
+	 */
+	UFUNCTION(BlueprintCallable, CustomThunk, Category="UDeSerializerObject|DeSerialization|Containers",
+		meta=(SetParam="OutValue"))
+	bool TryReadSet(UPARAM(ref) TSet<int32>& OutValue);
+	DECLARE_FUNCTION(execTryReadSet);
+
 };
@@ -4,6 +4,8 @@
 
 #include "CoreMinimal.h"
 #include "UObject/Object.h"
+#include "Serialization/MemoryWriter.h"
+#include "Libs/DataSerializerEncoding.h"
 #include "SerializerObject.generated.h"
 
 /**
@@ -35,16 +37,42 @@ protected:
 	TArray<uint8> Bytes;
 
 	/** 
-	 * @brief Shared pointer to a memory writer used for serialization.
+	 * @brief Memory writer used for serialization, stored in place.
 	 * 
 	 * The `FMemoryWriter` is used to write data into the `Bytes` array.
 	 */
-	TSharedPtr<FMemoryWriter> MemoryWriter;
+	TOptional<FMemoryWriter> MemoryWriter;
+
+	/**
+	 * @brief Encoding of integers and byte counts.
+	 *
+	 * Recorded at the start of the stream by Prepare() when it is not Fixed,
+	 * UDeSerializerObject must select the same encoding before reading.
+	 * @see SetIntEncoding
+	 */
+	UPROPERTY(BlueprintReadOnly)
+	EDataSerializerIntEncoding IntEncoding = EDataSerializerIntEncoding::Fixed;
+
+	/**
+	 * @brief Booleans are written as single bits.
+	 *
+	 * Recorded at the start of the stream by Prepare(), UDeSerializerObject must select the same mode.
+	 * @see SetPackBools
+	 */
+	UPROPERTY(BlueprintReadOnly)
+	bool bPackBools = false;
+
+	/** Bits written by SerializeBits that do not fill a byte yet. */
+	uint8 PendingBits = 0;
+
+	/** Number of bits used in PendingBits. */
+	int32 NumPendingBits = 0;
 
 protected:
 	/**
 	 * @brief Gets a reference to the memory writer.
 	 * @note If MemoryWriter has not been set, then it will call the Prepare() method
+	 * @note Pending bits are flushed first, so byte-level writes always start on a byte boundary
 	 * @see Prepare
 	 * @see MemoryWriter
 	 * 
@@ -52,6 +80,24 @@ protected:
 	 */
 	virtual FMemoryWriter& GetMemoryWriterRef();
 
+	/** Starts the writer on the current (empty) Bytes array and writes the stream preamble. */
+	void BeginStream();
+
+	/** Writes the pending bits padded to a full byte. */
+	void FlushBits();
+
+	/** Writes a 32-bit integer in the selected encoding. */
+	void WriteInt32(int32 InValue);
+
+	/** Writes a 64-bit integer in the selected encoding. */
+	void WriteInt64(int64 InValue);
+
+	/** Writes an array length or byte count in the selected encoding. */
+	void WriteArrayNum(int32 InNum);
+
+	/** Writes a byte count in the selected encoding followed by the bytes. */
+	void WriteByteArray(const TArray<uint8>& InBytes);
+
 public:
 	/**
 	 * @brief Retrieves the serialized bytes.
@@ -61,8 +107,28 @@ public:
 	UFUNCTION(BlueprintCallable, Category="USerializerObject")
 	virtual void GetBytes(TArray<uint8>& OutBytes);
 
+	/**
+	 * @brief Gets a view of the serialized bytes without copying them.
+	 * @note Bits of an unfinished SerializeBits byte are not part of the view until the next byte-level write.
+	 * @note The view is invalidated by any later write.
+	 *
+	 * @return View of the serialized bytes.
+	 */
+	TArrayView<const uint8> GetBytesView() const { return Bytes; }
+
+	/**
+	 * @brief Takes the serialized bytes out of the object without copying them.
+	 *
+	 * Finishes the stream, the next write starts a new one.
+	 *
+	 * @return The serialized bytes.
+	 */
+	TArray<uint8> MoveBytesOut();
+
 	/**
 	 * @brief Appends input bytes to the current serialized data.
+	 *
+	 * The bytes are written at the writer position, so later writes follow them.
 	 * 
 	 * @param InBytes The array of bytes to append.
 	 */
@@ -84,6 +150,48 @@ public:
 	UFUNCTION(BlueprintCallable, Category="USerializerObject")
 	virtual void Prepare();
 
+	/**
+	 * @brief Prepares the serializer for writing new data, keeping the allocated capacity.
+	 *
+	 * Same as Prepare() but the Bytes allocation is reused, use it when the object serializes every frame.
+	 */
+	UFUNCTION(BlueprintCallable, Category="USerializerObject")
+	virtual void Reset();
+
+	/**
+	 * @brief Grows the capacity of the serialized data, so the next writes do not reallocate.
+	 *
+	 * @param InNumBytes Total number of bytes to make room for.
+	 */
+	UFUNCTION(BlueprintCallable, Category="USerializerObject")
+	virtual void Reserve(UPARAM(DisplayName="Num Bytes") int32 InNumBytes);
+
+	/**
+	 * @brief Selects how integers and byte counts are written.
+	 *
+	 * VarInt writes LEB128 varints (zigzag for signed values), small values take 1-2 bytes instead of 4/8.
+	 * @note Clears the current data and prepares the writer, the encoding is recorded in the stream.
+	 *
+	 * @param InEncoding The encoding.
+	 */
+	UFUNCTION(BlueprintCallable, Category="USerializerObject")
+	virtual void SetIntEncoding(EDataSerializerIntEncoding InEncoding);
+
+	/**
+	 * @brief Gets the encoding of integers and byte counts.
+	 */
+	UFUNCTION(BlueprintPure, Category="USerializerObject")
+	EDataSerializerIntEncoding GetIntEncoding() const { return IntEncoding; }
+
+	/**
+	 * @brief Selects whether SerializeBool writes single bits instead of 4 byte values.
+	 * @note Clears the current data and prepares the writer, the mode is recorded in the stream.
+	 *
+	 * @param bInPackBools Pack booleans into bits.
+	 */
+	UFUNCTION(BlueprintCallable, Category="USerializerObject")
+	virtual void SetPackBools(bool bInPackBools);
+
 public:
 	
 	/**
@@ -126,6 +234,19 @@ public:
 	UFUNCTION(BlueprintCallable, Category="USerializerObject|Serialization")
 	virtual void SerializeBool(UPARAM(DisplayName="Value") bool InBool);
 
+	/**
+	 * @brief Serializes the lowest bits of a value, for small enums, ranges and flags.
+	 *
+	 * Consecutive bit writes share bytes. The next byte-level write starts on a new byte,
+	 * so bit and byte fields can be mixed freely as long as the reader calls TryReadBits in the same order.
+	 *
+	 * @param InValue The value, only the lowest InNumBits bits are written.
+	 * @param InNumBits Number of bits, 1 to 32.
+	 */
+	UFUNCTION(BlueprintCallable, Category="USerializerObject|Serialization")
+	virtual void SerializeBits(UPARAM(DisplayName="Value") int32 InValue,
+	                           UPARAM(DisplayName="Num Bits") int32 InNumBits);
+
 	/**
 	 * @brief Serializes a single byte.
 	 * 
@@ -182,6 +303,142 @@ public:
 	UFUNCTION(BlueprintCallable, Category="USerializerObject|Serialization")
 	virtual void SerializeTransform(UPARAM(DisplayName="Value") FTransform InTransform);
 
+	/**
+	 * @brief Serializes a 3D vector as fixed-point values.
+	 *
+	 * Each component is rounded to a multiple of InPrecision and clamped to [-InRange, InRange].
+	 * The components take 1 to 4 bytes depending on InRange / InPrecision (4 with the defaults).
+	 * InRange / InPrecision must not exceed MAX_int32, larger ranges are clamped to MAX_int32 * InPrecision.
+	 * Read it with UDeSerializerObject::TryReadVectorQuantized and the same parameters.
+	 *
+	 * @param InVector The FVector to serialize.
+	 * @param InPrecision Quantization step.
+	 * @param InRange Largest absolute component value.
+	 */
+	UFUNCTION(BlueprintCallable, Category="USerializerObject|Serialization|Quantized")
+	virtual void SerializeVectorQuantized(UPARAM(DisplayName="Value") FVector InVector,
+	                                      UPARAM(DisplayName="Precision") double InPrecision = 0.01,
+	                                      UPARAM(DisplayName="Range") double InRange = 1048576.0);
+
+	/**
+	 * @brief Serializes a rotation as three 16-bit angles (6 bytes).
+	 *
+	 * @param InRotator The FRotator to serialize.
+	 */
+	UFUNCTION(BlueprintCallable, Category="USerializerObject|Serialization|Quantized")
+	virtual void SerializeRotatorCompressed(UPARAM(DisplayName="Value") FRotator InRotator);
+
+	/**
+	 * @brief Serializes a transform with a quantized rotation, translation and scale.
+	 *
+	 * The rotation is stored as a smallest-three quaternion (6 bytes), the translation as a quantized vector,
+	 * unit and uniform scales take one byte (plus one value). About 19 bytes with the defaults instead of 80.
+	 * Read it with UDeSerializerObject::TryReadTransformQuantized and the same parameters.
+	 *
+	 * @param InTransform The FTransform to serialize.
+	 * @param InTranslationPrecision Quantization step of the translation.
+	 * @param InTranslationRange Largest absolute translation component.
+	 * @param InScalePrecision Quantization step of the scale.
+	 * @param InScaleRange Largest absolute scale component.
+	 */
+	UFUNCTION(BlueprintCallable, Category="USerializerObject|Serialization|Quantized")
+	virtual void SerializeTransformQuantized(UPARAM(DisplayName="Value") FTransform InTransform,
+	                                         UPARAM(DisplayName="Translation Precision") double InTranslationPrecision = 0.01,
+	                                         UPARAM(DisplayName="Translation Range") double InTranslationRange = 1048576.0,
+	                                         UPARAM(DisplayName="Scale Precision") double InScalePrecision = 0.001,
+	                                         UPARAM(DisplayName="Scale Range") double InScaleRange = 100.0);
+
+	/**
+	 * @brief Serializes an array of 32-bit integers.
+	 *
+	 * Writes the length followed by the elements in one bulk copy.
+	 *
+	 * @param InIntegers The array to serialize.
+	 */
+	UFUNCTION(BlueprintCallable, Category="USerializerObject|Serialization|Arrays")
+	virtual void SerializeIntArray(UPARAM(DisplayName="Value") const TArray<int32>& InIntegers);
+
+	/**
+	 * @brief Serializes an array of 64-bit integers.
+	 *
+	 * Writes the length followed by the elements in one bulk copy.
+	 *
+	 * @param InBigInts The array to serialize.
+	 */
+	UFUNCTION(BlueprintCallable, Category="USerializerObject|Serialization|Arrays")
+	virtual void SerializeBigIntArray(UPARAM(DisplayName="Value") const TArray<int64>& InBigInts);
+
+	/**
+	 * @brief Serializes an array of floating-point numbers.
+	 *
+	 * Writes the length followed by the elements in one bulk copy.
+	 *
+	 * @param InFloats The array to serialize.
+	 */
+	UFUNCTION(BlueprintCallable, Category="USerializerObject|Serialization|Arrays")
+	virtual void SerializeFloatArray(UPARAM(DisplayName="Value") const TArray<float>& InFloats);
+
+	/**
+	 * @brief Serializes an array of double-precision floating-point numbers.
+	 *
+	 * Writes the length followed by the elements in one bulk copy.
+	 *
+	 * @param InDoubles The array to serialize.
+	 */
+	UFUNCTION(BlueprintCallable, Category="USerializerObject|Serialization|Arrays")
+	virtual void SerializeDoubleArray(UPARAM(DisplayName="Value") const TArray<double>& InDoubles);
+
+	/**
+	 * @brief Serializes an array of bytes.
+	 *
+	 * Writes the length followed by the elements in one bulk copy.
+	 *
+	 * @param InBytes The array to serialize.
+	 */
+	UFUNCTION(BlueprintCallable, Category="USerializerObject|Serialization|Arrays")
+	virtual void SerializeByteArray(UPARAM(DisplayName="Value") const TArray<uint8>& InBytes);
+
+	/**
+	 * @brief Serializes an array of 3D vectors (FVector).
+	 *
+	 * Writes the length followed by the elements in one bulk copy.
+	 *
+	 * @param InVectors The array to serialize.
+	 */
+	UFUNCTION(BlueprintCallable, Category="USerializerObject|Serialization|Arrays")
+	virtual void SerializeVectorArray(UPARAM(DisplayName="Value") const TArray<FVector>& InVectors);
+
+	/**
+	 * @brief Serializes an array of 2D vectors (FVector2D).
+	 *
+	 * Writes the length followed by the elements in one bulk copy.
+	 *
+	 * @param InVectors The array to serialize.
+	 */
+	UFUNCTION(BlueprintCallable, Category="USerializerObject|Serialization|Arrays")
+	virtual void SerializeVector2DArray(UPARAM(DisplayName="Value") const TArray<FVector2D>& InVectors);
+
+	/**
+	 * @brief Serializes an array of rotations (FRotator).
+	 *
+	 * Writes the length followed by the elements in one bulk copy.
+	 *
+	 * @param InRotators The array to serialize.
+	 */
+	UFUNCTION(BlueprintCallable, Category="USerializerObject|Serialization|Arrays")
+	virtual void SerializeRotatorArray(UPARAM(DisplayName="Value") const TArray<FRotator>& InRotators);
+
+	/**
+	 * @brief Serializes an array of transforms (FTransform).
+	 *
+	 * Writes the length followed by the elements in one bulk copy.
+	 * Elements are staged into a contiguous buffer of doubles, then written in one copy.
+	 *
+	 * @param InTransforms The array to serialize.
+	 */
+	UFUNCTION(BlueprintCallable, Category="USerializerObject|Serialization|Arrays")
+	virtual void SerializeTransformArray(UPARAM(DisplayName="Value") const TArray<FTransform>& InTransforms);
+
 	/**
 	* @brief Serializes a string (FString).
 	* 
@@ -205,4 +462,55 @@ public:
 	*/
 	UFUNCTION(BlueprintCallable, Category="USerializerObject|Serialization")
 	virtual void SerializeObjects(UPARAM(DisplayName="Value") const TArray<UObject*>& InObjects);
+
+	/**
+	* @brief Serializes a value of any reflected type, read back with UDeSerializerObject::TryReadProperty.
+	*
+	* Plain old data is copied as is, containers write their elements one by one (plain old data arrays
+	* in one block), other values go through tagged serialization. The type is checked when reading.
+	*
+	* @param InProperty The property describing the value.
+	* @param InValue Address of the value.
+	*/
+	void SerializeProperty(const FProperty* InProperty, const void* InValue);
+
+	/**
+	* @brief Serializes a struct of any type through reflection, without wrapping it in an object.
+	*
+	* @param InValue The struct to serialize.
+	*/
+	UFUNCTION(BlueprintCallable, CustomThunk, Category="USerializerObject|Serialization|Containers",
+		meta=(CustomStructureParam="InValue"))
+	void SerializeStruct(UPARAM(DisplayName="Value") const int32& InValue);
+	DECLARE_FUNCTION(execSerializeStruct);
+
+	/**
+	* @brief Serializes an array of any element type through reflection.
+	*
+	* @param InValue The array to serialize.
+	*/
+	UFUNCTION(BlueprintCallable, CustomThunk, Category="USerializerObject|Serialization|Containers",
+		meta=(ArrayParm="InValue"))
+	void SerializeArray(UPARAM(DisplayName="Value") const TArray<int32>& InValue);
+	DECLARE_FUNCTION(execSerializeArray);
+
+	/**
+	* @brief Serializes a map of any key and value types through reflection.
+	*
+	* @param InValue The map to serialize.
+	*/
+	UFUNCTION(BlueprintCallable, CustomThunk, Category="USerializerObject|Serialization|Containers",
+		meta=(MapParam="InValue"))
+	void SerializeMap(UPARAM(DisplayName="Value") const TMap<int32, int32>& InValue);
+	DECLARE_FUNCTION(execSerializeMap);
+
+	/**
+	* @brief Serializes a set of any element type through reflection.
+	*
+	* @param InValue The set to serialize.
+	*/
+	UFUNCTION(BlueprintCallable, CustomThunk, Category="USerializerObject|Serialization|Containers",
+		meta=(SetParam="InValue"))
+	void SerializeSet(UPARAM(DisplayName="Value") const TSet<int32>& InValue);
+	DECLARE_FUNCTION(execSerializeSet);
 };
@@ -0,0 +1,6 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Modules/ModuleManager.h"
+
+// Editor only: the automation specs and the benchmark commandlet of the DataSerializer module
+IMPLEMENT_MODULE(FDefaultModuleImpl, DataSerializerTests)
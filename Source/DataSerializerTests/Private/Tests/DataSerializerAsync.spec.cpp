@@ -0,0 +1,110 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HAL/FileManager.h"
+#include "Libs/DataSerializerLib.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+#include "Utils/DataSerializerAsync.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+BEGIN_DEFINE_SPEC(FDataSerializerAsyncSpec, "DataSerializer.Async",
+                  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+	FString FilePath;
+
+	/** Bytes that compress well and span more than one compression block. */
+	static TArray<uint8> CreateBytes(uint8 InSeed);
+
+END_DEFINE_SPEC(FDataSerializerAsyncSpec)
+
+TArray<uint8> FDataSerializerAsyncSpec::CreateBytes(uint8 InSeed)
+{
+	TArray<uint8> bytes;
+	bytes.SetNumUninitialized(XEUS_COMPRESSION_CHUNK_SIZE + 1000);
+	for (int32 i = 0; i < bytes.Num(); ++i)
+	{
+		bytes[i] = static_cast<uint8>((i / 5 + InSeed) % 61);
+	}
+	return bytes;
+}
+
+void FDataSerializerAsyncSpec::Define()
+{
+	BeforeEach([this]()
+	{
+		FilePath = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("DataSerializerAsyncSpec.sav"));
+	});
+
+	AfterEach([this]()
+	{
+		FDataSerializerAsyncIO::Flush();
+		IFileManager::Get().Delete(*FilePath, false, true, true);
+	});
+
+	It("should read back what was written, compressed or not", [this]()
+	{
+		for (const bool bCompressed : {false, true})
+		{
+			const TArray<uint8> bytes = CreateBytes(bCompressed ? 1 : 2);
+			FDataSerializerAsyncHandle write = FDataSerializerAsyncIO::WriteBytesToDisk(bytes, FilePath, bCompressed);
+			TestTrue(TEXT("Valid handle"), write.IsValid());
+			TestTrue(TEXT("Written"), write.GetFuture().Get()->bSuccess);
+			TestTrue(TEXT("Done"), write.IsDone());
+
+			FDataSerializerAsyncHandle read = FDataSerializerAsyncIO::ReadBytesFromDisk(FilePath, bCompressed);
+			const FDataSerializerAsyncResultRef result = read.GetFuture().Get();
+			TestTrue(TEXT("Read"), result->bSuccess);
+			TestTrue(TEXT("Same bytes"), result->Bytes == bytes);
+		}
+	});
+
+	It("should leave the latest payload on disk when writes to the same path are queued", [this]()
+	{
+		const TArray<uint8> latest = CreateBytes(3);
+		FDataSerializerAsyncIO::WriteBytesToDisk(CreateBytes(4), FilePath, true);
+		FDataSerializerAsyncIO::WriteBytesToDisk(CreateBytes(5), FilePath, true);
+		FDataSerializerAsyncHandle last = FDataSerializerAsyncIO::WriteBytesToDisk(latest, FilePath, true);
+		FDataSerializerAsyncIO::Flush();
+		TestTrue(TEXT("Written"), last.GetFuture().Get()->bSuccess);
+
+		TArray<uint8> bytes;
+		TestTrue(TEXT("Read"), UDataSerializerLib::ReadCompressedBytesFromDisk(bytes, FilePath));
+		TestTrue(TEXT("Latest bytes"), bytes == latest);
+	});
+
+	It("should share the result between readers of the same file", [this]()
+	{
+		const TArray<uint8> bytes = CreateBytes(6);
+		TestTrue(TEXT("Written"), UDataSerializerLib::WriteBytesToDiskCompressed(bytes, FilePath));
+
+		FDataSerializerAsyncHandle first = FDataSerializerAsyncIO::ReadBytesFromDisk(FilePath, true);
+		FDataSerializerAsyncHandle second = FDataSerializerAsyncIO::ReadBytesFromDisk(FilePath, true);
+		const FDataSerializerAsyncResultRef firstResult = first.GetFuture().Get();
+		const FDataSerializerAsyncResultRef secondResult = second.GetFuture().Get();
+		TestTrue(TEXT("First read"), firstResult->bSuccess && firstResult->Bytes == bytes);
+		TestTrue(TEXT("Second read"), secondResult->bSuccess && secondResult->Bytes == bytes);
+	});
+
+	It("should complete a cancelled handle", [this]()
+	{
+		FDataSerializerAsyncHandle write = FDataSerializerAsyncIO::WriteBytesToDisk(CreateBytes(7), FilePath, true);
+		write.Cancel();
+		TestTrue(TEXT("Done"), write.IsDone());
+
+		// The write may have finished before the cancellation, it is reported as cancelled otherwise
+		const FDataSerializerAsyncResultRef result = write.GetFuture().Get();
+		TestTrue(TEXT("Cancelled or written"), result->bCancelled || result->bSuccess);
+	});
+
+	It("should report a failed read of a missing file", [this]()
+	{
+		FDataSerializerAsyncHandle read = FDataSerializerAsyncIO::ReadBytesFromDisk(FilePath, true);
+		const FDataSerializerAsyncResultRef result = read.GetFuture().Get();
+		TestFalse(TEXT("Read"), result->bSuccess);
+		TestFalse(TEXT("Not cancelled"), result->bCancelled);
+	});
+}
+
+#endif
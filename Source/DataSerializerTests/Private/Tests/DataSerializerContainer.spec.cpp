@@ -0,0 +1,281 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DataSerializerFaultPlatformFile.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Utils/DataSerializerContainer.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+BEGIN_DEFINE_SPEC(FDataSerializerContainerSpec, "DataSerializer.Container",
+                  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+	FString FilePath;
+
+	/** Blob data that differs per seed. */
+	static TArray<uint8> CreateBytes(uint8 InSeed, int32 InSize = 1000);
+
+	/** Checks that a container holds exactly the given blobs. */
+	void TestBlobs(const TSharedPtr<FDataSerializerContainer, ESPMode::ThreadSafe>& InContainer,
+	               const TMap<FString, TArray<uint8>>& InExpected);
+
+END_DEFINE_SPEC(FDataSerializerContainerSpec)
+
+TArray<uint8> FDataSerializerContainerSpec::CreateBytes(uint8 InSeed, int32 InSize)
+{
+	TArray<uint8> bytes;
+	bytes.SetNumUninitialized(InSize);
+	for (int32 i = 0; i < bytes.Num(); ++i)
+	{
+		bytes[i] = static_cast<uint8>(i * 13 + InSeed);
+	}
+	return bytes;
+}
+
+void FDataSerializerContainerSpec::TestBlobs(const TSharedPtr<FDataSerializerContainer, ESPMode::ThreadSafe>& InContainer,
+                                             const TMap<FString, TArray<uint8>>& InExpected)
+{
+	TestEqual(TEXT("Blob count"), InContainer->Num(), InExpected.Num());
+
+	TArray<FString> keys;
+	InExpected.GetKeys(keys);
+	TArray<TArray<uint8>> blobs;
+	TestTrue(TEXT("Read many"), InContainer->ReadMany(keys, blobs));
+	for (int32 i = 0; i < keys.Num(); ++i)
+	{
+		TestTrue(FString::Printf(TEXT("Same bytes %s"), *keys[i]), blobs[i] == InExpected[keys[i]]);
+	}
+}
+
+void FDataSerializerContainerSpec::Define()
+{
+	BeforeEach([this]()
+	{
+		FilePath = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("DataSerializerContainerSpec.pack"));
+	});
+
+	AfterEach([this]()
+	{
+		IFileManager::Get().Delete(*FilePath, false, true, true);
+		IFileManager::Get().Delete(*(FilePath + TEXT(".repack")), false, true, true);
+	});
+
+	It("should read back the blobs after reopening", [this]()
+	{
+		TMap<FString, TArray<uint8>> expected;
+		{
+			TSharedPtr<FDataSerializerContainer, ESPMode::ThreadSafe> container = FDataSerializerContainer::Open(FilePath);
+			TestTrue(TEXT("Opened"), container.IsValid());
+
+			TArray<FString> keys;
+			TArray<TArray<uint8>> blobs;
+			for (int32 i = 0; i < 50; ++i)
+			{
+				keys.Add(FString::Printf(TEXT("blob%d"), i));
+				blobs.Add(CreateBytes(static_cast<uint8>(i), 100 + i * 37));
+				expected.Add(keys.Last(), blobs.Last());
+			}
+
+			// The last blob of a key in a batch wins
+			keys.Add(TEXT("blob0"));
+			blobs.Add(CreateBytes(200));
+			expected.Add(TEXT("blob0"), blobs.Last());
+			TestTrue(TEXT("Written"), container->WriteMany(keys, blobs));
+			TestTrue(TEXT("Empty blob"), container->Write(TEXT("empty"), TArray<uint8>()));
+			expected.Add(TEXT("empty"), TArray<uint8>());
+			TestBlobs(container, expected);
+
+			TArray<uint8> bytes;
+			TestFalse(TEXT("Missing blob"), container->Read(TEXT("missing"), bytes));
+		}
+
+		TSharedPtr<FDataSerializerContainer, ESPMode::ThreadSafe> container = FDataSerializerContainer::Open(FilePath);
+		TestTrue(TEXT("Reopened"), container.IsValid());
+		TestBlobs(container, expected);
+	});
+
+	It("should reuse released slots", [this]()
+	{
+		TSharedPtr<FDataSerializerContainer, ESPMode::ThreadSafe> container = FDataSerializerContainer::Open(FilePath);
+		container->Write(TEXT("a"), CreateBytes(1));
+		container->Write(TEXT("b"), CreateBytes(2));
+
+		// A rewrite goes to a new slot, the next one lands in the slot the first rewrite released
+		container->Write(TEXT("a"), CreateBytes(3));
+		const int64 size = IFileManager::Get().FileSize(*FilePath);
+		container->Write(TEXT("a"), CreateBytes(4));
+		TestEqual(TEXT("Rewrite in released slot"), IFileManager::Get().FileSize(*FilePath), size);
+
+		TestTrue(TEXT("Removed"), container->Remove(TEXT("b")));
+		TestFalse(TEXT("Removed twice"), container->Remove(TEXT("b")));
+		container->Write(TEXT("c"), CreateBytes(5, 900));
+		TestEqual(TEXT("Write in removed slot"), IFileManager::Get().FileSize(*FilePath), size);
+
+		TestBlobs(container, {{TEXT("a"), CreateBytes(4)}, {TEXT("c"), CreateBytes(5, 900)}});
+	});
+
+	It("should keep the previous blob when a rewrite fails", [this]()
+	{
+		{
+			// Installed first, the container opens its file through it and is closed before it goes away
+			FDataSerializerFaultPlatformFile fault;
+			TSharedPtr<FDataSerializerContainer, ESPMode::ThreadSafe> container = FDataSerializerContainer::Open(FilePath);
+			TestTrue(TEXT("Write a"), container->Write(TEXT("a"), CreateBytes(1)));
+			const int64 freeBytes = container->GetFreeBytes();
+
+			// Torn blob write
+			fault.FailWritesAfter(100);
+			TestFalse(TEXT("Blob write fails"), container->Write(TEXT("a"), CreateBytes(2)));
+			fault.Disarm();
+			TestBlobs(container, {{TEXT("a"), CreateBytes(1)}});
+			TestEqual(TEXT("Free bytes restored"), container->GetFreeBytes(), freeBytes);
+
+			// The blob is written, the index is not
+			fault.FailWritesAfter(1000);
+			TestFalse(TEXT("Index write fails"), container->Write(TEXT("a"), CreateBytes(3)));
+			fault.Disarm();
+			TestBlobs(container, {{TEXT("a"), CreateBytes(1)}});
+
+			fault.FailWritesAfter(0);
+			TestFalse(TEXT("Remove fails"), container->Remove(TEXT("a")));
+			fault.Disarm();
+			TestBlobs(container, {{TEXT("a"), CreateBytes(1)}});
+
+			TestTrue(TEXT("Write b"), container->Write(TEXT("b"), CreateBytes(4)));
+			TestBlobs(container, {{TEXT("a"), CreateBytes(1)}, {TEXT("b"), CreateBytes(4)}});
+		}
+
+		TSharedPtr<FDataSerializerContainer, ESPMode::ThreadSafe> container = FDataSerializerContainer::Open(FilePath);
+		TestTrue(TEXT("Reopened"), container.IsValid());
+		TestBlobs(container, {{TEXT("a"), CreateBytes(1)}, {TEXT("b"), CreateBytes(4)}});
+	});
+
+	It("should drop the free space when repacking", [this]()
+	{
+		TMap<FString, TArray<uint8>> expected;
+		{
+			TSharedPtr<FDataSerializerContainer, ESPMode::ThreadSafe> container = FDataSerializerContainer::Open(FilePath);
+			TArray<FString> removed;
+			for (int32 i = 0; i < 20; ++i)
+			{
+				const FString key = FString::Printf(TEXT("blob%d"), i);
+				container->Write(key, CreateBytes(static_cast<uint8>(i), 2000));
+				if (i % 2 == 0)
+				{
+					removed.Add(key);
+				}
+				else
+				{
+					expected.Add(key, CreateBytes(static_cast<uint8>(i), 2000));
+				}
+			}
+			TestTrue(TEXT("Removed"), container->RemoveMany(removed));
+			const int64 size = IFileManager::Get().FileSize(*FilePath);
+			const int64 freeBytes = container->GetFreeBytes();
+
+			TestTrue(TEXT("Repacked"), container->Repack());
+			TestTrue(TEXT("Less free space"), container->GetFreeBytes() < freeBytes);
+			TestTrue(TEXT("Smaller file"), IFileManager::Get().FileSize(*FilePath) < size);
+			TestFalse(TEXT("No repacked file left"), IFileManager::Get().FileExists(*(FilePath + TEXT(".repack"))));
+			TestBlobs(container, expected);
+
+			TestTrue(TEXT("Write after repack"), container->Write(TEXT("new"), CreateBytes(100)));
+			expected.Add(TEXT("new"), CreateBytes(100));
+		}
+
+		TSharedPtr<FDataSerializerContainer, ESPMode::ThreadSafe> container = FDataSerializerContainer::Open(FilePath);
+		TestBlobs(container, expected);
+	});
+
+	It("should recover a repacked file that did not replace the container", [this]()
+	{
+		const FString tempPath = FilePath + TEXT(".repack");
+		{
+			TSharedPtr<FDataSerializerContainer, ESPMode::ThreadSafe> container = FDataSerializerContainer::Open(FilePath);
+			container->Write(TEXT("a"), CreateBytes(1));
+		}
+
+		// Crash after the container was deleted, before the repacked file was moved
+		TestTrue(TEXT("Moved"), IFileManager::Get().Move(*tempPath, *FilePath));
+
+		TSharedPtr<FDataSerializerContainer, ESPMode::ThreadSafe> container = FDataSerializerContainer::Open(FilePath, false);
+		TestTrue(TEXT("Opened"), container.IsValid());
+		TestBlobs(container, {{TEXT("a"), CreateBytes(1)}});
+		TestFalse(TEXT("Repacked file consumed"), IFileManager::Get().FileExists(*tempPath));
+	});
+
+	It("should drop a partial repacked file next to an intact container", [this]()
+	{
+		const FString tempPath = FilePath + TEXT(".repack");
+		{
+			TSharedPtr<FDataSerializerContainer, ESPMode::ThreadSafe> container = FDataSerializerContainer::Open(FilePath);
+			container->Write(TEXT("a"), CreateBytes(1));
+		}
+
+		// Crash while the repacked file was written
+		const TArray<uint8> partial = {0x70, 0x75};
+		FFileHelper::SaveArrayToFile(partial, *tempPath);
+
+		TSharedPtr<FDataSerializerContainer, ESPMode::ThreadSafe> container = FDataSerializerContainer::Open(FilePath);
+		TestTrue(TEXT("Opened"), container.IsValid());
+		TestBlobs(container, {{TEXT("a"), CreateBytes(1)}});
+		TestFalse(TEXT("Repacked file deleted"), IFileManager::Get().FileExists(*tempPath));
+	});
+
+	It("should not open truncated or corrupt containers", [this]()
+	{
+		{
+			TSharedPtr<FDataSerializerContainer, ESPMode::ThreadSafe> container = FDataSerializerContainer::Open(FilePath);
+			container->Write(TEXT("a"), CreateBytes(1));
+		}
+		TArray<uint8> file;
+		FFileHelper::LoadFileToArray(file, *FilePath);
+
+		TArray<uint8> truncated(file.GetData(), 20);
+		FFileHelper::SaveArrayToFile(truncated, *FilePath);
+		TestFalse(TEXT("Truncated header"), FDataSerializerContainer::Open(FilePath).IsValid());
+
+		// The index follows the 32 bytes of the header
+		TArray<uint8> corruptIndex = file;
+		corruptIndex[40] ^= 0xFF;
+		FFileHelper::SaveArrayToFile(corruptIndex, *FilePath);
+		TestFalse(TEXT("Corrupt index"), FDataSerializerContainer::Open(FilePath).IsValid());
+
+		TArray<uint8> otherFile = file;
+		otherFile[0] ^= 0xFF;
+		FFileHelper::SaveArrayToFile(otherFile, *FilePath);
+		TestFalse(TEXT("Other tag"), FDataSerializerContainer::Open(FilePath).IsValid());
+	});
+
+	It("should fail to read a corrupt blob", [this]()
+	{
+		{
+			TSharedPtr<FDataSerializerContainer, ESPMode::ThreadSafe> container = FDataSerializerContainer::Open(FilePath);
+			container->Write(TEXT("a"), CreateBytes(1));
+			container->Write(TEXT("b"), CreateBytes(2));
+		}
+
+		// The last blob ends the file
+		TArray<uint8> file;
+		FFileHelper::LoadFileToArray(file, *FilePath);
+		file.Last() ^= 0xFF;
+		FFileHelper::SaveArrayToFile(file, *FilePath);
+
+		TSharedPtr<FDataSerializerContainer, ESPMode::ThreadSafe> container = FDataSerializerContainer::Open(FilePath);
+		TestTrue(TEXT("Opened"), container.IsValid());
+		TArray<uint8> bytes;
+		TestTrue(TEXT("Intact blob"), container->Read(TEXT("a"), bytes) && bytes == CreateBytes(1));
+		TestFalse(TEXT("Corrupt blob"), container->Read(TEXT("b"), bytes));
+	});
+
+	It("should not create the file when asked not to", [this]()
+	{
+		TestFalse(TEXT("Not opened"), FDataSerializerContainer::Open(FilePath, false).IsValid());
+		TestFalse(TEXT("Not created"), IFileManager::Get().FileExists(*FilePath));
+	});
+}
+
+#endif
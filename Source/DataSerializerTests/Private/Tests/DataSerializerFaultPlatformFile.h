@@ -0,0 +1,147 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformFileManager.h"
+
+#include <atomic>
+
+/**
+ * @class FDataSerializerFaultPlatformFile
+ * @brief Platform file layer that makes writes fail, installed for the lifetime of the object.
+ *
+ * Every file opened for writing goes through it, also files opened before FailWritesAfter is called.
+ * Once armed, writes go through until the given number of bytes, then the write that crosses it
+ * writes its first part and fails, like a full disk or a crash in the middle of a save.
+ */
+class FDataSerializerFaultPlatformFile : public IPlatformFile
+{
+public:
+	FDataSerializerFaultPlatformFile()
+		: Lower(&FPlatformFileManager::Get().GetPlatformFile())
+	{
+		FPlatformFileManager::Get().SetPlatformFile(*this);
+	}
+
+	virtual ~FDataSerializerFaultPlatformFile() override
+	{
+		FPlatformFileManager::Get().SetPlatformFile(*Lower);
+	}
+
+	/**
+	 * Makes writes fail.
+	 * @param InBytes Bytes that are still written, the write crossing this count fails.
+	 */
+	void FailWritesAfter(int64 InBytes) { Budget = InBytes; }
+
+	/** Lets writes go through again. */
+	void Disarm() { Budget = -1; }
+
+	virtual bool Initialize(IPlatformFile* Inner, const TCHAR* CmdLine) override { return true; }
+	virtual IPlatformFile* GetLowerLevel() override { return Lower; }
+	virtual void SetLowerLevel(IPlatformFile* NewLowerLevel) override { Lower = NewLowerLevel; }
+	virtual const TCHAR* GetName() const override { return TEXT("DataSerializerFault"); }
+
+	virtual bool FileExists(const TCHAR* Filename) override { return Lower->FileExists(Filename); }
+	virtual int64 FileSize(const TCHAR* Filename) override { return Lower->FileSize(Filename); }
+	virtual bool DeleteFile(const TCHAR* Filename) override { return Lower->DeleteFile(Filename); }
+	virtual bool IsReadOnly(const TCHAR* Filename) override { return Lower->IsReadOnly(Filename); }
+	virtual bool MoveFile(const TCHAR* To, const TCHAR* From) override { return Lower->MoveFile(To, From); }
+	virtual bool SetReadOnly(const TCHAR* Filename, bool bNewReadOnlyValue) override
+	{
+		return Lower->SetReadOnly(Filename, bNewReadOnlyValue);
+	}
+	virtual FDateTime GetTimeStamp(const TCHAR* Filename) override { return Lower->GetTimeStamp(Filename); }
+	virtual void SetTimeStamp(const TCHAR* Filename, FDateTime DateTime) override
+	{
+		Lower->SetTimeStamp(Filename, DateTime);
+	}
+	virtual FDateTime GetAccessTimeStamp(const TCHAR* Filename) override
+	{
+		return Lower->GetAccessTimeStamp(Filename);
+	}
+	virtual FString GetFilenameOnDisk(const TCHAR* Filename) override { return Lower->GetFilenameOnDisk(Filename); }
+
+	virtual IFileHandle* OpenRead(const TCHAR* Filename, bool bAllowWrite = false) override
+	{
+		return Lower->OpenRead(Filename, bAllowWrite);
+	}
+
+	virtual IFileHandle* OpenWrite(const TCHAR* Filename, bool bAppend = false, bool bAllowRead = false) override
+	{
+		IFileHandle* handle = Lower->OpenWrite(Filename, bAppend, bAllowRead);
+		return handle != nullptr ? new FFaultFileHandle(handle, Budget) : nullptr;
+	}
+
+	virtual bool DirectoryExists(const TCHAR* Directory) override { return Lower->DirectoryExists(Directory); }
+	virtual bool CreateDirectory(const TCHAR* Directory) override { return Lower->CreateDirectory(Directory); }
+	virtual bool DeleteDirectory(const TCHAR* Directory) override { return Lower->DeleteDirectory(Directory); }
+	virtual FFileStatData GetStatData(const TCHAR* FilenameOrDirectory) override
+	{
+		return Lower->GetStatData(FilenameOrDirectory);
+	}
+	virtual bool IterateDirectory(const TCHAR* Directory, FDirectoryVisitor& Visitor) override
+	{
+		return Lower->IterateDirectory(Directory, Visitor);
+	}
+	virtual bool IterateDirectoryStat(const TCHAR* Directory, FDirectoryStatVisitor& Visitor) override
+	{
+		return Lower->IterateDirectoryStat(Directory, Visitor);
+	}
+
+private:
+	/** Forwards to a real handle, writes fail once the shared budget runs out. */
+	class FFaultFileHandle : public IFileHandle
+	{
+	public:
+		FFaultFileHandle(IFileHandle* InHandle, std::atomic<int64>& InBudget)
+			: Handle(InHandle), Budget(InBudget)
+		{
+		}
+
+		virtual int64 Tell() override { return Handle->Tell(); }
+		virtual bool Seek(int64 NewPosition) override { return Handle->Seek(NewPosition); }
+		virtual bool SeekFromEnd(int64 NewPositionRelativeToEnd = 0) override
+		{
+			return Handle->SeekFromEnd(NewPositionRelativeToEnd);
+		}
+		virtual bool Read(uint8* Destination, int64 BytesToRead) override
+		{
+			return Handle->Read(Destination, BytesToRead);
+		}
+		virtual bool Flush(const bool bFullFlush = false) override { return Handle->Flush(bFullFlush); }
+		virtual bool Truncate(int64 NewSize) override { return Handle->Truncate(NewSize); }
+		virtual int64 Size() override { return Handle->Size(); }
+
+		virtual bool Write(const uint8* Source, int64 BytesToWrite) override
+		{
+			const int64 budget = Budget;
+			if (budget < 0)
+				return Handle->Write(Source, BytesToWrite);
+			if (BytesToWrite <= budget)
+			{
+				Budget = budget - BytesToWrite;
+				return Handle->Write(Source, BytesToWrite);
+			}
+
+			// The first part reaches the disk, the rest is lost
+			Budget = 0;
+			if (budget > 0)
+			{
+				Handle->Write(Source, budget);
+			}
+			Handle->Flush();
+			return false;
+		}
+
+	private:
+		TUniquePtr<IFileHandle> Handle;
+		std::atomic<int64>& Budget;
+	};
+
+	IPlatformFile* Lower;
+
+	/** Bytes that can still be written, negative when writes are not failing. */
+	std::atomic<int64> Budget{-1};
+};
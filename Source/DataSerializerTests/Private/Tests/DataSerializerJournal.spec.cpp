@@ -0,0 +1,262 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DataSerializerFaultPlatformFile.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Utils/DataSerializerJournal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+BEGIN_DEFINE_SPEC(FDataSerializerJournalSpec, "DataSerializer.Journal",
+                  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+	FString FilePath;
+
+	/** Record data that differs per seed. */
+	static TArray<uint8> CreateBytes(uint8 InSeed, int32 InSize = 100);
+
+	/** Checks that a journal holds exactly the given records. */
+	void TestRecords(const TSharedPtr<FDataSerializerJournal, ESPMode::ThreadSafe>& InJournal,
+	                 const TMap<FString, TArray<uint8>>& InExpected);
+
+END_DEFINE_SPEC(FDataSerializerJournalSpec)
+
+TArray<uint8> FDataSerializerJournalSpec::CreateBytes(uint8 InSeed, int32 InSize)
+{
+	TArray<uint8> bytes;
+	bytes.SetNumUninitialized(InSize);
+	for (int32 i = 0; i < bytes.Num(); ++i)
+	{
+		bytes[i] = static_cast<uint8>(i * 7 + InSeed);
+	}
+	return bytes;
+}
+
+void FDataSerializerJournalSpec::TestRecords(const TSharedPtr<FDataSerializerJournal, ESPMode::ThreadSafe>& InJournal,
+                                             const TMap<FString, TArray<uint8>>& InExpected)
+{
+	TestEqual(TEXT("Key count"), InJournal->GetKeys().Num(), InExpected.Num());
+	for (const TPair<FString, TArray<uint8>>& pair : InExpected)
+	{
+		TArray<uint8> bytes;
+		TestTrue(FString::Printf(TEXT("Load %s"), *pair.Key), InJournal->Load(pair.Key, bytes));
+		TestTrue(FString::Printf(TEXT("Same bytes %s"), *pair.Key), bytes == pair.Value);
+	}
+
+	TMap<FString, TArray<uint8>> records;
+	TestTrue(TEXT("Load all"), InJournal->LoadAll(records));
+	TestEqual(TEXT("Loaded count"), records.Num(), InExpected.Num());
+	for (const TPair<FString, TArray<uint8>>& pair : InExpected)
+	{
+		const TArray<uint8>* bytes = records.Find(pair.Key);
+		TestTrue(FString::Printf(TEXT("Loaded %s"), *pair.Key), bytes != nullptr && *bytes == pair.Value);
+	}
+}
+
+void FDataSerializerJournalSpec::Define()
+{
+	BeforeEach([this]()
+	{
+		FilePath = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("DataSerializerJournalSpec.journal"));
+	});
+
+	AfterEach([this]()
+	{
+		IFileManager::Get().Delete(*FilePath, false, true, true);
+		IFileManager::Get().Delete(*(FilePath + TEXT(".compact")), false, true, true);
+	});
+
+	It("should replay the latest record of each key and drop removed keys", [this]()
+	{
+		{
+			TSharedPtr<FDataSerializerJournal, ESPMode::ThreadSafe> journal = FDataSerializerJournal::Open(FilePath);
+			TestTrue(TEXT("Opened"), journal.IsValid());
+			TestTrue(TEXT("Append a"), journal->Append(TEXT("a"), CreateBytes(1)));
+			TestTrue(TEXT("Append b"), journal->Append(TEXT("b"), CreateBytes(2)));
+			TestTrue(TEXT("Append a again"), journal->Append(TEXT("a"), CreateBytes(3, 40)));
+			TestTrue(TEXT("Remove b"), journal->Remove(TEXT("b")));
+			TestFalse(TEXT("Remove missing key"), journal->Remove(TEXT("b")));
+			const TArray<FString> keys = {TEXT("c"), TEXT("d")};
+			const TArray<TArray<uint8>> records = {CreateBytes(4), CreateBytes(5)};
+			TestTrue(TEXT("Append batch"), journal->AppendBatch(keys, records));
+			TestTrue(TEXT("Garbage"), journal->GetGarbageRatio() > 0.0);
+		}
+
+		TSharedPtr<FDataSerializerJournal, ESPMode::ThreadSafe> journal = FDataSerializerJournal::Open(FilePath);
+		TestTrue(TEXT("Reopened"), journal.IsValid());
+		TestRecords(journal, {{TEXT("a"), CreateBytes(3, 40)}, {TEXT("c"), CreateBytes(4)}, {TEXT("d"), CreateBytes(5)}});
+	});
+
+	It("should drop a torn record at the end and keep appending after it", [this]()
+	{
+		{
+			TSharedPtr<FDataSerializerJournal, ESPMode::ThreadSafe> journal = FDataSerializerJournal::Open(FilePath);
+			journal->Append(TEXT("a"), CreateBytes(1));
+			journal->Append(TEXT("b"), CreateBytes(2));
+		}
+
+		TArray<uint8> file;
+		TestTrue(TEXT("Read file"), FFileHelper::LoadFileToArray(file, *FilePath));
+		file.SetNum(file.Num() - 10);
+		TestTrue(TEXT("Truncated"), FFileHelper::SaveArrayToFile(file, *FilePath));
+
+		{
+			TSharedPtr<FDataSerializerJournal, ESPMode::ThreadSafe> journal = FDataSerializerJournal::Open(FilePath);
+			TestTrue(TEXT("Opened"), journal.IsValid());
+			TestRecords(journal, {{TEXT("a"), CreateBytes(1)}});
+			TestEqual(TEXT("Torn record removed"), journal->GetFileSize(), IFileManager::Get().FileSize(*FilePath));
+			TestTrue(TEXT("Append c"), journal->Append(TEXT("c"), CreateBytes(3)));
+		}
+
+		TSharedPtr<FDataSerializerJournal, ESPMode::ThreadSafe> journal = FDataSerializerJournal::Open(FilePath);
+		TestRecords(journal, {{TEXT("a"), CreateBytes(1)}, {TEXT("c"), CreateBytes(3)}});
+	});
+
+	It("should stop the replay at a corrupt record", [this]()
+	{
+		{
+			TSharedPtr<FDataSerializerJournal, ESPMode::ThreadSafe> journal = FDataSerializerJournal::Open(FilePath);
+			journal->Append(TEXT("a"), CreateBytes(1));
+			journal->Append(TEXT("b"), CreateBytes(2));
+		}
+
+		TArray<uint8> file;
+		FFileHelper::LoadFileToArray(file, *FilePath);
+		file.Last() ^= 0xFF;
+		FFileHelper::SaveArrayToFile(file, *FilePath);
+
+		TSharedPtr<FDataSerializerJournal, ESPMode::ThreadSafe> journal = FDataSerializerJournal::Open(FilePath);
+		TestTrue(TEXT("Opened"), journal.IsValid());
+		TestRecords(journal, {{TEXT("a"), CreateBytes(1)}});
+	});
+
+	It("should not open files that are not journals", [this]()
+	{
+		const TArray<uint8> shortFile = {0x6A, 0x75};
+		FFileHelper::SaveArrayToFile(shortFile, *FilePath);
+		TestFalse(TEXT("Too short"), FDataSerializerJournal::Open(FilePath).IsValid());
+
+		const TArray<uint8> otherFile = CreateBytes(1, 16);
+		FFileHelper::SaveArrayToFile(otherFile, *FilePath);
+		TestFalse(TEXT("Other tag"), FDataSerializerJournal::Open(FilePath).IsValid());
+
+		TArray<uint8> file;
+		FFileHelper::LoadFileToArray(file, *FilePath);
+		TestTrue(TEXT("File left alone"), file == otherFile);
+	});
+
+	It("should recover a packed file that did not replace the journal", [this]()
+	{
+		const FString tempPath = FilePath + TEXT(".compact");
+		{
+			TSharedPtr<FDataSerializerJournal, ESPMode::ThreadSafe> journal = FDataSerializerJournal::Open(FilePath);
+			journal->Append(TEXT("a"), CreateBytes(1));
+			journal->Append(TEXT("a"), CreateBytes(2));
+			TestTrue(TEXT("Compacted"), journal->Compact());
+		}
+
+		// Crash after the journal was deleted, before the packed file was moved
+		TestTrue(TEXT("Moved"), IFileManager::Get().Move(*tempPath, *FilePath));
+
+		TSharedPtr<FDataSerializerJournal, ESPMode::ThreadSafe> journal = FDataSerializerJournal::Open(FilePath);
+		TestTrue(TEXT("Opened"), journal.IsValid());
+		TestRecords(journal, {{TEXT("a"), CreateBytes(2)}});
+		TestFalse(TEXT("Packed file consumed"), IFileManager::Get().FileExists(*tempPath));
+	});
+
+	It("should drop a partial packed file next to an intact journal", [this]()
+	{
+		const FString tempPath = FilePath + TEXT(".compact");
+		{
+			TSharedPtr<FDataSerializerJournal, ESPMode::ThreadSafe> journal = FDataSerializerJournal::Open(FilePath);
+			journal->Append(TEXT("a"), CreateBytes(1));
+		}
+
+		// Crash while the packed file was written
+		const TArray<uint8> partial = {0x6A, 0x75, 0x65};
+		FFileHelper::SaveArrayToFile(partial, *tempPath);
+
+		TSharedPtr<FDataSerializerJournal, ESPMode::ThreadSafe> journal = FDataSerializerJournal::Open(FilePath);
+		TestTrue(TEXT("Opened"), journal.IsValid());
+		TestRecords(journal, {{TEXT("a"), CreateBytes(1)}});
+		TestFalse(TEXT("Packed file deleted"), IFileManager::Get().FileExists(*tempPath));
+	});
+
+	It("should overwrite the part of a failed append with the next one", [this]()
+	{
+		{
+			// Installed first, the journal opens its writer through it and is closed before it goes away
+			FDataSerializerFaultPlatformFile fault;
+			TSharedPtr<FDataSerializerJournal, ESPMode::ThreadSafe> journal = FDataSerializerJournal::Open(FilePath);
+			TestTrue(TEXT("Append a"), journal->Append(TEXT("a"), CreateBytes(1)));
+			const int64 size = journal->GetFileSize();
+
+			fault.FailWritesAfter(20);
+			TestFalse(TEXT("Append b fails"), journal->Append(TEXT("b"), CreateBytes(2)));
+			fault.Disarm();
+			TestEqual(TEXT("Partial record on disk"), IFileManager::Get().FileSize(*FilePath), size + 20);
+			TestFalse(TEXT("No b"), journal->Contains(TEXT("b")));
+			TestEqual(TEXT("Same size"), journal->GetFileSize(), size);
+
+			TestTrue(TEXT("Append c"), journal->Append(TEXT("c"), CreateBytes(3)));
+			TestRecords(journal, {{TEXT("a"), CreateBytes(1)}, {TEXT("c"), CreateBytes(3)}});
+		}
+
+		TSharedPtr<FDataSerializerJournal, ESPMode::ThreadSafe> journal = FDataSerializerJournal::Open(FilePath);
+		TestRecords(journal, {{TEXT("a"), CreateBytes(1)}, {TEXT("c"), CreateBytes(3)}});
+		TestEqual(TEXT("No trailing bytes"), journal->GetFileSize(), IFileManager::Get().FileSize(*FilePath));
+	});
+
+	It("should keep the journal when compaction fails", [this]()
+	{
+		TSharedPtr<FDataSerializerJournal, ESPMode::ThreadSafe> journal = FDataSerializerJournal::Open(FilePath);
+		journal->Append(TEXT("a"), CreateBytes(1));
+		journal->Append(TEXT("a"), CreateBytes(2));
+		{
+			FDataSerializerFaultPlatformFile fault;
+			fault.FailWritesAfter(10);
+			TestFalse(TEXT("Compaction fails"), journal->Compact());
+		}
+		TestFalse(TEXT("No packed file"), IFileManager::Get().FileExists(*(FilePath + TEXT(".compact"))));
+		TestTrue(TEXT("Append b"), journal->Append(TEXT("b"), CreateBytes(3)));
+		TestRecords(journal, {{TEXT("a"), CreateBytes(2)}, {TEXT("b"), CreateBytes(3)}});
+	});
+
+	It("should keep the records appended while compacting", [this]()
+	{
+		TMap<FString, TArray<uint8>> expected;
+		{
+			TSharedPtr<FDataSerializerJournal, ESPMode::ThreadSafe> journal = FDataSerializerJournal::Open(FilePath);
+			journal->SetCompactionThreshold(1.0);
+			for (int32 i = 0; i < 200; ++i)
+			{
+				const FString key = FString::Printf(TEXT("key%d"), i % 20);
+				const TArray<uint8> bytes = CreateBytes(static_cast<uint8>(i), 1000);
+				journal->Append(key, bytes);
+				expected.Add(key, bytes);
+			}
+
+			journal->CompactAsync();
+			for (int32 i = 0; i < 50 || journal->IsCompacting(); ++i)
+			{
+				const FString key = FString::Printf(TEXT("key%d"), i % 30);
+				const TArray<uint8> bytes = CreateBytes(static_cast<uint8>(i + 100), 500);
+				TestTrue(TEXT("Append"), journal->Append(key, bytes));
+				expected.Add(key, bytes);
+			}
+			journal->WaitForCompaction();
+
+			TestFalse(TEXT("Compaction done"), journal->IsCompacting());
+			TestEqual(TEXT("File size"), journal->GetFileSize(), IFileManager::Get().FileSize(*FilePath));
+			TestRecords(journal, expected);
+		}
+
+		TSharedPtr<FDataSerializerJournal, ESPMode::ThreadSafe> journal = FDataSerializerJournal::Open(FilePath);
+		TestRecords(journal, expected);
+	});
+}
+
+#endif
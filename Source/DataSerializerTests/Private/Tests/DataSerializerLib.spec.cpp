@@ -0,0 +1,393 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HAL/FileManager.h"
+#include "Libs/DataSerializerLib.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Tests/DataSerializerSpecNode.h"
+#include "UObject/Package.h"
+#include "Utils/DataSerializerBenchmarkCommandlet.h"
+#include "Utils/DataSerializerObjectPool.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+BEGIN_DEFINE_SPEC(FDataSerializerLibSpec, "DataSerializer.Lib",
+                  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+	TArray<UObject*> Sources;
+	FString FilePath;
+
+	/** Creates an object whose SaveGame properties all differ from their defaults. */
+	static UDataSerializerBenchmarkObject* CreateSource(int32 InIndex);
+
+	/** Creates objects of the source classes with default values, to load into. */
+	TArray<UObject*> CreateTargets() const;
+
+END_DEFINE_SPEC(FDataSerializerLibSpec)
+
+UDataSerializerBenchmarkObject* FDataSerializerLibSpec::CreateSource(int32 InIndex)
+{
+	UDataSerializerBenchmarkObject* object = NewObject<UDataSerializerBenchmarkObject>(GetTransientPackage());
+	object->Id = InIndex + 1;
+	object->Health = 12.5f * (InIndex + 1);
+	object->Location = FVector(1.0, -2.0, 3.5) * (InIndex + 1);
+	object->Rotation = FRotator(10.0, 20.0 * InIndex, -30.0);
+	object->bAlive = true;
+	object->Tag = FName(TEXT("Spec"), InIndex);
+	object->DisplayName = FString::Printf(TEXT("SpecObject_%d"), InIndex);
+	for (int32 i = 0; i < 64 * (InIndex + 1); ++i)
+	{
+		object->Payload.Add(static_cast<uint8>(i * 7 + InIndex));
+	}
+	return object;
+}
+
+TArray<UObject*> FDataSerializerLibSpec::CreateTargets() const
+{
+	TArray<UObject*> targets;
+	for (UObject* source : Sources)
+	{
+		targets.Add(NewObject<UObject>(GetTransientPackage(), source->GetClass()));
+	}
+	return targets;
+}
+
+void FDataSerializerLibSpec::Define()
+{
+	BeforeEach([this]()
+	{
+		Sources.Reset();
+		for (int32 i = 0; i < 3; ++i)
+		{
+			Sources.Add(CreateSource(i));
+		}
+	});
+
+	Describe("SerializeObject", [this]()
+	{
+		It("should restore the SaveGame properties of the object", [this]()
+		{
+			TArray<uint8> bytes;
+			TestTrue(TEXT("Serialized"), UDataSerializerLib::SerializeObject(bytes, Sources[0]));
+
+			UObject* loaded = nullptr;
+			TestTrue(TEXT("Deserialized"), UDataSerializerLib::DeserializeObject(bytes, GetTransientPackage(), loaded));
+			TestTrue(TEXT("Restored"), Serializer::VerifyBenchmarkObjects({Sources[0]}, {loaded}));
+		});
+
+		It("should read one object after the other from the same archive", [this]()
+		{
+			TArray<uint8> bytes;
+			FMemoryWriter writer(bytes, true);
+			for (UObject* source : Sources)
+			{
+				TArray<uint8> objectBytes;
+				TestTrue(TEXT("Serialized"), UDataSerializerLib::SerializeObject(objectBytes, source));
+				writer.Serialize(objectBytes.GetData(), objectBytes.Num());
+			}
+
+			TArray<UObject*> loaded;
+			FMemoryReader reader(bytes, true);
+			for (int32 i = 0; i < Sources.Num(); ++i)
+			{
+				UObject* object = nullptr;
+				TestTrue(TEXT("Deserialized"), UDataSerializerLib::DeSerializeObjectCpp(reader, GetTransientPackage(), object));
+				loaded.Add(object);
+			}
+			TestTrue(TEXT("Restored"), Serializer::VerifyBenchmarkObjects(Sources, loaded));
+			TestEqual(TEXT("Read to the end"), reader.Tell(), reader.TotalSize());
+		});
+	});
+
+	Describe("DeSerializeObjectsCpp", [this]()
+	{
+		It("should restore a batch written by SerializeObjects in order", [this]()
+		{
+			TArray<uint8> bytes;
+			TestTrue(TEXT("Serialized"), UDataSerializerLib::SerializeObjects(bytes, Sources));
+
+			TArray<UObject*> loaded;
+			FMemoryReader reader(bytes, true);
+			TestTrue(TEXT("Deserialized"), UDataSerializerLib::DeSerializeObjectsCpp(reader, GetTransientPackage(), loaded));
+			TestTrue(TEXT("Restored"), Serializer::VerifyBenchmarkObjects(Sources, loaded));
+		});
+
+		It("should restore a batch written by SerializeObjectsWithSchema", [this]()
+		{
+			TArray<uint8> bytes;
+			TestTrue(TEXT("Serialized"), UDataSerializerLib::SerializeObjectsWithSchema(bytes, Sources));
+
+			TArray<UObject*> loaded;
+			FMemoryReader reader(bytes, true);
+			TestTrue(TEXT("Deserialized"), UDataSerializerLib::DeSerializeObjectsCpp(reader, GetTransientPackage(), loaded));
+			TestTrue(TEXT("Restored"), Serializer::VerifyBenchmarkObjects(Sources, loaded));
+		});
+
+		It("should keep the objects already in the output array", [this]()
+		{
+			TArray<uint8> bytes;
+			TestTrue(TEXT("Serialized"), UDataSerializerLib::SerializeObjects(bytes, Sources));
+
+			TArray<UObject*> loaded = {nullptr};
+			FMemoryReader reader(bytes, true);
+			TestTrue(TEXT("Deserialized"), UDataSerializerLib::DeSerializeObjectsCpp(reader, GetTransientPackage(), loaded));
+			TestEqual(TEXT("Num objects"), loaded.Num(), Sources.Num() + 1);
+		});
+	});
+
+	Describe("Loading into existing objects", [this]()
+	{
+		It("should load a blob into the given object with DeSerializeObjectInto", [this]()
+		{
+			TArray<uint8> bytes;
+			TestTrue(TEXT("Serialized"), UDataSerializerLib::SerializeObject(bytes, Sources[0]));
+
+			TArray<UObject*> targets = CreateTargets();
+			TestTrue(TEXT("Deserialized"), UDataSerializerLib::DeSerializeObjectInto(bytes, targets[0]));
+			TestTrue(TEXT("Restored"), Serializer::VerifyBenchmarkObjects({Sources[0]}, {targets[0]}));
+		});
+
+		It("should load a batch into the targets in record order with DeSerializeObjectsInto", [this]()
+		{
+			TArray<uint8> bytes;
+			TestTrue(TEXT("Serialized"), UDataSerializerLib::SerializeObjects(bytes, Sources));
+
+			TArray<UObject*> targets = CreateTargets();
+			TestTrue(TEXT("Deserialized"), UDataSerializerLib::DeSerializeObjectsInto(bytes, targets));
+			TestTrue(TEXT("Restored"), Serializer::VerifyBenchmarkObjects(Sources, targets));
+		});
+
+		It("should fail if the target and record counts differ", [this]()
+		{
+			TArray<uint8> bytes;
+			TestTrue(TEXT("Serialized"), UDataSerializerLib::SerializeObjects(bytes, Sources));
+
+			TArray<UObject*> targets = CreateTargets();
+			targets.Pop();
+			TestFalse(TEXT("Deserialized"), UDataSerializerLib::DeSerializeObjectsInto(bytes, targets));
+		});
+
+		It("should load only the records that have a target with DeSerializeObjectsIntoByKey", [this]()
+		{
+			TArray<uint8> bytes;
+			TestTrue(TEXT("Serialized"), UDataSerializerLib::SerializeObjectsIndexedWithKeys(
+				         bytes, Sources, {TEXT("First"), TEXT("Second"), TEXT("Third")}));
+
+			TArray<UObject*> targets = CreateTargets();
+			TestTrue(TEXT("Deserialized"), UDataSerializerLib::DeSerializeObjectsIntoByKey(
+				         bytes, {{TEXT("Third"), targets[2]}, {TEXT("Second"), targets[1]}}));
+			TestTrue(TEXT("Restored"), Serializer::VerifyBenchmarkObjects({Sources[1], Sources[2]}, {targets[1], targets[2]}));
+			TestFalse(TEXT("Untouched"), Serializer::VerifyBenchmarkObjects({Sources[0]}, {targets[0]}));
+		});
+
+		It("should reuse the released objects with DeSerializeObjectsPooled", [this]()
+		{
+			TArray<uint8> bytes;
+			TestTrue(TEXT("Serialized"), UDataSerializerLib::SerializeObjects(bytes, Sources));
+
+			UDataSerializerObjectPool* pool = UDataSerializerObjectPool::CreateObjectPool();
+			TArray<UObject*> loaded;
+			TestTrue(TEXT("First load"), UDataSerializerLib::DeSerializeObjectsPooled(bytes, GetTransientPackage(), pool, loaded));
+			TestTrue(TEXT("First load restored"), Serializer::VerifyBenchmarkObjects(Sources, loaded));
+			TestEqual(TEXT("Created"), pool->GetNumCreated(), Sources.Num());
+
+			pool->ReleaseObjects(loaded);
+			const TArray<UObject*> released = loaded;
+			loaded.Reset();
+			TestTrue(TEXT("Second load"), UDataSerializerLib::DeSerializeObjectsPooled(bytes, GetTransientPackage(), pool, loaded));
+			TestTrue(TEXT("Second load restored"), Serializer::VerifyBenchmarkObjects(Sources, loaded));
+			TestEqual(TEXT("Reused"), pool->GetNumReused(), Sources.Num());
+			TestEqual(TEXT("Created once"), pool->GetNumCreated(), Sources.Num());
+			for (UObject* object : loaded)
+			{
+				TestTrue(TEXT("Object from the pool"), released.Contains(object));
+			}
+		});
+	});
+
+	Describe("Indexed archives", [this]()
+	{
+		It("should load a single record, a record by key and a range of records", [this]()
+		{
+			TArray<uint8> bytes;
+			TestTrue(TEXT("Serialized"), UDataSerializerLib::SerializeObjectsIndexed(bytes, Sources, true));
+			TestEqual(TEXT("Num records"), UDataSerializerLib::GetIndexedObjectCount(bytes), Sources.Num());
+
+			UObject* single = nullptr;
+			TestTrue(TEXT("Read by index"), UDataSerializerLib::DeSerializeIndexedObject(bytes, 1, GetTransientPackage(), single));
+			TestTrue(TEXT("Restored by index"), Serializer::VerifyBenchmarkObjects({Sources[1]}, {single}));
+
+			UObject* byKey = nullptr;
+			TestTrue(TEXT("Read by key"), UDataSerializerLib::DeSerializeIndexedObjectByKey(
+				         bytes, Sources[2]->GetName(), GetTransientPackage(), byKey));
+			TestTrue(TEXT("Restored by key"), Serializer::VerifyBenchmarkObjects({Sources[2]}, {byKey}));
+
+			TArray<UObject*> range;
+			TestTrue(TEXT("Read range"), UDataSerializerLib::DeSerializeIndexedObjectRange(bytes, 1, 2, GetTransientPackage(), range));
+			TestTrue(TEXT("Restored range"), Serializer::VerifyBenchmarkObjects({Sources[1], Sources[2]}, range));
+		});
+
+		It("should be readable whole by DeSerializeObjects", [this]()
+		{
+			TArray<uint8> bytes;
+			TestTrue(TEXT("Serialized"), UDataSerializerLib::SerializeObjectsIndexed(bytes, Sources, false));
+
+			TArray<UObject*> loaded;
+			TestTrue(TEXT("Deserialized"), UDataSerializerLib::DeSerializeObjects(bytes, GetTransientPackage(), loaded));
+			TestTrue(TEXT("Restored"), Serializer::VerifyBenchmarkObjects(Sources, loaded));
+		});
+
+		It("should reject out of range indices and unknown keys", [this]()
+		{
+			TArray<uint8> bytes;
+			TestTrue(TEXT("Serialized"), UDataSerializerLib::SerializeObjectsIndexed(bytes, Sources, true));
+
+			UObject* object = nullptr;
+			TestFalse(TEXT("Index"), UDataSerializerLib::DeSerializeIndexedObject(bytes, Sources.Num(), GetTransientPackage(), object));
+			TestFalse(TEXT("Key"), UDataSerializerLib::DeSerializeIndexedObjectByKey(bytes, TEXT("Missing"), GetTransientPackage(), object));
+
+			// Long enough for the header, so the reader never runs past the end
+			const TArray<uint8> notAnIndex = {1, 2, 3, 4, 5, 6, 7, 8};
+			TestEqual(TEXT("Not an index"), UDataSerializerLib::GetIndexedObjectCount(notAnIndex), INDEX_NONE);
+		});
+	});
+
+	Describe("Object graphs", [this]()
+	{
+		It("should restore shared objects once and keep external references", [this]()
+		{
+			UDataSerializerSpecNode* shared = NewObject<UDataSerializerSpecNode>(GetTransientPackage());
+			shared->Value = 7;
+			TArray<UObject*> roots;
+			for (int32 i = 0; i < 2; ++i)
+			{
+				UDataSerializerSpecNode* root = NewObject<UDataSerializerSpecNode>(GetTransientPackage());
+				root->Value = i + 1;
+				root->Shared = shared;
+				root->External = Sources[0];
+				roots.Add(root);
+			}
+
+			TArray<uint8> bytes;
+			TestTrue(TEXT("Serialized"), UDataSerializerLib::SerializeObjectGraph(bytes, roots));
+
+			TArray<UObject*> loaded;
+			TestTrue(TEXT("Deserialized"), UDataSerializerLib::DeSerializeObjects(bytes, GetTransientPackage(), loaded));
+			if (!TestEqual(TEXT("Num roots"), loaded.Num(), roots.Num()))
+				return;
+
+			const UDataSerializerSpecNode* first = Cast<UDataSerializerSpecNode>(loaded[0]);
+			const UDataSerializerSpecNode* second = Cast<UDataSerializerSpecNode>(loaded[1]);
+			if (!TestNotNull(TEXT("First root"), first) || !TestNotNull(TEXT("Second root"), second))
+				return;
+
+			TestEqual(TEXT("First value"), first->Value, 1);
+			TestEqual(TEXT("Second value"), second->Value, 2);
+			TestTrue(TEXT("Shared object loaded once"), first->Shared != nullptr && first->Shared == second->Shared);
+			TestTrue(TEXT("Shared object is a copy"), first->Shared != shared);
+			TestEqual(TEXT("Shared value"), first->Shared != nullptr ? first->Shared->Value : 0, 7);
+			TestTrue(TEXT("External reference kept"), first->External == Sources[0]);
+		});
+	});
+
+	Describe("Deltas", [this]()
+	{
+		It("should patch a copy of the baseline into the object with ApplyObjectDelta", [this]()
+		{
+			TArray<uint8> delta;
+			TestTrue(TEXT("Serialized"), UDataSerializerLib::SerializeObjectDelta(delta, Sources[0], Sources[1]));
+
+			TArray<uint8> full;
+			TestTrue(TEXT("Serialized full"), UDataSerializerLib::SerializeObject(full, Sources[0]));
+			TestTrue(TEXT("Smaller than a full blob"), delta.Num() < full.Num());
+
+			UObject* target = CreateSource(1);
+			TestTrue(TEXT("Applied"), UDataSerializerLib::ApplyObjectDelta(delta, target));
+			TestTrue(TEXT("Restored"), Serializer::VerifyBenchmarkObjects({Sources[0]}, {target}));
+		});
+
+		It("should produce a full blob with ApplyObjectDeltaToBytes", [this]()
+		{
+			TArray<uint8> baseline;
+			TArray<uint8> delta;
+			TestTrue(TEXT("Serialized baseline"), UDataSerializerLib::SerializeObject(baseline, Sources[1]));
+			TestTrue(TEXT("Serialized delta"), UDataSerializerLib::SerializeObjectDeltaFromBytes(delta, Sources[0], baseline));
+
+			TArray<uint8> patched;
+			TestTrue(TEXT("Applied"), UDataSerializerLib::ApplyObjectDeltaToBytes(baseline, delta, patched));
+
+			UObject* loaded = nullptr;
+			TestTrue(TEXT("Deserialized"), UDataSerializerLib::DeserializeObject(patched, GetTransientPackage(), loaded));
+			TestTrue(TEXT("Restored"), Serializer::VerifyBenchmarkObjects({Sources[0]}, {loaded}));
+		});
+
+		It("should leave the properties that did not change untouched", [this]()
+		{
+			UDataSerializerBenchmarkObject* changed = CreateSource(1);
+			changed->Health = -1.f;
+
+			TArray<uint8> delta;
+			TestTrue(TEXT("Serialized"), UDataSerializerLib::SerializeObjectDelta(delta, changed, Sources[1]));
+
+			UDataSerializerBenchmarkObject* target = CreateSource(2);
+			TestTrue(TEXT("Applied"), UDataSerializerLib::ApplyObjectDelta(delta, target));
+			TestEqual(TEXT("Changed property"), target->Health, -1.f);
+			TestEqual(TEXT("Other property"), target->Id, 3);
+		});
+	});
+
+	Describe("Compressed disk I/O", [this]()
+	{
+		BeforeEach([this]()
+		{
+			FilePath = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("DataSerializerLibSpec.sav"));
+		});
+
+		AfterEach([this]()
+		{
+			IFileManager::Get().Delete(*FilePath, false, true, true);
+		});
+
+		It("should read back the bytes written by WriteBytesToDiskCompressed", [this]()
+		{
+			TArray<uint8> bytes;
+			TestTrue(TEXT("Serialized"), UDataSerializerLib::SerializeObjects(bytes, Sources));
+			TestTrue(TEXT("Written"), UDataSerializerLib::WriteBytesToDiskCompressed(bytes, FilePath));
+
+			TArray<uint8> readBytes;
+			TestTrue(TEXT("Read"), UDataSerializerLib::ReadCompressedBytesFromDisk(readBytes, FilePath));
+			TestTrue(TEXT("Same bytes"), readBytes == bytes);
+		});
+
+		It("should restore the objects with DeSerializeObjectsFromFile", [this]()
+		{
+			TArray<uint8> bytes;
+			TestTrue(TEXT("Serialized"), UDataSerializerLib::SerializeObjects(bytes, Sources));
+			TestTrue(TEXT("Written"), UDataSerializerLib::WriteBytesToDiskCompressed(bytes, FilePath));
+
+			TArray<UObject*> loaded;
+			TestTrue(TEXT("Deserialized"), UDataSerializerLib::DeSerializeObjectsFromFile(FilePath, GetTransientPackage(), loaded));
+			TestTrue(TEXT("Restored"), Serializer::VerifyBenchmarkObjects(Sources, loaded));
+		});
+
+		It("should read back data larger than a compression chunk", [this]()
+		{
+			TArray<uint8> bytes;
+			bytes.SetNumUninitialized(XEUS_COMPRESSION_CHUNK_SIZE * 2 + 123);
+			for (int32 i = 0; i < bytes.Num(); ++i)
+			{
+				bytes[i] = static_cast<uint8>((i / 3) % 251);
+			}
+			TestTrue(TEXT("Written"), UDataSerializerLib::WriteBytesToDiskCompressed(bytes, FilePath));
+
+			TArray<uint8> readBytes;
+			TestTrue(TEXT("Read"), UDataSerializerLib::ReadCompressedBytesFromDisk(readBytes, FilePath));
+			TestTrue(TEXT("Same bytes"), readBytes == bytes);
+		});
+	});
+}
+
+#endif
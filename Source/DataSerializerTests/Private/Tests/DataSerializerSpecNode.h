@@ -0,0 +1,29 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "DataSerializerSpecNode.generated.h"
+
+/**
+ * @class UDataSerializerSpecNode
+ * @brief Object with references used by the object graph specs.
+ */
+UCLASS(Transient)
+class UDataSerializerSpecNode : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(SaveGame)
+	int32 Value = 0;
+
+	/** Owned through a SaveGame reference, written into the graph. */
+	UPROPERTY(SaveGame)
+	TObjectPtr<UDataSerializerSpecNode> Shared;
+
+	/** Not a SaveGame property, never followed into the graph. */
+	UPROPERTY()
+	TObjectPtr<UObject> External;
+};
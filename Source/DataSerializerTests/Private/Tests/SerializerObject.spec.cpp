@@ -0,0 +1,317 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Libs/DataSerializerEncoding.h"
+#include "Misc/AutomationTest.h"
+#include "Utils/DeSerializerObject.h"
+#include "Utils/SerializerObject.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+BEGIN_DEFINE_SPEC(FSerializerObjectSpec, "DataSerializer.SerializerObject",
+                  EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+	USerializerObject* Serializer = nullptr;
+	UDeSerializerObject* DeSerializer = nullptr;
+
+	/** Starts reading what the serializer wrote. */
+	void StartReading()
+	{
+		TArray<uint8> bytes;
+		Serializer->GetBytes(bytes);
+		DeSerializer->Start(bytes);
+	}
+
+END_DEFINE_SPEC(FSerializerObjectSpec)
+
+void FSerializerObjectSpec::Define()
+{
+	BeforeEach([this]()
+	{
+		Serializer = NewObject<USerializerObject>();
+		DeSerializer = NewObject<UDeSerializerObject>();
+	});
+
+	Describe("Primitives", [this]()
+	{
+		It("should read back scalars in the order they were written", [this]()
+		{
+			Serializer->SerializeInt(-42);
+			Serializer->SerializeBigInt(int64(1) << 40);
+			Serializer->SerializeFloat(3.25f);
+			Serializer->SerializeDouble(-0.125);
+			Serializer->SerializeBool(true);
+			Serializer->SerializeByte(200);
+			StartReading();
+
+			int32 intValue = 0;
+			int64 bigIntValue = 0;
+			float floatValue = 0.f;
+			double doubleValue = 0.0;
+			bool boolValue = false;
+			uint8 byteValue = 0;
+			TestTrue(TEXT("Read int"), DeSerializer->TryReadInt(intValue));
+			TestTrue(TEXT("Read int64"), DeSerializer->TryReadInt64(bigIntValue));
+			TestTrue(TEXT("Read float"), DeSerializer->TryReadFloat(floatValue));
+			TestTrue(TEXT("Read double"), DeSerializer->TryReadDouble(doubleValue));
+			TestTrue(TEXT("Read bool"), DeSerializer->TryReadBool(boolValue));
+			TestTrue(TEXT("Read byte"), DeSerializer->TryReadUInt8(byteValue));
+			TestEqual(TEXT("Int"), intValue, -42);
+			TestEqual(TEXT("Int64"), bigIntValue, int64(1) << 40);
+			TestEqual(TEXT("Float"), floatValue, 3.25f);
+			TestEqual(TEXT("Double"), doubleValue, -0.125);
+			TestTrue(TEXT("Bool"), boolValue);
+			TestTrue(TEXT("Byte"), byteValue == 200);
+		});
+
+		It("should read back math types", [this]()
+		{
+			const FVector vector(1.5, -2.0, 1000.0);
+			const FRotator rotator(10.0, -45.0, 90.0);
+			const FTransform transform(rotator, vector, FVector(2.0));
+			Serializer->SerializeVector(vector);
+			Serializer->SerializeIntVector(FIntVector(1, -2, 3));
+			Serializer->SerializeVector2D(FVector2D(-4.0, 8.0));
+			Serializer->SerializePoint(FIntPoint(7, -9));
+			Serializer->SerializeRotator(rotator);
+			Serializer->SerializeTransform(transform);
+			StartReading();
+
+			FVector vectorValue;
+			FIntVector intVectorValue;
+			FVector2D vector2DValue;
+			FIntPoint pointValue;
+			FRotator rotatorValue;
+			FTransform transformValue;
+			TestTrue(TEXT("Read vector"), DeSerializer->TryReadVector(vectorValue));
+			TestTrue(TEXT("Read int vector"), DeSerializer->TryReadIntVector(intVectorValue));
+			TestTrue(TEXT("Read vector 2D"), DeSerializer->TryReadVector2D(vector2DValue));
+			TestTrue(TEXT("Read point"), DeSerializer->TryReadIntPoint(pointValue));
+			TestTrue(TEXT("Read rotator"), DeSerializer->TryReadRotator(rotatorValue));
+			TestTrue(TEXT("Read transform"), DeSerializer->TryReadTransform(transformValue));
+			TestEqual(TEXT("Vector"), vectorValue, vector);
+			TestTrue(TEXT("Int vector"), intVectorValue == FIntVector(1, -2, 3));
+			TestTrue(TEXT("Vector 2D"), vector2DValue == FVector2D(-4.0, 8.0));
+			TestTrue(TEXT("Point"), pointValue == FIntPoint(7, -9));
+			TestEqual(TEXT("Rotator"), rotatorValue, rotator);
+			TestTrue(TEXT("Transform"), transformValue.Equals(transform));
+		});
+
+		It("should read back strings and arrays", [this]()
+		{
+			const FString text = TEXT("Save data \u00e9\u4e16");
+			const TArray<int32> ints = {1, -2, 3, MAX_int32, MIN_int32};
+			const TArray<float> floats = {0.5f, -1.f};
+			const TArray<uint8> bytes = {0, 1, 254, 255};
+			const TArray<FVector> vectors = {FVector(1.0), FVector(-2.0, 0.0, 3.0)};
+			Serializer->SerializeString(text);
+			Serializer->SerializeString(FString());
+			Serializer->SerializeIntArray(ints);
+			Serializer->SerializeFloatArray(floats);
+			Serializer->SerializeByteArray(bytes);
+			Serializer->SerializeVectorArray(vectors);
+			Serializer->SerializeIntArray(TArray<int32>());
+			StartReading();
+
+			FString textValue;
+			FString emptyValue = TEXT("Not empty");
+			TArray<int32> intsValue;
+			TArray<float> floatsValue;
+			TArray<uint8> bytesValue;
+			TArray<FVector> vectorsValue;
+			TArray<int32> emptyArrayValue = {1};
+			TestTrue(TEXT("Read string"), DeSerializer->TryReadString(textValue));
+			TestTrue(TEXT("Read empty string"), DeSerializer->TryReadString(emptyValue));
+			TestTrue(TEXT("Read int array"), DeSerializer->TryReadIntArray(intsValue));
+			TestTrue(TEXT("Read float array"), DeSerializer->TryReadFloatArray(floatsValue));
+			TestTrue(TEXT("Read byte array"), DeSerializer->TryReadUInt8Array(bytesValue));
+			TestTrue(TEXT("Read vector array"), DeSerializer->TryReadVectorArray(vectorsValue));
+			TestTrue(TEXT("Read empty array"), DeSerializer->TryReadIntArray(emptyArrayValue));
+			TestEqual(TEXT("String"), textValue, text);
+			TestTrue(TEXT("Empty string"), emptyValue.IsEmpty());
+			TestTrue(TEXT("Int array"), intsValue == ints);
+			TestTrue(TEXT("Float array"), floatsValue == floats);
+			TestTrue(TEXT("Byte array"), bytesValue == bytes);
+			TestTrue(TEXT("Vector array"), vectorsValue == vectors);
+			TestEqual(TEXT("Empty array"), emptyArrayValue.Num(), 0);
+		});
+
+		It("should read back nothing after a reset", [this]()
+		{
+			Serializer->SerializeInt(1);
+			Serializer->Reset();
+			Serializer->SerializeInt(2);
+			StartReading();
+
+			int32 value = 0;
+			TestTrue(TEXT("Read int"), DeSerializer->TryReadInt(value));
+			TestEqual(TEXT("Int"), value, 2);
+		});
+
+		It("should fail to read before being started", [this]()
+		{
+			int32 value = 0;
+			TestFalse(TEXT("Read int"), DeSerializer->TryReadInt(value));
+		});
+	});
+
+	Describe("Stream modes", [this]()
+	{
+		It("should read back VarInt integers in fewer bytes", [this]()
+		{
+			const TArray<int32> ints = {0, 1, -1, 300, MAX_int32, MIN_int32};
+			const int64 bigInt = MIN_int64;
+			Serializer->SetIntEncoding(EDataSerializerIntEncoding::VarInt);
+			Serializer->SerializeInt(5);
+			Serializer->SerializeBigInt(bigInt);
+			Serializer->SerializeIntArray(ints);
+			TArray<uint8> bytes;
+			Serializer->GetBytes(bytes);
+			DeSerializer->SetIntEncoding(EDataSerializerIntEncoding::VarInt);
+			DeSerializer->Start(bytes);
+
+			int32 intValue = 0;
+			int64 bigIntValue = 0;
+			TArray<int32> intsValue;
+			TestTrue(TEXT("Read int"), DeSerializer->TryReadInt(intValue));
+			TestTrue(TEXT("Read int64"), DeSerializer->TryReadInt64(bigIntValue));
+			TestTrue(TEXT("Read int array"), DeSerializer->TryReadIntArray(intsValue));
+			TestEqual(TEXT("Int"), intValue, 5);
+			TestEqual(TEXT("Int64"), bigIntValue, bigInt);
+			TestTrue(TEXT("Int array"), intsValue == ints);
+		});
+
+		It("should read back packed booleans", [this]()
+		{
+			Serializer->SetPackBools(true);
+			for (int32 i = 0; i < 10; ++i)
+			{
+				Serializer->SerializeBool(i % 3 == 0);
+			}
+			Serializer->SerializeInt(42);
+			TArray<uint8> bytes;
+			Serializer->GetBytes(bytes);
+			DeSerializer->SetPackBools(true);
+			DeSerializer->Start(bytes);
+
+			for (int32 i = 0; i < 10; ++i)
+			{
+				bool value = false;
+				TestTrue(TEXT("Read bool"), DeSerializer->TryReadBool(value));
+				TestEqual(TEXT("Bool"), value, i % 3 == 0);
+			}
+			int32 intValue = 0;
+			TestTrue(TEXT("Read int"), DeSerializer->TryReadInt(intValue));
+			TestEqual(TEXT("Int after the bits"), intValue, 42);
+		});
+
+		It("should read a Fixed stream that starts with the preamble tag as data", [this]()
+		{
+			Serializer->SerializeInt(static_cast<int32>(XEUS_STREAM_TAG));
+			Serializer->SerializeInt(7);
+			StartReading();
+
+			int32 first = 0;
+			int32 second = 0;
+			TestTrue(TEXT("Read first"), DeSerializer->TryReadInt(first));
+			TestTrue(TEXT("Read second"), DeSerializer->TryReadInt(second));
+			TestEqual(TEXT("First"), first, static_cast<int32>(XEUS_STREAM_TAG));
+			TestEqual(TEXT("Second"), second, 7);
+		});
+
+		It("should fail to read a stream written with another mode", [this]()
+		{
+			Serializer->SerializeInt(1);
+			Serializer->SerializeInt(2);
+			DeSerializer->SetIntEncoding(EDataSerializerIntEncoding::VarInt);
+			StartReading();
+
+			int32 value = 0;
+			TestFalse(TEXT("Read int"), DeSerializer->TryReadInt(value));
+		});
+
+		It("should reject a varint longer than 64 bits", [this]()
+		{
+			Serializer->SetIntEncoding(EDataSerializerIntEncoding::VarInt);
+			TArray<uint8> bytes;
+			Serializer->GetBytes(bytes);
+			for (int32 i = 0; i < 9; ++i)
+			{
+				bytes.Add(0xFF);
+			}
+			bytes.Add(0x02);
+			DeSerializer->SetIntEncoding(EDataSerializerIntEncoding::VarInt);
+			DeSerializer->Start(bytes);
+
+			int64 value = 0;
+			TestFalse(TEXT("Read int64"), DeSerializer->TryReadInt64(value));
+		});
+	});
+
+	Describe("Bits", [this]()
+	{
+		It("should read back bit fields mixed with byte fields", [this]()
+		{
+			Serializer->SerializeBits(5, 3);
+			Serializer->SerializeBits(1, 1);
+			Serializer->SerializeBits(0xABCDE, 20);
+			Serializer->SerializeInt(-7);
+			Serializer->SerializeBits(-1, 32);
+			StartReading();
+
+			int32 first = 0;
+			int32 second = 0;
+			int32 third = 0;
+			int32 intValue = 0;
+			int32 last = 0;
+			TestTrue(TEXT("Read 3 bits"), DeSerializer->TryReadBits(first, 3));
+			TestTrue(TEXT("Read 1 bit"), DeSerializer->TryReadBits(second, 1));
+			TestTrue(TEXT("Read 20 bits"), DeSerializer->TryReadBits(third, 20));
+			TestTrue(TEXT("Read int"), DeSerializer->TryReadInt(intValue));
+			TestTrue(TEXT("Read 32 bits"), DeSerializer->TryReadBits(last, 32));
+			TestEqual(TEXT("3 bits"), first, 5);
+			TestEqual(TEXT("1 bit"), second, 1);
+			TestEqual(TEXT("20 bits"), third, 0xABCDE);
+			TestEqual(TEXT("Int"), intValue, -7);
+			TestEqual(TEXT("32 bits"), last, -1);
+		});
+	});
+
+	Describe("Quantized", [this]()
+	{
+		It("should read back vectors, rotators and transforms within their precision", [this]()
+		{
+			const FVector vector(123.456, -9876.54, 0.005);
+			const FRotator rotator(30.0, -120.0, 45.0);
+			const FTransform transform(FRotator(10.0, 20.0, 30.0), FVector(-500.25, 12.5, 3000.0), FVector(1.5));
+			Serializer->SerializeVectorQuantized(vector, 0.01, 100000.0);
+			Serializer->SerializeRotatorCompressed(rotator);
+			Serializer->SerializeTransformQuantized(transform);
+			StartReading();
+
+			FVector vectorValue;
+			FRotator rotatorValue;
+			FTransform transformValue;
+			TestTrue(TEXT("Read vector"), DeSerializer->TryReadVectorQuantized(vectorValue, 0.01, 100000.0));
+			TestTrue(TEXT("Read rotator"), DeSerializer->TryReadRotatorCompressed(rotatorValue));
+			TestTrue(TEXT("Read transform"), DeSerializer->TryReadTransformQuantized(transformValue));
+			TestTrue(TEXT("Vector"), vectorValue.Equals(vector, 0.005 + UE_KINDA_SMALL_NUMBER));
+			TestTrue(TEXT("Rotator"), rotatorValue.Equals(rotator, 360.0 / 65536.0));
+			TestTrue(TEXT("Transform translation"), transformValue.GetTranslation().Equals(transform.GetTranslation(), 0.01));
+			TestTrue(TEXT("Transform rotation"), transformValue.GetRotation().Equals(transform.GetRotation(), 0.001));
+			TestTrue(TEXT("Transform scale"), transformValue.GetScale3D().Equals(transform.GetScale3D(), 0.001));
+		});
+
+		It("should clamp values outside of the range", [this]()
+		{
+			Serializer->SerializeVectorQuantized(FVector(5000.0, -5000.0, 0.0), 1.0, 100.0);
+			StartReading();
+
+			FVector value;
+			TestTrue(TEXT("Read vector"), DeSerializer->TryReadVectorQuantized(value, 1.0, 100.0));
+			TestEqual(TEXT("Clamped"), value, FVector(100.0, -100.0, 0.0));
+		});
+	});
+}
+
+#endif
@@ -0,0 +1,520 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utils/DataSerializerBenchmarkCommandlet.h"
+
+#include "HAL/FileManager.h"
+#include "Libs/DataSerializerLib.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/Package.h"
+#include "UObject/UnrealType.h"
+#include "Utils/DeSerializerObject.h"
+#include "Utils/SerializerObject.h"
+
+#include <atomic>
+
+DEFINE_LOG_CATEGORY_STATIC(LogDataSerializerBenchmark, Log, All);
+
+namespace Serializer
+{
+	/** Counts the allocations going through GMalloc while installed, everything else is forwarded. */
+	class FBenchmarkMalloc final : public FMalloc
+	{
+	public:
+		FMalloc* Inner = nullptr;
+		std::atomic<uint64> NumAllocations{0};
+		std::atomic<uint64> AllocatedBytes{0};
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			++NumAllocations;
+			AllocatedBytes += Count;
+			return Inner->Malloc(Count, Alignment);
+		}
+
+		virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+		{
+			++NumAllocations;
+			AllocatedBytes += Count;
+			return Inner->TryMalloc(Count, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			++NumAllocations;
+			AllocatedBytes += Count;
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			++NumAllocations;
+			AllocatedBytes += Count;
+			return Inner->TryRealloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override { Inner->Free(Original); }
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+		virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+		virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+		virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+		virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+		virtual void UpdateStats() override { Inner->UpdateStats(); }
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { Inner->GetAllocatorStats(OutStats); }
+		virtual void DumpAllocatorStats(FOutputDevice& Ar) override { Inner->DumpAllocatorStats(Ar); }
+		virtual const TCHAR* GetDescriptiveName() override { return Inner->GetDescriptiveName(); }
+	};
+
+	/**
+	 * Installs the counting allocator for the lifetime of the scope.
+	 * Blocks allocated before are freed through it too, it only forwards, so swapping is safe.
+	 * @note GMalloc is process wide: allocations made by every thread while the scope is alive are counted,
+	 * including the thread pool workers of parallel compression and any unrelated engine thread.
+	 */
+	class FScopedAllocationCounter
+	{
+	public:
+		FScopedAllocationCounter()
+		{
+			static FBenchmarkMalloc counter;
+			Counter = &counter;
+			Counter->Inner = GMalloc;
+			Counter->NumAllocations = 0;
+			Counter->AllocatedBytes = 0;
+			GMalloc = Counter;
+		}
+
+		~FScopedAllocationCounter()
+		{
+			GMalloc = Counter->Inner;
+		}
+
+		uint64 GetNumAllocations() const { return Counter->NumAllocations; }
+		uint64 GetAllocatedBytes() const { return Counter->AllocatedBytes; }
+
+	private:
+		FBenchmarkMalloc* Counter = nullptr;
+	};
+
+	/** One measured operation of a case. */
+	struct FBenchmarkResult
+	{
+		FString Case;
+		FString Operation;
+		int32 NumObjects = 0;
+		int32 PayloadSize = 0;
+		int32 Iterations = 0;
+
+		/** Best time over the iterations. */
+		double Seconds = 0.0;
+
+		/** Serialized bytes processed by one iteration. */
+		int64 NumBytes = 0;
+
+		/** Size of the produced data (bytes or file). */
+		int64 OutputSize = 0;
+
+		/** Serialized size over stored size, 1 when nothing is compressed. */
+		double CompressionRatio = 1.0;
+
+		uint64 NumAllocations = 0;
+		uint64 AllocatedBytes = 0;
+		bool bVerified = true;
+
+		double GetMegabytesPerSecond() const { return Seconds > 0.0 ? NumBytes / Seconds / (1024.0 * 1024.0) : 0.0; }
+		double GetOpsPerSecond() const { return Seconds > 0.0 ? NumObjects / Seconds : 0.0; }
+	};
+
+	/** Settings parsed from the command line. */
+	struct FBenchmarkSettings
+	{
+		TArray<int32> Counts = {1, 100, 1000};
+		TArray<int32> Payloads = {0, 256, 4096};
+		int32 Iterations = 5;
+		FString JsonPath;
+		FString CsvPath;
+		FString WorkDir;
+	};
+
+	/**
+	 * Runs InBody InIterations times, keeps the best time and the allocations of the last run.
+	 * @return false if InBody failed.
+	 */
+	static bool MeasureBenchmark(int32 InIterations, FBenchmarkResult& OutResult, TFunctionRef<bool()> InBody)
+	{
+		OutResult.Iterations = InIterations;
+		OutResult.Seconds = MAX_dbl;
+		for (int32 i = 0; i < InIterations; ++i)
+		{
+			FScopedAllocationCounter counter;
+			const double start = FPlatformTime::Seconds();
+			const bool bResult = InBody();
+			const double seconds = FPlatformTime::Seconds() - start;
+			OutResult.NumAllocations = counter.GetNumAllocations();
+			OutResult.AllocatedBytes = counter.GetAllocatedBytes();
+			if (!bResult)
+				return false;
+			OutResult.Seconds = FMath::Min(OutResult.Seconds, seconds);
+		}
+		return true;
+	}
+
+	static void ParseIntList(const FString& InParams, const TCHAR* InKey, TArray<int32>& OutValues)
+	{
+		FString value;
+		if (!FParse::Value(*InParams, InKey, value))
+			return;
+
+		TArray<FString> items;
+		value.ParseIntoArray(items, TEXT(","));
+		OutValues.Reset();
+		for (const FString& item : items)
+		{
+			OutValues.Add(FMath::Max(0, FCString::Atoi(*item)));
+		}
+	}
+
+	static UDataSerializerBenchmarkObject* CreateBenchmarkObject(FRandomStream& InRandom, int32 InIndex, int32 InPayloadSize)
+	{
+		UDataSerializerBenchmarkObject* object = NewObject<UDataSerializerBenchmarkObject>(GetTransientPackage());
+		object->Id = InIndex;
+		object->Health = InRandom.FRandRange(0.f, 100.f);
+		object->Location = InRandom.GetUnitVector() * InRandom.FRandRange(0.f, 100000.f);
+		object->Rotation = FRotator(InRandom.FRandRange(-90.f, 90.f), InRandom.FRandRange(-180.f, 180.f), 0.f);
+		object->bAlive = InRandom.RandHelper(2) != 0;
+		object->Tag = FName(TEXT("Benchmark"), InIndex % 16);
+		object->DisplayName = FString::Printf(TEXT("BenchmarkObject_%d"), InIndex);
+		object->Payload.SetNumUninitialized(InPayloadSize);
+		for (uint8& byte : object->Payload)
+		{
+			// Low entropy, so compression has something to work with like real save data
+			byte = static_cast<uint8>(InRandom.RandHelper(16));
+		}
+		return object;
+	}
+
+	bool VerifyBenchmarkObjects(const TArray<UObject*>& InSources, const TArray<UObject*>& InLoaded)
+	{
+		if (InSources.Num() != InLoaded.Num())
+			return false;
+
+		for (int32 i = 0; i < InSources.Num(); ++i)
+		{
+			if (InLoaded[i] == nullptr || InLoaded[i] == InSources[i] || InLoaded[i]->GetClass() != InSources[i]->GetClass())
+				return false;
+
+			for (TFieldIterator<FProperty> it(InSources[i]->GetClass()); it; ++it)
+			{
+				if (it->HasAnyPropertyFlags(CPF_SaveGame) && !it->Identical_InContainer(InSources[i], InLoaded[i]))
+					return false;
+			}
+		}
+		return true;
+	}
+
+	static int64 GetTotalSize(const TArray<TArray<uint8>>& InBlobs)
+	{
+		int64 size = 0;
+		for (const TArray<uint8>& blob : InBlobs)
+		{
+			size += blob.Num();
+		}
+		return size;
+	}
+
+	/** Runner of the cases for one object count and payload size. */
+	class FBenchmarkRunner
+	{
+	public:
+		FBenchmarkRunner(const FBenchmarkSettings& InSettings, const TArray<UObject*>& InSources, int32 InPayloadSize,
+		                 TArray<FBenchmarkResult>& OutResults)
+			: Settings(InSettings), Sources(InSources), PayloadSize(InPayloadSize), Results(OutResults)
+		{
+		}
+
+		void Run()
+		{
+			RunSingleObjects();
+			RunBatch(TEXT("SerializeObjects"), false);
+			RunBatch(TEXT("SerializeObjectsWithSchema"), true);
+			RunCompressedFile();
+			RunPrimitives();
+		}
+
+	private:
+		FBenchmarkResult MakeResult(const TCHAR* InCase, const TCHAR* InOperation) const
+		{
+			FBenchmarkResult result;
+			result.Case = InCase;
+			result.Operation = InOperation;
+			result.NumObjects = Sources.Num();
+			result.PayloadSize = PayloadSize;
+			return result;
+		}
+
+		/** SerializeObject and DeSerializeObjectCpp, one blob per object. */
+		void RunSingleObjects()
+		{
+			TArray<TArray<uint8>> blobs;
+			blobs.SetNum(Sources.Num());
+			FBenchmarkResult write = MakeResult(TEXT("SerializeObject"), TEXT("Write"));
+			write.bVerified = MeasureBenchmark(Settings.Iterations, write, [&]()
+			{
+				for (int32 i = 0; i < Sources.Num(); ++i)
+				{
+					if (!UDataSerializerLib::SerializeObject(blobs[i], Sources[i]))
+						return false;
+				}
+				return true;
+			});
+			write.NumBytes = write.OutputSize = GetTotalSize(blobs);
+
+			TArray<UObject*> loaded;
+			FBenchmarkResult read = MakeResult(TEXT("SerializeObject"), TEXT("Read"));
+			read.bVerified = MeasureBenchmark(Settings.Iterations, read, [&]()
+			{
+				loaded.Reset();
+				for (const TArray<uint8>& blob : blobs)
+				{
+					FMemoryReader reader(blob, true);
+					UObject* object = nullptr;
+					if (!UDataSerializerLib::DeSerializeObjectCpp(reader, GetTransientPackage(), object))
+						return false;
+					loaded.Add(object);
+				}
+				return true;
+			}) && VerifyBenchmarkObjects(Sources, loaded);
+			read.NumBytes = read.OutputSize = write.OutputSize;
+			Results.Append({write, read});
+		}
+
+		/** SerializeObjects (or SerializeObjectsWithSchema) and DeSerializeObjectsCpp. */
+		void RunBatch(const TCHAR* InCase, bool bInSchema)
+		{
+			TArray<uint8> bytes;
+			FBenchmarkResult write = MakeResult(InCase, TEXT("Write"));
+			write.bVerified = MeasureBenchmark(Settings.Iterations, write, [&]()
+			{
+				if (bInSchema)
+					return UDataSerializerLib::SerializeObjectsWithSchema(bytes, Sources);
+				return UDataSerializerLib::SerializeObjects(bytes, Sources);
+			});
+			write.NumBytes = write.OutputSize = bytes.Num();
+
+			TArray<UObject*> loaded;
+			FBenchmarkResult read = MakeResult(InCase, TEXT("Read"));
+			read.bVerified = MeasureBenchmark(Settings.Iterations, read, [&]()
+			{
+				loaded.Reset();
+				FMemoryReader reader(bytes, true);
+				return UDataSerializerLib::DeSerializeObjectsCpp(reader, GetTransientPackage(), loaded);
+			}) && VerifyBenchmarkObjects(Sources, loaded);
+			read.NumBytes = read.OutputSize = bytes.Num();
+			Results.Append({write, read});
+
+			if (!bInSchema)
+			{
+				BatchBytes = MoveTemp(bytes);
+			}
+		}
+
+		/** WriteBytesToDiskCompressed and ReadCompressedBytesFromDisk on the SerializeObjects bytes. */
+		void RunCompressedFile()
+		{
+			const FString path = FPaths::Combine(Settings.WorkDir,
+			                                     FString::Printf(TEXT("Benchmark_%d_%d.sav"), Sources.Num(), PayloadSize));
+
+			FBenchmarkResult write = MakeResult(TEXT("WriteBytesToDiskCompressed"), TEXT("Write"));
+			write.bVerified = MeasureBenchmark(Settings.Iterations, write, [&]()
+			{
+				return UDataSerializerLib::WriteBytesToDiskCompressed(BatchBytes, path);
+			});
+			const int64 fileSize = IFileManager::Get().FileSize(*path);
+			write.NumBytes = BatchBytes.Num();
+			write.OutputSize = fileSize;
+			write.CompressionRatio = fileSize > 0 ? static_cast<double>(BatchBytes.Num()) / fileSize : 0.0;
+
+			TArray<uint8> bytes;
+			FBenchmarkResult read = MakeResult(TEXT("WriteBytesToDiskCompressed"), TEXT("Read"));
+			read.bVerified = MeasureBenchmark(Settings.Iterations, read, [&]()
+			{
+				return UDataSerializerLib::ReadCompressedBytesFromDisk(bytes, path);
+			}) && bytes == BatchBytes;
+			read.NumBytes = BatchBytes.Num();
+			read.OutputSize = fileSize;
+			read.CompressionRatio = write.CompressionRatio;
+			Results.Append({write, read});
+
+			IFileManager::Get().Delete(*path);
+		}
+
+		/** USerializerObject and UDeSerializerObject primitives, the benchmark object fields one by one. */
+		void RunPrimitives()
+		{
+			USerializerObject* serializer = NewObject<USerializerObject>();
+			TArray<uint8> bytes;
+			FBenchmarkResult write = MakeResult(TEXT("SerializerObject"), TEXT("Write"));
+			write.bVerified = MeasureBenchmark(Settings.Iterations, write, [&]()
+			{
+				serializer->Reset();
+				for (UObject* source : Sources)
+				{
+					const UDataSerializerBenchmarkObject* object = CastChecked<UDataSerializerBenchmarkObject>(source);
+					serializer->SerializeInt(object->Id);
+					serializer->SerializeFloat(object->Health);
+					serializer->SerializeVector(object->Location);
+					serializer->SerializeRotator(object->Rotation);
+					serializer->SerializeBool(object->bAlive);
+					serializer->SerializeString(object->DisplayName);
+					serializer->SerializeByteArray(object->Payload);
+				}
+				return true;
+			});
+			serializer->GetBytes(bytes);
+			write.NumBytes = write.OutputSize = bytes.Num();
+
+			UDeSerializerObject* deserializer = NewObject<UDeSerializerObject>();
+			bool bMatches = true;
+			FBenchmarkResult read = MakeResult(TEXT("SerializerObject"), TEXT("Read"));
+			read.bVerified = MeasureBenchmark(Settings.Iterations, read, [&]()
+			{
+				deserializer->StartView(bytes);
+				int32 id = 0;
+				float health = 0.f;
+				FVector location;
+				FRotator rotation;
+				bool bAlive = false;
+				FString name;
+				TArray<uint8> payload;
+				bMatches = true;
+				for (UObject* source : Sources)
+				{
+					const UDataSerializerBenchmarkObject* object = CastChecked<UDataSerializerBenchmarkObject>(source);
+					if (!deserializer->TryReadInt(id) || !deserializer->TryReadFloat(health)
+						|| !deserializer->TryReadVector(location) || !deserializer->TryReadRotator(rotation)
+						|| !deserializer->TryReadBool(bAlive) || !deserializer->TryReadString(name)
+						|| !deserializer->TryReadUInt8Array(payload))
+						return false;
+
+					bMatches &= id == object->Id && health == object->Health && location == object->Location
+						&& rotation == object->Rotation && bAlive == object->bAlive && name == object->DisplayName
+						&& payload == object->Payload;
+				}
+				return true;
+			}) && bMatches;
+			read.NumBytes = read.OutputSize = bytes.Num();
+			Results.Append({write, read});
+		}
+
+		const FBenchmarkSettings& Settings;
+		const TArray<UObject*>& Sources;
+		int32 PayloadSize = 0;
+		TArray<FBenchmarkResult>& Results;
+
+		/** Output of SerializeObjects, input of the file cases. */
+		TArray<uint8> BatchBytes;
+	};
+
+	static FString ToJson(const TArray<FBenchmarkResult>& InResults)
+	{
+		FString json = TEXT("{\n\t\"engine\": \"") + FEngineVersion::Current().ToString() + TEXT("\",\n\t\"results\": [\n");
+		for (int32 i = 0; i < InResults.Num(); ++i)
+		{
+			const FBenchmarkResult& result = InResults[i];
+			json += FString::Printf(
+				TEXT("\t\t{\"case\": \"%s\", \"operation\": \"%s\", \"objects\": %d, \"payload\": %d, \"iterations\": %d, ")
+				TEXT("\"seconds\": %.9f, \"mbPerSecond\": %.3f, \"opsPerSecond\": %.3f, \"allocations\": %llu, ")
+				TEXT("\"allocatedBytes\": %llu, \"outputBytes\": %lld, \"compressionRatio\": %.4f, \"verified\": %s}%s\n"),
+				*result.Case, *result.Operation, result.NumObjects, result.PayloadSize, result.Iterations, result.Seconds,
+				result.GetMegabytesPerSecond(), result.GetOpsPerSecond(), result.NumAllocations, result.AllocatedBytes,
+				result.OutputSize, result.CompressionRatio, result.bVerified ? TEXT("true") : TEXT("false"),
+				i + 1 < InResults.Num() ? TEXT(",") : TEXT(""));
+		}
+		json += TEXT("\t]\n}\n");
+		return json;
+	}
+
+	static FString ToCsv(const TArray<FBenchmarkResult>& InResults)
+	{
+		FString csv = TEXT("Case,Operation,Objects,Payload,Iterations,Seconds,MBPerSecond,OpsPerSecond,Allocations,")
+			TEXT("AllocatedBytes,OutputBytes,CompressionRatio,Verified\n");
+		for (const FBenchmarkResult& result : InResults)
+		{
+			csv += FString::Printf(TEXT("%s,%s,%d,%d,%d,%.9f,%.3f,%.3f,%llu,%llu,%lld,%.4f,%d\n"),
+			                       *result.Case, *result.Operation, result.NumObjects, result.PayloadSize,
+			                       result.Iterations, result.Seconds, result.GetMegabytesPerSecond(),
+			                       result.GetOpsPerSecond(), result.NumAllocations, result.AllocatedBytes,
+			                       result.OutputSize, result.CompressionRatio, result.bVerified ? 1 : 0);
+		}
+		return csv;
+	}
+}
+
+UDataSerializerBenchmarkCommandlet::UDataSerializerBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UDataSerializerBenchmarkCommandlet::Main(const FString& Params)
+{
+	Serializer::FBenchmarkSettings settings;
+	Serializer::ParseIntList(Params, TEXT("Counts="), settings.Counts);
+	Serializer::ParseIntList(Params, TEXT("Payloads="), settings.Payloads);
+	FParse::Value(*Params, TEXT("Iterations="), settings.Iterations);
+	settings.Iterations = FMath::Max(1, settings.Iterations);
+	settings.WorkDir = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("DataSerializerBenchmark"));
+	settings.JsonPath = FPaths::Combine(settings.WorkDir, TEXT("Results.json"));
+	settings.CsvPath = FPaths::Combine(settings.WorkDir, TEXT("Results.csv"));
+	FParse::Value(*Params, TEXT("Json="), settings.JsonPath);
+	FParse::Value(*Params, TEXT("Csv="), settings.CsvPath);
+	IFileManager::Get().MakeDirectory(*settings.WorkDir, true);
+
+	TArray<Serializer::FBenchmarkResult> results;
+	for (const int32 count : settings.Counts)
+	{
+		for (const int32 payloadSize : settings.Payloads)
+		{
+			// Same data on every run, so results can be compared across versions
+			FRandomStream random(count * 7919 + payloadSize);
+			TArray<UObject*> sources;
+			sources.Reserve(count);
+			for (int32 i = 0; i < count; ++i)
+			{
+				UObject* source = Serializer::CreateBenchmarkObject(random, i, payloadSize);
+				source->AddToRoot();
+				sources.Add(source);
+			}
+
+			Serializer::FBenchmarkRunner runner(settings, sources, payloadSize, results);
+			runner.Run();
+
+			for (UObject* source : sources)
+			{
+				source->RemoveFromRoot();
+			}
+			CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+		}
+	}
+
+	bool bVerified = true;
+	for (const Serializer::FBenchmarkResult& result : results)
+	{
+		bVerified &= result.bVerified;
+		UE_LOG(LogDataSerializerBenchmark, Display,
+		       TEXT("%-28s %-5s objects=%-6d payload=%-6d %10.2f MB/s %12.1f ops/s allocs=%-8llu size=%-10lld ratio=%.2f%s"),
+		       *result.Case, *result.Operation, result.NumObjects, result.PayloadSize, result.GetMegabytesPerSecond(),
+		       result.GetOpsPerSecond(), result.NumAllocations, result.OutputSize, result.CompressionRatio,
+		       result.bVerified ? TEXT("") : TEXT(" FAILED"));
+	}
+
+	FFileHelper::SaveStringToFile(Serializer::ToJson(results), *settings.JsonPath);
+	FFileHelper::SaveStringToFile(Serializer::ToCsv(results), *settings.CsvPath);
+	return bVerified ? 0 : 1;
+}